@@ -1,1374 +1,4082 @@
-#include <iostream>         // cout, cerr
-#include <cstdlib>          // EXIT_FAILURE
-#include <GL/glew.h>        // GLEW library
-#include <GLFW/glfw3.h>     // GLFW library
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"      // Image loading Utility functions
-
-// GLM Math Header inclusions
-#include <glm/glm.hpp>
-#include <glm/gtx/transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
-
-#include "camera.h" // Camera class
-
-using namespace std; // Standard namespace
-
-/*Shader program Macro*/
-#ifndef GLSL
-#define GLSL(Version, Source) "#version " #Version " core \n" #Source
-#endif
-
-// Unnamed namespace
-namespace
-{
-    const char* const WINDOW_TITLE = "Final Project"; // Macro for window title
-
-    // Variables for window width and height
-    const int WINDOW_WIDTH = 800;
-    const int WINDOW_HEIGHT = 600;
-
-    // Stores the GL data relative to a given mesh
-    struct GLMesh
-    {
-        GLuint vao;         // Handle for the vertex array object
-        GLuint vbos[2];         // Handle for the vertex buffer objects
-        GLuint nVertices;    // Number of indices of the mesh
-    };
-
-    // Main GLFW window
-    GLFWwindow* gWindow = nullptr;
-    // Triangle mesh data
-    GLMesh gMesh;
-    // Texture id
-    GLuint gTextureGlassId;
-    GLuint gTextureSilverId;
-    GLuint gTextureFloorId;
-    GLuint gTextureBottleId;
-    glm::vec2 gUVScale(5.0f, 5.0f);
-    // Shader program
-    GLuint gProgramId;
-    GLuint gLampProgramId;
-
-    // camera
-    Camera gCamera(glm::vec3(0.0f, 0.0f, 3.0f));
-    float gLastX = WINDOW_WIDTH / 2.0f;
-    float gLastY = WINDOW_HEIGHT / 2.0f;
-    bool gFirstMouse = true;
-
-    // timing
-    float gDeltaTime = 0.0f; // time between current frame and last frame
-    float gLastFrame = 0.0f;
-
-    //Object Color and Light Color
-    glm::vec3 gObjectColor(1.f, 0.2f, 0.0f);
-    glm::vec3 gLightColor(1.0f, 1.0f, 1.0f);
-    glm::vec3 gLightColor2(0.0f, 1.0f, 0.0f);
-}
-// Light position and scale
-glm::vec3 gLightPosition(1.5f, 4.5f, 3.0f);
-glm::vec3 gLightScale(0.3f);
-glm::vec3 gLightPosition2(1.5f, 4.5f, 3.0f);
-glm::vec3 gLightScale2(0.3f);
-
-/* User-defined Function prototypes to:
- * initialize the program, set the window size,
- * redraw graphics on the window when resized,
- * and render graphics on the screen
- */
-bool UInitialize(int, char* [], GLFWwindow** window);
-void UResizeWindow(GLFWwindow* window, int width, int height);
-void UProcessInput(GLFWwindow* window);
-void UMousePositionCallback(GLFWwindow* window, double xpos, double ypos);
-void UMouseScrollCallback(GLFWwindow* window, double xoffset, double yoffset);
-void UMouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
-void UCreateMesh(GLMesh& mesh);
-void UDestroyMesh(GLMesh& mesh);
-bool UCreateTexture(const char* filename, GLuint& textureId);
-void UDestroyTexture(GLuint textureId);
-void URender();
-bool UCreateShaderProgram(const char* vtxShaderSource, const char* fragShaderSource, GLuint& programId);
-void UDestroyShaderProgram(GLuint programId);
-bool viewProjection = true;
-
-
-/* Vertex Shader Source Code*/
-const GLchar* vertexShaderSource = GLSL(440,
-    layout(location = 0) in vec3 position; //Vertex data
-layout(location = 1) in vec3 normal;  //Light data
-layout(location = 2) in vec2 textureCoordinate;  //Texture data
-
-out vec3 vertexNormal; // For outgoing normals to fragment shader
-out vec3 vertexFragmentPos; // For outgoing color / pixels to fragment shader
-out vec2 vertexTextureCoordinate;
-
-
-//Global variables for the transform matrices
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-
-
-void main()
-{
-    gl_Position = projection * view * model * vec4(position, 1.0f); // transforms vertices to clip coordinates
-    vertexTextureCoordinate = textureCoordinate;
-
-    vertexFragmentPos = vec3(model * vec4(position, 1.0f)); // Gets fragment / pixel position in world space only (exclude view and projection)
-
-    vertexNormal = mat3(transpose(inverse(model))) * normal; // get normal vectors in world space only and exclude normal translation properties
-    vertexTextureCoordinate = textureCoordinate;
-}
-);
-
-
-/* Fragment Shader Source Code*/
-const GLchar* fragmentShaderSource = GLSL(440,
-    in vec3 vertexNormal; // For incoming normals
-in vec3 vertexFragmentPos; // For incoming fragment position
-in vec2 vertexTextureCoordinate;
-
-out vec4 fragmentColor;
-
-// Uniform / Global variables for object color, light color, light position, and camera/view position
-uniform vec3 objectColor;
-uniform vec3 lightColor;
-uniform vec3 lightPos;
-uniform vec3 lightColor2;
-uniform vec3 lightPos2;
-uniform vec3 viewPosition;
-uniform sampler2D uTexture;
-uniform vec2 uvScale;
-
-void main()
-{
-    /*Phong lighting model calculations to generate ambient, diffuse, and specular components*/
-
-        //Calculate Ambient lighting*/
-    float ambientStrength = 0.1f; // Set ambient or global lighting strength
-    vec3 ambient = ambientStrength * lightColor; // Generate ambient light color
-
-    //Calculate Diffuse lighting*/
-    vec3 norm = normalize(vertexNormal); // Normalize vectors to 1 unit
-    vec3 lightDirection = normalize(lightPos - vertexFragmentPos); // Calculate distance (light direction) between light source and fragments/pixels on cube
-    float impact = max(dot(norm, lightDirection), 0.0);// Calculate diffuse impact by generating dot product of normal and light
-    vec3 diffuse = impact * lightColor; // Generate diffuse light color
-
-    //Calculate Specular lighting*/
-    float specularIntensity = 0.8f; // Set specular light strength
-    float highlightSize = 16.0f; // Set specular highlight size
-    vec3 viewDir = normalize(viewPosition - vertexFragmentPos); // Calculate view direction
-    vec3 reflectDir = reflect(-lightDirection, norm);// Calculate reflection vector
-    //Calculate specular component
-    float specularComponent = pow(max(dot(viewDir, reflectDir), 0.0), highlightSize);
-    vec3 specular = specularIntensity * specularComponent * lightColor;
-
-    // Texture holds the color to be used for all three components
-    vec4 textureColor = texture(uTexture, vertexTextureCoordinate * uvScale);
-
-    // Calculate phong result
-    vec3 phong = (ambient + diffuse + specular) * textureColor.xyz;
-
-    fragmentColor = vec4(phong, 1.0); // Send lighting results to GPU
-
-     //Calculate Ambient lighting*/
-    float ambientStrength2 = 0.1f; // Set ambient or global lighting strength
-    vec3 ambient2 = ambientStrength2 * lightColor2; // Generate ambient light color
-
-    //Calculate Diffuse lighting*/
-    vec3 norm2 = normalize(vertexNormal); // Normalize vectors to 1 unit
-    vec3 lightDirection2 = normalize(lightPos2 - vertexFragmentPos); // Calculate distance (light direction) between light source and fragments/pixels on cube
-    float impact2 = max(dot(norm2, lightDirection2), 0.0);// Calculate diffuse impact by generating dot product of normal and light
-    vec3 diffuse2 = impact2 * lightColor2; // Generate diffuse light color
-
-    //Calculate Specular lighting*/
-    float specularIntensity2 = 0.1f; // Set specular light strength
-    float highlightSize2 = 16.0f; // Set specular highlight size
-    vec3 viewDir2 = normalize(viewPosition - vertexFragmentPos); // Calculate view direction
-    vec3 reflectDir2 = reflect(-lightDirection2, norm);// Calculate reflection vector
-    //Calculate specular component
-    float specularComponent2 = pow(max(dot(viewDir2, reflectDir2), 0.0), highlightSize2);
-    vec3 specular2 = specularIntensity2 * specularComponent2 * lightColor2;
-
-    // Texture holds the color to be used for all three components
-    vec4 textureColor2 = texture(uTexture, vertexTextureCoordinate * uvScale);
-
-    // Calculate phong result
-    vec3 phong2 = (ambient2 + diffuse2 + specular2) * textureColor2.xyz;
-
-    fragmentColor = vec4(phong + phong2, 1.0); // Send lighting results to GPU
-}
-);
-
-/* Lamp Shader Source Code*/
-const GLchar* lampVertexShaderSource = GLSL(440,
-
-    layout(location = 0) in vec3 position; // VAP position 0 for vertex position data
-
-        //Uniform / Global variables for the  transform matrices
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-
-void main()
-{
-    gl_Position = projection * view * model * vec4(position, 1.0f); // Transforms vertices into clip coordinates
-}
-);
-
-
-/* Fragment Shader Source Code*/
-const GLchar* lampFragmentShaderSource = GLSL(440,
-
-    out vec4 fragmentColor; // For outgoing lamp color (smaller cube) to the GPU
-
-void main()
-{
-    fragmentColor = vec4(1.0f); // Set color to white (1.0f,1.0f,1.0f) with alpha 1.0
-}
-);
-
-
-// Images are loaded with Y axis going down, but OpenGL's Y axis goes up, so let's flip it
-void flipImageVertically(unsigned char* image, int width, int height, int channels)
-{
-    for (int j = 0; j < height / 2; ++j)
-    {
-        int index1 = j * width * channels;
-        int index2 = (height - 1 - j) * width * channels;
-
-        for (int i = width * channels; i > 0; --i)
-        {
-            unsigned char tmp = image[index1];
-            image[index1] = image[index2];
-            image[index2] = tmp;
-            ++index1;
-            ++index2;
-        }
-    }
-}
-
-
-int main(int argc, char* argv[])
-{
-    if (!UInitialize(argc, argv, &gWindow))
-        return EXIT_FAILURE;
-
-    // Create the mesh
-    UCreateMesh(gMesh); // Calls the function to create the Vertex Buffer Object
-
-    // Create the shader program
-    if (!UCreateShaderProgram(vertexShaderSource, fragmentShaderSource, gProgramId))
-        return EXIT_FAILURE;
-
-    // Load texture
-    const char* texFilename = "../../Final Project/resources/textures/glass.jpg";
-    if (!UCreateTexture(texFilename, gTextureGlassId))
-    {
-        cout << "Failed to load texture " << texFilename << endl;
-        return EXIT_FAILURE;
-    }
-    texFilename = "../../Final Project/resources/textures/silver.jpg";
-    if (!UCreateTexture(texFilename, gTextureSilverId))
-    {
-        cout << "Failed to load texture " << texFilename << endl;
-        return EXIT_FAILURE;
-    }
-    texFilename = "../../Final Project/resources/textures/floor.png";
-    if (!UCreateTexture(texFilename, gTextureFloorId))
-    {
-        cout << "Failed to load texture " << texFilename << endl;
-        return EXIT_FAILURE;
-    }
-    texFilename = "../../Final Project/resources/textures/galaxy.jpg";
-    if (!UCreateTexture(texFilename, gTextureBottleId))
-    {
-        cout << "Failed to load texture " << texFilename << endl;
-        return EXIT_FAILURE;
-    }
-
-    // tell opengl for each sampler to which texture unit it belongs to (only has to be done once)
-    glUseProgram(gProgramId);
-    // We set the texture as texture unit 0
-    glUniform1i(glGetUniformLocation(gProgramId, "uTexture"), 0);
-
-    // Sets the background color of the window to black (it will be implicitely used by glClear)
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-
-    // render loop
-    // -----------
-    while (!glfwWindowShouldClose(gWindow))
-    {
-        // per-frame timing
-        // --------------------
-        float currentFrame = glfwGetTime();
-        gDeltaTime = currentFrame - gLastFrame;
-        gLastFrame = currentFrame;
-
-        // input
-        // -----
-        UProcessInput(gWindow);
-
-        // Render this frame
-        URender();
-
-        glfwPollEvents();
-    }
-
-    // Release mesh data
-    UDestroyMesh(gMesh);
-
-    // Release texture
-    UDestroyTexture(gTextureGlassId);
-    UDestroyTexture(gTextureSilverId);
-    UDestroyTexture(gTextureFloorId);
-
-    // Release shader program
-    UDestroyShaderProgram(gProgramId);
-    UDestroyShaderProgram(gLampProgramId);
-
-    exit(EXIT_SUCCESS); // Terminates the program successfully
-}
-
-
-// Initialize GLFW, GLEW, and create a window
-bool UInitialize(int argc, char* argv[], GLFWwindow** window)
-{
-    // GLFW: initialize and configure
-    // ------------------------------
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 4);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-#ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-#endif
-
-    // GLFW: window creation
-    // ---------------------
-    * window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_TITLE, NULL, NULL);
-    if (*window == NULL)
-    {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return false;
-    }
-    glfwMakeContextCurrent(*window);
-    glfwSetFramebufferSizeCallback(*window, UResizeWindow);
-    glfwSetCursorPosCallback(*window, UMousePositionCallback);
-    glfwSetScrollCallback(*window, UMouseScrollCallback);
-    glfwSetMouseButtonCallback(*window, UMouseButtonCallback);
-
-    // tell GLFW to capture our mouse
-    glfwSetInputMode(*window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-
-    // GLEW: initialize
-    // ----------------
-    // Note: if using GLEW version 1.13 or earlier
-    glewExperimental = GL_TRUE;
-    GLenum GlewInitResult = glewInit();
-
-    if (GLEW_OK != GlewInitResult)
-    {
-        std::cerr << glewGetErrorString(GlewInitResult) << std::endl;
-        return false;
-    }
-
-    // Displays GPU OpenGL version
-    cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << endl;
-
-    return true;
-}
-
-
-// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
-void UProcessInput(GLFWwindow* window)
-{
-    static const float cameraSpeed = 2.5f;
-
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-        glfwSetWindowShouldClose(window, true);
-
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-        gCamera.ProcessKeyboard(FORWARD, gDeltaTime);
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-        gCamera.ProcessKeyboard(BACKWARD, gDeltaTime);
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-        gCamera.ProcessKeyboard(LEFT, gDeltaTime);
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-        gCamera.ProcessKeyboard(RIGHT, gDeltaTime);
-
-    //Controls up and down movement
-    if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
-        gCamera.ProcessKeyboard(DOWN, gDeltaTime);
-    if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
-        gCamera.ProcessKeyboard(UP, gDeltaTime);
-
-    //Change projections between ortho and perspective
-    //if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS)
-        //changeProjection = !changeProjection;
-}
-
-
-// glfw: whenever the window size changed (by OS or user resize) this callback function executes
-void UResizeWindow(GLFWwindow* window, int width, int height)
-{
-    glViewport(0, 0, width, height);
-}
-
-
-// glfw: whenever the mouse moves, this callback is called
-// -------------------------------------------------------
-void UMousePositionCallback(GLFWwindow* window, double xpos, double ypos)
-{
-    if (gFirstMouse)
-    {
-        gLastX = xpos;
-        gLastY = ypos;
-        gFirstMouse = false;
-    }
-
-    float xoffset = xpos - gLastX;
-    float yoffset = gLastY - ypos; // reversed since y-coordinates go from bottom to top
-
-    gLastX = xpos;
-    gLastY = ypos;
-
-    gCamera.ProcessMouseMovement(xoffset, yoffset);
-}
-
-
-// glfw: whenever the mouse scroll wheel scrolls, this callback is called
-// ----------------------------------------------------------------------
-void UMouseScrollCallback(GLFWwindow* window, double xoffset, double yoffset)
-{
-    gCamera.ProcessMouseScroll(yoffset);
-    if (gCamera.MovementSpeed < 2.5f)
-        gCamera.MovementSpeed = 2.5f;
-
-    // If wheel is scrolled forward to speed up the camera the speed at which the camera moves is capped at 10.0f
-    if (gCamera.MovementSpeed > 10.0f)
-        gCamera.MovementSpeed = 10.0f;
-}
-
-// glfw: handle mouse button events
-// --------------------------------
-void UMouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
-{
-    switch (button)
-    {
-    case GLFW_MOUSE_BUTTON_LEFT:
-    {
-        if (action == GLFW_PRESS)
-            cout << "Left mouse button pressed" << endl;
-        else
-            cout << "Left mouse button released" << endl;
-    }
-    break;
-
-    case GLFW_MOUSE_BUTTON_MIDDLE:
-    {
-        if (action == GLFW_PRESS)
-            cout << "Middle mouse button pressed" << endl;
-        else
-            cout << "Middle mouse button released" << endl;
-    }
-    break;
-
-    case GLFW_MOUSE_BUTTON_RIGHT:
-    {
-        if (action == GLFW_PRESS)
-            cout << "Right mouse button pressed" << endl;
-        else
-            cout << "Right mouse button released" << endl;
-    }
-    break;
-
-    default:
-        cout << "Unhandled mouse button event" << endl;
-        break;
-    }
-}
-
-
-// Functioned called to render a frame
-void URender()
-{
-    // Enable z-depth
-    glEnable(GL_DEPTH_TEST);
-
-    // Clear the frame and z buffers
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-    // 1. Scales the object by 2
-    glm::mat4 scale = glm::scale(glm::vec3(2.0f, 2.0f, 2.0f));
-    // 2. Rotates shape by 15 degrees in the x axis
-    glm::mat4 rotation = glm::rotate(45.0f, glm::vec3(1.0, 1.0f, 1.0f));
-    // 3. Place object at the origin
-    glm::mat4 translation = glm::translate(glm::vec3(0.0f, 0.0f, 0.0f));
-    // Model matrix: transformations are applied right-to-left order
-    glm::mat4 model = translation * rotation * scale;
-
-    // camera/view transformation
-    glm::mat4 view = gCamera.GetViewMatrix();
-
-    // Creates a perspective projection
-    glm::mat4 projection = glm::perspective(glm::radians(gCamera.Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
-
-    //Switch between ortho and perspective projections
-    /*glm::mat4 projection;
-        if (changeProjection) {
-            glm::mat4 projection = glm::perspective(glm::radians(gCamera.Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
-        }
-        else {
-            glm::mat4 projection = glm::ortho(-5.0f, 5.0f, -5.0f, 5.0f, 0.1f, 100.0f);
-        }*/
-
-        // Set the shader to be used
-    glUseProgram(gProgramId);
-
-    // Retrieves and passes transform matrices to the Shader program
-    GLint modelLoc = glGetUniformLocation(gProgramId, "model");
-    GLint viewLoc = glGetUniformLocation(gProgramId, "view");
-    GLint projLoc = glGetUniformLocation(gProgramId, "projection");
-
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-
-    // Reference matrix uniforms from the Cube Shader program for the cub color, light color, light position, and camera position
-    GLint objectColorLoc = glGetUniformLocation(gProgramId, "objectColor");
-    GLint lightColorLoc = glGetUniformLocation(gProgramId, "lightColor");
-    GLint lightPositionLoc = glGetUniformLocation(gProgramId, "lightPos");
-    GLint lightColorLoc2 = glGetUniformLocation(gProgramId, "lightColor2");
-    GLint lightPositionLoc2 = glGetUniformLocation(gProgramId, "lightPos2");
-    GLint viewPositionLoc = glGetUniformLocation(gProgramId, "viewPosition");
-
-    // Pass color, light, and camera data to the Cube Shader program's corresponding uniforms
-    glUniform3f(objectColorLoc, gObjectColor.r, gObjectColor.g, gObjectColor.b);
-    glUniform3f(lightColorLoc, gLightColor.r, gLightColor.g, gLightColor.b);
-    glUniform3f(lightPositionLoc, gLightPosition.x, gLightPosition.y, gLightPosition.z);
-    glUniform3f(lightColorLoc2, gLightColor2.r, gLightColor2.g, gLightColor2.b);
-    glUniform3f(lightPositionLoc2, gLightPosition2.x, gLightPosition2.y, gLightPosition2.z);
-    const glm::vec3 cameraPosition = gCamera.Position;
-    glUniform3f(viewPositionLoc, cameraPosition.x, cameraPosition.y, cameraPosition.z);
-
-    GLint UVScaleLoc = glGetUniformLocation(gProgramId, "uvScale");
-    glUniform2fv(UVScaleLoc, 1, glm::value_ptr(gUVScale));
-
-    // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(gMesh.vao);
-
-    // bind textures on corresponding texture units for glass
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTextureFloorId);
-
-    // Draws the triangles for plane
-    glDrawArrays(GL_TRIANGLES, 1, gMesh.nVertices);
-
-    // bind textures on corresponding texture units for lid
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTextureSilverId);
-
-    // Draws the triangles for cylinder
-    glDrawArrays(GL_TRIANGLES, 7, gMesh.nVertices);
-
-    // bind textures on corresponding texture units for glass
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTextureGlassId);
-
-    // Draws the triangles for plane
-    glDrawArrays(GL_TRIANGLES, 31, gMesh.nVertices);
-
-    // bind textures on corresponding texture units for bottle
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTextureBottleId);
-
-    // Draws the triangles for plane
-    glDrawArrays(GL_TRIANGLES, 67, gMesh.nVertices);
-
-    // LAMP: draw lamp
-    //----------------
-    glUseProgram(gLampProgramId);
-
-    // Reference matrix uniforms from the Lamp Shader program
-    modelLoc = glGetUniformLocation(gLampProgramId, "model");
-    viewLoc = glGetUniformLocation(gLampProgramId, "view");
-    projLoc = glGetUniformLocation(gLampProgramId, "projection");
-
-    // Pass matrix data to the Lamp Shader program's matrix uniforms
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-
-    glDrawArrays(GL_TRIANGLES, 0, gMesh.nVertices);
-
-    // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
-
-    // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
-    glfwSwapBuffers(gWindow);    // Flips the the back buffer with the front buffer every frame.
-}
-
-
-// Implements the UCreateMesh function
-void UCreateMesh(GLMesh& mesh)
-{
-    // Vertex data
-    GLfloat verts[] = {
-        // Vertex Positions    // Normals       //Texture Coords.
-        //Plane - Floor
-        -10.0f, -0.5f,-10.0f,   0.0f, 1.0f, 0.0f,   0.0f, 0.0f, //Bottom Left Vertex 1
-         10.0f, -0.5f, 10.0f,   0.0f, 1.0f, 0.0f,   0.0f, 1.0f, //Bottom Right Vertex 2
-         10.0f, -0.5f, 10.0f,   0.0f, 1.0f, 0.0f,   1.0f, 0.0f, //Top Right Vertex 3 
-        -10.0f, -0.5f, 10.0f,   0.0f, 1.0f, 0.0f,   0.0f, 1.0f, //Top Left Vertex 4
-
-        //Jar Lid Cylinder
-        //Bottom Circle
-        //Triangle 1
-        0.4f,  1.5f, 0.0f,   0.0f,-1.0f, 0.0f,     0.0f, 0.0f, //Center Bottom 9
-        0.35f, 1.5f, 0.05f,  0.0f,-1.0f, 0.0f,     1.0f, 0.0f, //Bottom Left Back 10
-        0.33f, 1.5f, 0.0f,   0.0f,-1.0f, 0.0f,     0.0f, 1.0f, //Bottom Left 11
-
-        //Triangle 2
-        0.4f, 1.5f, 0.0f,    0.0f,-1.0f, 0.0f,     0.0f, 0.0f, //Center Bottom 9
-        0.4f, 1.5f, 0.06f,   0.0f,-1.0f, 0.0f,     1.0f, 0.0f, //Bottom Center Back 12
-        0.35f,1.5f, 0.05f,   0.0f,-1.0f, 0.0f,     0.0f, 1.0f, //Bottom Left Back 10
-
-        //Triangle 3
-        0.4f, 1.5f, 0.0f,     0.0f,-1.0f, 0.0f,    0.0f, 0.0f, //Center Bottom 9
-        0.55f, 1.5f, 0.05f,   0.0f,-1.0f, 0.0f,    1.0f, 0.0f, //Bottom Right Back 13
-        0.4f, 1.5f, 0.06f,    0.0f,-1.0f, 0.0f,    0.0f, 1.0f, //Bottom Center Back 12
-
-        //Triangle 4
-         0.4f, 1.5f, 0.0f,     0.0f,-1.0f, 0.0f,   0.0f, 0.0f, //Center Bottom 9
-         0.57f, 1.5f, 0.0f,    0.0f,-1.0f, 0.0f,   1.0f, 0.0f, //Bottom Right 14
-         0.55f, 1.5f, 0.05f,   0.0f,-1.0f, 0.0f,   0.0f, 1.0f, //Bottom Right Back 13
-
-        //Triangle 5
-         0.4f, 1.5f, 0.0f,     0.0f,-1.0f, 0.0f,   0.0f, 0.0f, //Center Bottom 9
-         0.55f, 1.5f, -0.05f,  0.0f,-1.0f, 0.0f,   1.0f, 0.0f, //Bottom Right Front 15
-         0.57f, 1.5f, 0.0f,    0.0f,-1.0f, 0.0f,   0.0f, 1.0f, //Bottom Right 14
-
-        //Triangle 6
-         0.4f, 1.5f, 0.0f,     0.0f,-1.0f, 0.0f,   0.0f, 0.0f, //Center Bottom 9
-         0.4f, 1.5f, -0.04f,   0.0f,-1.0f, 0.0f,   1.0f, 0.0f, //Bottom Center Front 16
-         0.55f, 1.5f, -0.05f,  0.0f,-1.0f, 0.0f,   0.0f, 1.0f, //Bottom Right Front 15
-
-        //Triangle 7
-         0.4f, 1.5f, 0.0f,     0.0f,-1.0f, 0.0f,   0.0f, 0.0f, //Center Bottom 9
-         0.35, 1.5f, -0.05f,   0.0f,-1.0f, 0.0f,   1.0f, 0.0f, //Bottom Left Front 8
-         0.4f, 1.5f, -0.04f,   0.0f,-1.0f, 0.0f,   0.0f, 1.0f, //Bottom Center Front 16
-
-        //Triangle 8
-         0.4f, 1.5f, 0.0f,     0.0f,-1.0f, 0.0f,   0.0f, 0.0f, //Center Bottom 9
-         0.33f, 1.5f, 0.0f,    0.0f,-1.0f, 0.0f,   1.0f, 0.0f, //Bottom Left 11
-         0.35f, 1.5f, 0.05f,   0.0f,-1.0f, 0.0f,   0.0f, 1.0f, //Bottom Left Front 10
-
-        //Top Circle
-        //Triangle 1
-        0.4f, 2.0f, 0.0f,    0.0f, 1.0f, 0.0f,     0.0f, 0.0f, //Center Top 17
-        0.35f, 2.0f, 0.05f,  0.0f, 1.0f, 0.0f,     1.0f, 0.0f, //Top Left Back 18
-        0.33f, 2.0f, 0.0f,   0.0f, 1.0f, 0.0f,     0.0f, 1.0f, //Top Left 19
-
-        //Triangle 2
-        0.4f, 2.0f, 0.0f,     0.0f, 1.0f, 0.0f,    0.0f, 0.0f, //Center Top 17
-        0.4f, 2.0f, 0.06f,    0.0f, 1.0f, 0.0f,    1.0f, 0.0f, //Top Center Back 20
-        0.35f, 2.0f, 0.05f,   0.0f, 1.0f, 0.0f,    0.0f, 1.0f, //Top Left Back 18
-
-        //Triangle 3
-        0.4f, 2.0f, 0.0f,     0.0f, 1.0f, 0.0f,    0.0f, 0.0f, //Center Top 17
-        0.55f, 2.0f, 0.05f,   0.0f, 1.0f, 0.0f,    1.0f, 0.0f, //Top Right Back 21
-        0.4f, 2.0f, 0.06f,    0.0f, 1.0f, 0.0f,    0.0f, 1.0f, //Top Center Back 20
-
-        //Triangle 4
-        0.4f, 2.0f, 0.0f,     0.0f, 1.0f, 0.0f,    0.0f, 0.0f, //Center Top 17
-        0.57f, 2.0f, 0.0f,    0.0f, 1.0f, 0.0f,    1.0f, 0.0f, //Top Right 22
-        0.55f, 2.0f, 0.05f,   0.0f, 1.0f, 0.0f,    0.0f, 1.0f, //Top Right Back 21
-
-        //Triangle 5
-        0.4f, 2.0f, 0.0f,      0.0f, 1.0f, 0.0f,   0.0f, 0.0f, //Center Top 17
-        0.55f, 2.0f, -0.05f,   0.0f, 1.0f, 0.0f,   1.0f, 0.0f, //Top Right Front 23
-        0.57f, 2.0f, 0.0f,     0.0f, 1.0f, 0.0f,   0.0f, 1.0f, //Top Right 22
-
-        //Triangle 6
-        0.4f, 2.0f, 0.0f,      0.0f, 1.0f, 0.0f,   0.0f, 0.0f, //Center Top 17
-        0.4f, 2.0f, -0.04f,    0.0f, 1.0f, 0.0f,   1.0f, 0.0f, //Top Center Front 24
-        0.55f, 2.0f, -0.05f,   0.0f, 1.0f, 0.0f,   0.0f, 1.0f, //Top Right Front 23
-
-        //Triangle 7
-        0.4f, 2.0f, 0.0f,     0.0f, 1.0f, 0.0f,    0.0f, 0.0f, //Center Top 17
-        0.35, 2.0f, -0.05f,   0.0f, 1.0f, 0.0f,    1.0f, 0.0f, //Top Left Front 25
-        0.4f, 2.0f, -0.04f,   0.0f, 1.0f, 0.0f,    0.0f, 1.0f, //Top Center Front 24
-
-        //Triangle 8
-        0.4f, 2.0f, 0.0f,     0.0f, 1.0f, 0.0f,    0.0f, 0.0f, //Center Top 17
-        0.33f, 2.0f, 0.0f,    0.0f, 1.0f, 0.0f,    1.0f, 0.0f, //Top Left 19
-        0.35f, 2.0f, 0.05f,   0.0f, 1.0f, 0.0f,    0.0f, 1.0f, //Top Left Front 18
-
-        //Connecting Circles
-        //Plane 1 Front
-        0.4f, 1.5f, -0.04f,   0.0f,  0.0f, 1.0f,    0.0f, 0.0f, //Bottom Center Front 16
-        0.4f, 2.0f, -0.04f,   0.0f,  0.0f, 1.0f,    1.0f, 0.0f, //Top Center Front 24
-        0.35f, 1.5f, -0.05f,  0.0f,  0.0f, 1.0f,    0.0f, 1.0f, //Bottom Left Front 26
-        0.4f, 2.0f, -0.04f,   0.0f,  0.0f, 1.0f,    0.0f, 0.0f, //Top Center Front 24
-        0.35f, 2.0f, -0.05f,  0.0f,  0.0f, 1.0f,    1.0f, 0.0f, //Top Left Front 27
-        0.35f, 1.5f, -0.05f,  0.0f,  0.0f, 1.0f,    0.0f, 1.0f, //Bottom Left Front 26
-
-        //Plane 2 Front
-        0.55f, 1.5f, -0.05,   0.0f, 0.0f, 1.0f,     0.0f, 0.0f, //Bottom Right Front 15
-        0.55f, 2.0f, -0.05f,  0.0f, 0.0f, 1.0f,     1.0f, 0.0f, //Bottom Right Front 23
-        0.4f, 1.5f, -0.04f,   0.0f, 0.0f, 1.0f,     0.0f, 1.0f, //Bottom Center Front 16
-        0.55f, 2.0f, -0.05f,  0.0f, 0.0f, 1.0f,     0.0f, 0.0f, //Bottom Right Front 23
-        0.4f, 2.0f, -0.04f,   0.0f, 0.0f, 1.0f,     1.0f, 0.0f, //Bottom Center Front 24
-        0.4f, 1.5f, -0.04f,   0.0f, 0.0f, 1.0f,     0.0f, 1.0f, //Bottom Center Front 16
-
-        //Plane 3 Left Front
-        0.35f, 1.5f, -0.05f, -1.0f, 0.0f, 0.0f,     0.0f, 0.0f,  //Bottom Left Front 26
-        0.35f, 2.0f, -0.05f, -1.0f, 0.0f, 0.0f,     1.0f, 0.0f, //Bottom Left Front 27
-        0.33f, 1.5f, 0.00f,  -1.0f, 0.0f, 0.0f,     0.0f, 1.0f, //Bottom Left 28
-        0.35f, 2.0f, -0.05f, -1.0f, 0.0f, 0.0f,     0.0f, 0.0f, //Bottom Left Front 27
-        0.33f, 2.0f, 0.00f,  -1.0f, 0.0f, 0.0f,     1.0f, 0.0f, //Bottom Left 29
-        0.33f, 1.5f, 0.00f,  -1.0f, 0.0f, 0.0f,     0.0f, 1.0f, //Bottom Left 28
-
-        //Plane 4 Right Front
-        0.57f, 1.5f, 0.00f,   1.0f, 0.0f, 0.0f,    0.0f, 0.0f, //Bottom Right 29
-        0.57f, 2.0f, 0.00f,   1.0f, 0.0f, 0.0f,    1.0f, 0.0f, //Top Right 30
-        0.55f, 1.5f, -0.05f,  1.0f, 0.0f, 0.0f,    0.0f, 1.0f, //Bottom Right Front 15
-        0.57f, 2.0f, 0.00f,   1.0f, 0.0f, 0.0f,    0.0f, 0.0f, //Top Right 30
-        0.55f, 2.0f, -0.05f,  1.0f, 0.0f, 0.0f,    1.0f, 0.0f, //Top Right Front 23
-        0.55f, 1.5f, -0.05f,  1.0f, 0.0f, 0.0f,    0.0f, 1.0f, //Bottom Right Front 15
-
-        //Plane 5 Back
-        0.55f, 1.5f, 0.05f,   0.0f, 0.0f, -1.0f,   0.0f, 0.0f, //Bottom Right Back 13
-        0.55f, 2.0f, 0.05f,   0.0f, 0.0f, -1.0f,   1.0f, 0.0f, //Top Right Back 21
-        0.4f, 1.5f, 0.06f,    0.0f, 0.0f, -1.0f,   0.0f, 1.0f, //Bottom Center Back 12
-        0.55f, 2.0f, 0.05f,   0.0f, 0.0f, -1.0f,   0.0f, 0.0f, //Top Right Back 21
-        0.4f, 2.0f, 0.06f,    0.0f, 0.0f, -1.0f,   1.0f, 0.0f, //Top Center Back 20
-        0.4f, 1.5f, 0.06f,    0.0f, 0.0f, -1.0f,   0.0f, 1.0f, //Top Center Back 12
-
-        //Plane 6 Back
-        0.4f, 1.5f, 0.06f,   0.0f, 0.0f, -1.0f,    0.0f, 0.0f, //Bottom Center Back 12
-        0.4f, 2.0f, 0.06f,   0.0f, 0.0f, -1.0f,    1.0f, 0.0f, //Top Center Back 20
-        0.35f, 1.5f, 0.05f,  0.0f, 0.0f, -1.0f,    0.0f, 1.0f, //Bottom Left Back 10
-        0.4f, 2.0f, 0.06f,   0.0f, 0.0f, -1.0f,    0.0f, 0.0f, //Top Center Back 20
-        0.35f, 2.0f, 0.05f,  0.0f, 0.0f, -1.0f,    1.0f, 0.0f, //Top Left Back 18
-        0.35f, 1.5f, 0.05f,  0.0f, 0.0f, -1.0f,    0.0f, 1.0f, //Bottom Left Back 10
-
-        //Plane 7 Back Left
-        0.35f, 1.5f, 0.05f, -1.0f, 0.0f, 0.0f,     0.0f, 0.0f, //Bottom Left Back 10
-        0.35f, 2.0f, 0.05f, -1.0f, 0.0f, 0.0f,     1.0f, 0.0f, //Top Left Back 18
-        0.33f, 1.5f, 0.0f,  -1.0f, 0.0f, 0.0f,     0.0f, 1.0f, //Bottom Left 11
-        0.35f, 2.0f, 0.05f, -1.0f, 0.0f, 0.0f,     0.0f, 0.0f, //Top Left Back 18
-        0.33f, 2.0f, 0.0f,  -1.0f, 0.0f, 0.0f,     1.0f, 0.0f, //Top Left 19
-        0.33f, 1.5f, 0.0f,  -1.0f, 0.0f, 0.0f,     0.0f, 1.0f, //Bottom Left 11
-
-        //Plane 8 Back Right
-        0.57f, 1.5f, 0.0f,   1.0f, 0.0f, 0.0f,     0.0f, 0.0f, //Bottom Right 14
-        0.57f, 2.0f, 0.0f,   1.0f, 0.0f, 0.0f,     1.0f, 0.0f, //Top Right 22
-        0.55f, 1.5f, 0.05f,  1.0f, 0.0f, 0.0f,     0.0f, 1.0f, //Bottom Right 13
-        0.57f, 2.0f, 0.0f,   1.0f, 0.0f, 0.0f,     0.0f, 0.0f, //Top Right 22
-        0.55f, 2.0f, 0.05f,  1.0f, 0.0f, 0.0f,     1.0f, 0.0f, //Top Right Back 21
-        0.55f, 1.5f, 0.05f,  1.0f, 0.0f, 0.0f,     0.0f, 1.0f, //Bottom Right Back 13
-
-        //Glass Bottle Cube
-       -0.5f, -0.5f, -0.5f,  0.0f, 0.0f, -1.0f,    0.0f, 0.0f, //Back br Vertex 31
-        0.5f, -0.5f, -0.5f,  0.0f, 0.0f, -1.0f,    0.0f, 1.0f, //Back bl Vertex 32
-        0.5f, 1.5f, -0.5f,   0.0f, 0.0f, -1.0f,    1.0f, 0.0f, //Back tl Vertex 33
-        0.5f, 1.5f, -0.5f,   0.0f, 0.0f, -1.0f,    1.0f, 0.0f, //Back tl Vertex 34
-       -0.5f, 1.5f, -0.5f,   0.0f, 0.0f, -1.0f,    0.0f, 1.0f, //Back tr Vertex 35
-       -0.5f, -0.5f, -0.5f,  0.0f, 0.0f, -1.0f,    0.0f, 0.0f, //Back br Vertex 36
-
-       -0.5f, -0.5f, 0.5f,   0.0f, 0.0f, 1.0f,     0.0f, 0.0f, //Front br Vertex 37
-        0.5f, -0.5f, 0.5f,   0.0f, 0.0f, 1.0f,     0.0f, 1.0f, //Front bl Vertex 38
-        0.5f, 1.5f, 0.5f,    0.0f, 0.0f, 1.0f,     1.0f, 0.0f, //Front tl Vertex 39
-        0.5f, 1.5f, 0.5f,    0.0f, 0.0f, 1.0f,     1.0f, 0.0f, //Front tl Vertex 40
-       -0.5f, 1.5f, 0.5f,    0.0f, 0.0f, 1.0f,     0.0f, 1.0f, //Front tr Vertex 41
-       -0.5f, -0.5f, 0.5f,   0.0f, 0.0f, 1.0f,     0.0f, 0.0f, //Front br Vertex 42
-
-       -0.5f, 1.5f, 0.5f,   -1.0f, 0.0f, 0.0f,     0.0f, 0.0f, //Left tr Vertex 43
-       -0.5f, 1.5f, -0.5f,  -1.0f, 0.0f, 0.0f,     0.0f, 1.0f, //Left tl Vertex 44
-       -0.5f, -0.5f, -0.5f, -1.0f, 0.0f, 0.0f,     1.0f, 0.0f, //Left bl Vertex 45
-       -0.5f, -0.5f, -0.5f, -1.0f, 0.0f, 0.0f,     1.0f, 0.0f, //Left bl Vertex 46
-       -0.5f, -0.5f, 0.5f,  -1.0f, 0.0f, 0.0f,     0.0f, 1.0f, //Left br Vertex 47
-       -0.5f, 1.5f, 0.5f,   -1.0f, 0.0f, 0.0f,     0.0f, 0.0f, //Left tr Vertex 48
-
-        0.5f, 1.5f, 0.5f,    1.0f, 0.0f, 0.0f,     0.0f, 0.0f, //Right tl Vertex 49
-        0.5f, 1.5f, -0.5f,   1.0f, 0.0f, 0.0f,     0.0f, 1.0f, //Right tr Vertex 50
-        0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 0.0f,     1.0f, 0.0f, //Right br Vertex 51
-        0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 0.0f,     1.0f, 0.0f, //Right br Vertex 52
-        0.5f, -0.5f, 0.5f,   1.0f, 0.0f, 0.0f,     0.0f, 1.0f, //Right bl Vertex 53
-        0.5f, 1.5f, 0.5f,    1.0f, 0.0f, 0.0f,     0.0f, 0.0f, //Right tl Vertex 54
-
-       -0.5f, -0.5f, -0.5f,  0.0f, -1.0f, 0.0f,    0.0f, 0.0f, //Bottom bl Vertex 55
-        0.5f, -0.5f, -0.5f,  0.0f, -1.0f, 0.0f,    0.0f, 1.0f, //Bottom br Vertex 56
-        0.5f, -0.5f, 0.5f,   0.0f, -1.0f, 0.0f,    1.0f, 0.0f, //Bottom tr Vertex 57
-        0.5f, -0.5f, 0.5f,   0.0f, -1.0f, 0.0f,    1.0f, 0.0f, //Bottom tr Vertex 58
-       -0.5f, -0.5f, 0.5f,   0.0f, -1.0f, 0.0f,    0.0f, 1.0f, //Bottom tl Vertex 59
-       -0.5f, -0.5f, -0.5f,  0.0f, -1.0f, 0.0f,    0.0f, 0.0f, //Bottom bl Vertex 60
-
-       -0.5f, 1.5f, -0.5f,   0.0f, 1.0f, 0.0f,     0.0f, 0.0f, //Top bl Vertex 61
-        0.5f, 1.5f, -0.5f,   0.0f, 1.0f, 0.0f,     0.0f, 1.0f, //Top br Vertex 62
-        0.5f, 1.5f, 0.5f,    0.0f, 1.0f, 0.0f,     1.0f, 0.0f, //Top tr Vertex 63
-        0.5f, 1.5f, 0.5f,    0.0f, 1.0f, 0.0f,     1.0f, 0.0f, //Top tr Vertex 64
-       -0.5f, 1.5f, 0.5f,    0.0f, 1.0f, 0.0f,     0.0f, 1.0f, //Top tl Vertex 65
-       -0.5f, 1.5f, -0.5f,   0.0f, 1.0f, 0.0f,     0.0f, 0.0f, //Top bl Vertex 66
-
-        //Bottle Cylinder
-        //Bottom Circle
-        //Triangle 1
-       -3.0,   -0.5f, 3.0f,  0.0f, -1.0f, 0.0f,    0.0f, 0.0f, //Center Bottom 67
-       -3.35f, -0.5f, 3.05f, 0.0f, -1.0f, 0.0f,    1.0f, 0.0f, //Bottom Left Back 68
-       -3.33f, -0.5f, 3.0f,  0.0f, -1.0f, 0.0f,    0.0f, 1.0f, //Bottom Left 69
-
-        //Triangle 2
-       -3.0,   -0.5f, 3.0f,  0.0f, -1.0f, 0.0f,    0.0f, 0.0f, //Center Bottom 67
-       -3.4f,  -0.5f, 3.06f, 0.0f, -1.0f, 0.0f,    1.0f, 0.0f, //Bottom Center Back 70
-       -3.35f, -0.5f, 3.05f, 0.0f, -1.0f, 0.0f,    0.0f, 1.0f, //Bottom Left Back 68
-
-        //Triangle 3
-       -3.0,   -0.5f, 3.0f,  0.0f, -1.0f, 0.0f,    0.0f, 0.0f, //Center Bottom 67
-       -3.55f, -0.5f, 3.05f, 0.0f, -1.0f, 0.0f,    1.0f, 0.0f, //Bottom Right Back 71
-       -3.4f,  -0.5f, 3.06f, 0.0f, -1.0f, 0.0f,    0.0f, 1.0f, //Bottom Center Back 70
-
-        //Triangle 4
-       -3.0,   -0.5f, 3.0f,  0.0f, -1.0f, 0.0f,    0.0f, 0.0f, //Center Bottom 67
-       -3.57f, -0.5f, 3.0f,  0.0f, -1.0f, 0.0f,    1.0f, 0.0f, //Bottom Right 72
-       -3.55f, -0.5f, 3.05f, 0.0f, -1.0f, 0.0f,    0.0f, 1.0f, //Bottom Right Back 71
-
-        //Triangle 5
-       -3.0,   -0.5f, 3.0f,  0.0f, -1.0f, 0.0f,    0.0f, 0.0f, //Center Bottom 67
-       -3.55f, -0.5f, 3.05f, 0.0f, -1.0f, 0.0f,    1.0f, 0.0f, //Bottom Right Front 73
-       -3.57f, -0.5f, 3.0f,  0.0f, -1.0f, 0.0f,    0.0f, 1.0f, //Bottom Right 72
-
-        //Triangle 6
-       -3.0,   -0.5f, 3.0f,  0.0f, -1.0f,0.0f,     0.0f, 0.0f, //Center Bottom 67
-       -3.4f,  -0.5f, 3.04f, 0.0f, -1.0f, 0.0f,    1.0f, 0.0f, //Bottom Center Front 74
-       -3.55f, -0.5f, 3.05f, 0.0f, -1.0f, 0.0f,    0.0f, 1.0f, //Bottom Right Front 73
-
-        //Triangle 7
-       -3.0,  -0.5f, 3.0f,   0.0f, -1.0f, 0.0f,    0.0f, 0.0f, //Center Bottom 67
-       -3.35, -0.5f, 3.05f,  0.0f, -1.0f, 0.0f,    1.0f, 0.0f, //Bottom Left Front 8
-       -3.4f, -0.5f, 3.04f,  0.0f, -1.0f, 0.0f,    0.0f, 1.0f, //Bottom Center Front 74
-
-        //Triangle 8
-       -3.0,   -0.5f, 3.0f,  0.0f, -1.0f, 0.0f,    0.0f, 0.0f, //Center Bottom 67
-       -3.33f, -0.5f, 3.0f,  0.0f, -1.0f, 0.0f,    1.0f, 0.0f, //Bottom Left 69
-       -3.35f, -0.5f, 3.05f, 0.0f, -1.0f, 0.0f,    0.0f, 1.0f, //Bottom Left Front 68
-
-        //Top Circle
-        //Triangle 1
-        -3.0,   6.0f, 3.0f,  0.0f, -1.0f, 0.0f,     0.0f, 0.0f, //Center Bottom 75
-        -3.35f, 6.0f, 3.05f, 0.0f, -1.0f, 0.0f,     1.0f, 0.0f, //Bottom Left Back 76
-        -3.33f, 6.0f, 3.0f,  0.0f, -1.0f, 0.0f,     0.0f, 1.0f, //Bottom Left 77
-
-        //Triangle 2
-        -3.0,   6.0f, 3.0f,  0.0f, -1.0f, 0.0f,     0.0f, 0.0f, //Center Bottom 75
-        -3.4f,  6.0f, 3.06f, 0.0f, -1.0f, 0.0f,     1.0f, 0.0f, //Bottom Center Back 78
-        -3.35f, 6.0f, 3.05f, 0.0f, -1.0f, 0.0f,     0.0f, 1.0f, //Bottom Left Back 76
-
-        //Triangle 3
-        -3.0,   6.0f, 3.0f,  0.0f, -1.0f, 0.0f,     0.0f, 0.0f, //Center Bottom 75
-        -3.55f, 6.0f, 3.05f, 0.0f, -1.0f, 0.0f,     1.0f, 0.0f, //Bottom Right Back 79
-        -3.4f,  6.0f, 3.06f, 0.0f, -1.0f, 0.0f,     0.0f, 1.0f, //Bottom Center Back 78
-
-        //Triangle 4
-        -3.0,   6.0f, 3.0f,  0.0f, -1.0f, 0.0f,     0.0f, 0.0f, //Center Bottom 75
-        -3.57f, 6.0f, 3.0f,  0.0f, -1.0f, 0.0f,     1.0f, 0.0f, //Bottom Right 80
-        -3.55f, 6.0f, 3.05f, 0.0f, -1.0f, 0.0f,     0.0f, 1.0f, //Bottom Right Back 79
-
-        //Triangle 5
-        -3.0,   6.0f, 3.0f,  0.0f, -1.0f, 0.0f,     0.0f, 0.0f, //Center Bottom 75
-        -3.55f, 6.0f, 3.05f, 0.0f, -1.0f, 0.0f,     1.0f, 0.0f, //Bottom Right Front 81
-        -3.57f, 6.0f, 3.0f,  0.0f, -1.0f, 0.0f,     0.0f, 1.0f, //Bottom Right 80
-
-        //Triangle 6
-        -3.0,   6.0f, 3.0f,  0.0f, -1.0f, 0.0f,     0.0f, 0.0f, //Center Bottom 75
-        -3.4f,  6.0f, 3.04f, 0.0f, -1.0f, 0.0f,     1.0f, 0.0f, //Bottom Center Front 82
-        -3.55f, 6.0f, 3.05f, 0.0f, -1.0f, 0.0f,     0.0f, 1.0f, //Bottom Right Front 81
-
-        //Triangle 7
-        -3.0,   6.0f, 3.0f,  0.0f, -1.0f, 0.0f,     0.0f, 0.0f, //Center Bottom 75
-        -3.35,  6.0f, 3.05f, 0.0f, -1.0f, 0.0f,     1.0f, 0.0f, //Bottom Left Front 83
-        -3.4f,  6.0f, 3.04f, 0.0f, -1.0f, 0.0f,     0.0f, 1.0f, //Bottom Center Front 82
-
-        //Triangle 8
-        -3.0,   6.0f, 3.0f,  0.0f, -1.0f, 0.0f,     0.0f, 0.0f, //Center Bottom 75
-        -3.33f, 6.0f, 3.0f,  0.0f, -1.0f, 0.0f,     1.0f, 0.0f, //Bottom Left 77
-        -3.35f, 6.0f, 3.05f, 0.0f, -1.0f, 0.0f,     0.0f, 1.0f, //Bottom Left Front 76
-
-        //Connecting Circles
-        //Plane 1 Front
-        -3.4f, -0.5f, 3.04f, 0.0f, 0.0f, 1.0f,  0.0f, 0.0f, //Bottom Center Front 74
-        -3.4f,  6.0f, 3.04f, 0.0f, 0.0f, 1.0f,  1.0f, 0.0f, //Top Center Front 82
-        -3.35f,-0.5f, 3.05f, 0.0f, 0.0f, 1.0f,  0.0f, 1.0f, //Bottom Left Front 84
-        -3.4f,  6.0f, 3.04f, 0.0f, 0.0f, 1.0f,  0.0f, 0.0f, //Top Center Front 82
-        -3.35f, 6.0f, 3.05f, 0.0f, 0.0f, 1.0f,  1.0f, 0.0f, //Top Left Front 85
-        -3.35f,-0.5f, 3.05f, 0.0f, 0.0f, 1.0f,  0.0f, 1.0f, //Bottom Left Front 84
-
-        //Plane 2 Front
-        -3.55f, -0.5f, 3.05f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, //Bottom Right Front 73
-        -3.55f,  6.0f, 3.05f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, //Bottom Right Front 81
-        -3.4f,  -0.5f, 3.04f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, //Bottom Center Front 74
-        -3.55f,  6.0f, 3.05f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, //Bottom Right Front 81
-        -3.4f,   6.0f, 3.04f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, //Bottom Center Front 82
-        -3.4f,  -0.5f, 3.04f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, //Bottom Center Front 74
-
-        //Plane 3 Left Front
-        -3.35f, -0.5f, 3.05f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f,  //Bottom Left Front 84
-        -3.35f,  6.0f, 3.05f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Bottom Left Front 85
-        -3.33f, -0.5f, 3.00f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Bottom Left 86
-        -3.35f,  6.0f, 3.05f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Bottom Left Front 85
-        -3.33f,  6.0f, 3.00f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Bottom Left 87
-        -3.33f, -0.5f, 3.00f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Bottom Left 86
-
-        //Plane 4 Right Front
-        -3.33f,  6.0f, 3.0f,  1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Bottom Right 87
-        -3.55f, -0.5f, 3.05f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Top Right 88
-        -3.55f, -0.5f, 3.05f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Bottom Right Front 73
-        -3.55f, -0.5f, 3.05f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Top Right 88
-        -3.55f,  6.0f, 3.05f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Top Right Front 81
-        -3.55f, -0.5f, 3.05f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Bottom Right Front 73
-
-        //Plane 5 Back
-        -3.55f, -0.5f, 3.05f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, //Bottom Right Back 71
-        -3.55f,  6.0f, 3.05f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, //Top Right Back 79
-        -3.4f,  -0.5f, 3.06f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, //Bottom Center Back 70
-        -3.55f,  6.0f, 3.05f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, //Top Right Back 79
-        -3.4f,   6.0f, 3.06f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, //Top Center Back 78
-        -3.4f,  -0.5f, 3.06f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, //Top Center Back 70
-
-        //Plane 6 Back
-        -3.4f, -0.5f, 3.06f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, //Bottom Center Back 70
-        -3.4f,  6.0f, 3.06f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, //Top Center Back 78
-        -3.35f,-0.5f, 3.05f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, //Bottom Left Back 68
-        -3.4f,  6.0f, 3.06f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, //Top Center Back 78
-        -3.35f, 6.0f, 3.05f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, //Top Left Back 76
-        -3.35f,-0.5f, 3.05f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, //Bottom Left Back 68
-
-        //Plane 7 Back Left
-        -3.35f, -0.5f, 3.05f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Bottom Left Back 68
-        -3.35f,  6.0f, 3.05f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Top Left Back 76
-        -3.33f, -0.5f, 3.0f,  -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Bottom Left 69
-        -3.35f,  6.0f, 3.05f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Top Left Back 76
-        -3.33f,  6.0f, 3.0f,  -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Top Left 77
-        -3.33f, -0.5f, 3.0f,  -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Bottom Left 69
-
-        //Plane 8 Back Right
-        -3.57f, -0.5f, 3.0f,  1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Bottom Right 72
-        -3.57f,  6.0f, 3.0f,  1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Top Right 80
-        -3.55f, -0.5f, 3.05f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Bottom Right 71
-        -3.57f,  6.0f, 3.0f,  1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Top Right 80
-        -3.55f,  6.0f, 3.05f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Top Right Back 79
-        -3.55f, -0.5f, 3.05f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Bottom Right Back 71
-
-        //Pen Body Cube
-         5.0f, -0.5f, -3.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, //Back br Vertex 91
-         0.0f, -0.5f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, //Back bl Vertex 92
-         0.0f, -0.7f, -1.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, //Back tl Vertex 93
-         0.0f, -0.7f, -1.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, //Back tl Vertex 94
-         5.0f, -0.7f, -3.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, //Back tr Vertex 95
-         5.0f, -0.5f, -3.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, //Back br Vertex 96
-
-         1.0f, -0.7f,  0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, //Front tl Vertex 97
-         1.0f, -0.5f,  0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, //Front bl Vertex 98
-         4.0f, -0.7f, -4.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, //Front tr Vertex 99
-         4.0f, -0.7f, -4.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, //Front tr Vertex 100
-         1.0f, -0.5f,  0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, //Front bl Vertex 101
-         4.0f, -0.5f, -4.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, //Front br Vertex 102
-
-         1.0f, -0.7f,  0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Left tr Vertex 103
-         0.0f, -0.7f, -1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Left tl Vertex 104
-         0.0f, -0.5f, -1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Left bl Vertex 105
-         0.0f, -0.5f, -1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Left bl Vertex 106
-         1.0f, -0.5f,  0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Left br Vertex 107
-         1.0f, -0.7f,  0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Left tr Vertex 108
-
-         4.0f, -0.7f, -4.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Right tl Vertex 109
-         5.0f, -0.7f, -3.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Right tr Vertex 110
-         5.0f, -0.5f, -3.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Right br Vertex 111
-         5.0f, -0.5f, -3.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Right br Vertex 112
-         4.0f, -0.5f, -4.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Right bl Vertex 113
-         4.0f, -0.7f, -4.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Right tl Vertex 114
-
-         1.0f, -0.5f,  0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, //Bottom bl Vertex 115
-         4.0f, -0.5f, -4.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, //Bottom br Vertex 116
-         5.0f, -0.5f, -3.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, //Bottom tr Vertex 117
-         5.0f, -0.5f, -3.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, //Bottom tr Vertex 118
-         0.0f, -0.5f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, //Bottom tl Vertex 119
-         1.0f, -0.5f,  0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, //Bottom bl Vertex 120
-
-         1.0f, -0.7f,  0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, //Top bl Vertex 121
-         4.0f, -0.7f, -4.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, //Top br Vertex 122
-         5.0f, -0.7f, -3.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, //Top tr Vertex 123
-         5.0f, -0.7f, -3.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, //Top tr Vertex 124
-         0.0f, -0.7f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, //Top tl Vertex 125
-         1.0f, -0.7f,  0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, //Top bl Vertex 126
-
-        //Pen Tip Pyramid
-        4.0f, -0.7f, -4.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, //Left tl Vertex 127
-        4.0f, -0.5f, -4.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, //Left bl Vertex 128
-        5.0f, -0.6f, -4.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, //Center Vertex 129
-
-        4.0f, -0.7f, -4.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Top tl Vertex 130
-        5.0f, -0.7f, -3.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Top tr Vertex 131
-        5.0f, -0.6f, -4.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Center Vertex 132
-
-        5.0f, -0.7f, -3.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, //Right tr Vertex 133
-        5.0f, -0.5f, -3.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, //Right br Vertex 134
-        5.0f, -0.6f, -4.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, //Center Vertex 135
-
-        5.0f, -0.5f, -3.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Bottom br Vertex 136
-        4.0f, -0.5f, -4.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Bottom bl Vertex 137
-        5.0f, -0.6f, -4.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Center Vertex 138
-
-        //Book Cover Planes
-         2.0f, 1.5f, 0.0f, 8.0f, 1.0f, 0.0f, 0.0f, 0.0f, //Top tl Vertex 139
-        10.0f, 1.5f, 3.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, //Top tr Vertex 140
-        -1.0f, 1.5f, 4.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, //Top bl Vertex 141
-        -1.0f, 1.5f, 4.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, //Top bl Vertex 142
-        10.0f, 1.5f, 3.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, //Top tr Vertex 143
-         7.0f, 1.5f,-1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, //Top br Vertex 144
-
-         2.0f, -0.5f, 0.0f, 8.0f, 1.0f, 0.0f, 0.0f, 0.0f, //Bottom tl Vertex 145
-        10.0f, -0.5f, 3.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, //Bottom tr Vertex 146
-        -1.0f, -0.5f, 4.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, //Bottom bl Vertex 147
-        -1.0f, -0.5f, 4.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, //Bottom bl Vertex 148
-        10.0f, -0.5f, 3.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, //Bottom tr Vertex 149
-         7.0f, -0.5f,-1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, //Bottom br Vertex 150
-
-        //Book Pages Cube
-        9.5f, -0.5f, 3.25f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, //Back br Vertex 151
-        2.5f, -0.5f, 7.75f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, //Back bl Vertex 152
-        2.5f,  1.5f, 7.75f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, //Back tl Vertex 153
-        2.5f,  1.5f, 7.75f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, //Back tl Vertex 154
-        9.5f,  1.5f, 3.25f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, //Back tr Vertex 155
-        9.5f, -0.5f, 3.25f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, //Back br Vertex 156
-
-         7.0f, -0.5f, -0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, //Front br Vertex 157
-        -0.5f, -0.5f,  4.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, //Front bl Vertex 158
-        -0.5f,  1.5f,  4.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, //Front tl Vertex 159
-        -0.5f,  1.5f,  4.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, //Front tl Vertex 160
-         7.0f,  1.5f, -0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, //Front tr Vertex 161
-         7.0f, -0.5f, -0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, //Front br Vertex 162
-
-        -0.5f,  1.5f,  4.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Left tr Vertex 163
-         2.5f,  1.5f, 7.75f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Left tl Vertex 164
-         2.5f, -0.5f, 7.75f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Left bl Vertex 165
-         2.5f, -0.5f, 7.75f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Left bl Vertex 166
-        -0.5f, -0.5f,  4.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Left br Vertex 167
-        -0.5f,  1.5f,  4.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Left tr Vertex 168
-
-         7.0f,  1.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Right tl Vertex 169
-         9.5f,  1.5f, 3.25f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Right tr Vertex 170
-         9.5f, -0.5f, 3.25f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Right br Vertex 171
-         9.5f, -0.5f, 3.25f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Right br Vertex 172
-         7.0f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Right bl Vertex 173
-         7.0f,  1.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Right tl Vertex 174
-
-        -0.5f, -0.5f,  4.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, //Bottom bl Vertex 175
-         7.0f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, //Bottom br Vertex 176
-         9.5f, -0.5f, 3.25f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, //Bottom tr Vertex 177
-         9.5f, -0.5f, 3.25f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, //Bottom tr Vertex 178
-         2.5f, -0.5f, 7.75f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, //Bottom tl Vertex 179
-        -0.5f, -0.5f,  4.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, //Bottom bl Vertex 180
-
-        -0.5f, 1.5f,  4.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, //Top bl Vertex 181
-         7.0f, 1.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, //Top br Vertex 182
-         9.5f, 1.5f, 3.25f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, //Top tr Vertex 183
-         9.5f, 1.5f, 3.25f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, //Top tr Vertex 184
-         2.5f, 1.5f, 7.75f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, //Top tl Vertex 185
-        -0.5f, 1.5f,  4.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, //Top bl Vertex 186
-
-
-    };
-
-    // Index data to share position data
-    GLushort indices[] = {
-        //Plane
-        1, 2, 3, //Triangle 1
-        4, 1, 3, //Triangle 2
-
-        //Glass Lid
-        7, 8, 6, //Triangle 3
-        9, 10, 11,//Triangle 4
-        9, 12, 10, //Triangle 5
-        9, 13, 12, //Triangle 6
-        9, 14, 13, //Triangle 7
-        9, 15, 14, //Triangle 8
-        9, 16, 15, //Triangle 9
-        9, 8, 16, //Triangle 10
-        9, 11, 10, //Triangle 11
-        17, 18, 19, //Triangle 12
-        17, 20, 18, //Triangle 13
-        17, 21, 20, //Triangle 14
-        17, 22, 21, //Triangle 15
-        17, 23, 22, //Triangle 16
-        17, 24, 23, //Triangle 17
-        17, 25, 24, //Triangle 18
-        17, 19, 18, //Triangle 19
-        16, 24, 26, //Triangle 20
-        24, 27, 26, //Triangle 21
-        15, 23, 16, //Triangle 22
-        23, 24, 16, //Triangle 23
-        26, 27, 28, //Triangle 24
-        27, 29, 28, //Triangle 25
-        29, 30, 15, //Triangle 26
-        30, 23, 15, //Triangle 27
-        13, 21, 12, //Triangle 28
-        21, 20, 12, //Triangle 29
-        12, 20, 10, //Triangle 30
-        20, 18, 10, //Triangle 31
-        10, 18, 11, //Triangle 32
-        18, 19, 11, //Triangle 33
-        14, 22, 13, //Triangle 34
-        22, 21, 13, //Triangle 35
-
-        //Glass Jar
-        31, 32, 33, //Triangle 36
-        34, 35, 36, //Triangle 37
-        37, 38, 39, //Triangle 38
-        40, 41, 42, //Triangle 39
-        43, 44, 45, //Triangle 40
-        46, 47, 48, //Triangle 41
-        49, 50, 51, //Triangle 42
-        52, 53, 54, //Triangle 43
-        55, 56, 57, //Triangle 44
-        58, 59, 60, //Triangle 45
-        61, 62, 63, //Triangle 46
-        64, 65, 66, //Triangle 47
-
-        //Bottle
-        67, 68, 69, //Triangle 48
-        69, 70, 71, //Triangle 49
-        69, 72, 70, //Triangle 50
-        69, 73, 72, //Triangle 51
-        69, 74, 73, //Triangle 52
-        69, 75, 74, //Triangle 53
-        69, 76, 75, //Triangle 54
-        69, 68, 76, //Triangle 55
-        69, 71, 70, //Triangle 56
-        77, 78, 79, //Triangle 57
-        77, 80, 78, //Triangle 58
-        77, 81, 80, //Triangle 59
-        77, 82, 81, //Triangle 60
-        77, 83, 82, //Triangle 61
-        77, 84, 83, //Triangle 62
-        77, 85, 84, //Triangle 63
-        77, 79, 78, //Triangle 64
-        76, 84, 86, //Triangle 65
-        84, 87, 86, //Triangle 66
-        75, 83, 76, //Triangle 67
-        83, 84, 76, //Triangle 68
-        86, 87, 88, //Triangle 69
-        87, 89, 88, //Triangle 70
-        89, 90, 75, //Triangle 71
-        90, 83, 75, //Triangle 72
-        73, 81, 72, //Triangle 73
-        81, 80, 72, //Triangle 74
-        72, 80, 70, //Triangle 75
-        80, 78, 70, //Triangle 76
-        70, 78, 71, //Triangle 77
-        78, 79, 71, //Triangle 78
-        74, 82, 73, //Triangle 79
-        82, 81, 73, //Triangle 80
-
-        //Pen Body
-        91, 92, 93, //Triangle 81
-        94, 95, 96, //Triangle 82
-        97, 98, 99, //Triangle 83
-        100, 101, 102, //Triangle 84
-        103, 104, 105, //Triangle 85
-        106, 107, 108, //Triangle 86
-        109, 110, 111, //Triangle 87
-        112, 113, 114, //Triangle 88
-        115, 116, 117, //Triangle 89
-        118, 119, 120, //Triangle 90
-        121, 122, 123, //Triangle 91
-        124, 125, 126, //Triangle 92
-
-        //Pen Tip
-        127, 128, 129, //Triangle 93
-        130, 131, 132, //Triangle 94
-        133, 134, 135, //Triangle 95
-        136, 137, 138, //Triangle 96
-
-        //Book Cover
-        139, 140, 141, //Triangle 97
-        142, 143, 144, //Triangle 98
-        145, 146, 147, //Triangle 99
-        148, 149, 150, //Triangle 100
-
-        //Book Pages
-        151, 152, 153, //Triangle 101
-        154, 155, 156, //Triangle 102
-        157, 158, 159, //Triangle 103
-        160, 161, 162, //Triangle 104
-        163, 164, 165, //Triangle 105
-        166, 167, 168, //Triangle 106
-        169, 170, 171, //Triangle 107
-        172, 173, 174, //Triangle 108
-        175, 176, 177, //Triangle 109
-        178, 179, 180, //Triangle 110
-        181, 182, 183, //Triangle 111
-        184, 185, 186, //Triangle 112
-
-
-    };
-
-    const GLuint floatsPerVertex = 3;
-    const GLuint floatsPerNormal = 3;
-    const GLuint floatsPerUV = 2;
-
-    mesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (floatsPerVertex + floatsPerNormal + floatsPerUV));
-
-    glGenVertexArrays(1, &mesh.vao); // we can also generate multiple VAOs or buffers at the same time
-    glBindVertexArray(mesh.vao);
-
-    // Create VBO
-    glGenBuffers(2, mesh.vbos);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-    mesh.nVertices = sizeof(indices) / sizeof(indices[0]);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.vbos[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-    // Strides between vertex coordinates
-    GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
-
-    // Create Vertex Attribute Pointers
-    glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (char*)(sizeof(float) * floatsPerVertex));
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, floatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-    glEnableVertexAttribArray(2);
-}
-
-
-void UDestroyMesh(GLMesh& mesh)
-{
-    glDeleteVertexArrays(1, &mesh.vao);
-    glDeleteBuffers(2, mesh.vbos);
-}
-
-
-/*Generate and load the texture*/
-bool UCreateTexture(const char* filename, GLuint& textureId)
-{
-    int width, height, channels;
-    unsigned char* image = stbi_load(filename, &width, &height, &channels, 0);
-    if (image)
-    {
-        flipImageVertically(image, width, height, channels);
-
-        glGenTextures(1, &textureId);
-        glBindTexture(GL_TEXTURE_2D, textureId);
-
-        // set the texture wrapping parameters
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        // set texture filtering parameters
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        if (channels == 3)
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-        else if (channels == 4)
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-        else
-        {
-            cout << "Not implemented to handle image with " << channels << " channels" << endl;
-            return false;
-        }
-
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        stbi_image_free(image);
-        glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
-
-        return true;
-    }
-
-    // Error loading the image
-    return false;
-}
-
-
-void UDestroyTexture(GLuint textureId)
-{
-    glGenTextures(1, &textureId);
-}
-
-
-// Implements the UCreateShaders function
-bool UCreateShaderProgram(const char* vtxShaderSource, const char* fragShaderSource, GLuint& programId)
-{
-    // Compilation and linkage error reporting
-    int success = 0;
-    char infoLog[512];
-
-    // Create a Shader program object.
-    programId = glCreateProgram();
-
-    // Create the vertex and fragment shader objects
-    GLuint vertexShaderId = glCreateShader(GL_VERTEX_SHADER);
-    GLuint fragmentShaderId = glCreateShader(GL_FRAGMENT_SHADER);
-
-    // Retrive the shader source
-    glShaderSource(vertexShaderId, 1, &vtxShaderSource, NULL);
-    glShaderSource(fragmentShaderId, 1, &fragShaderSource, NULL);
-
-    // Compile the vertex shader, and print compilation errors (if any)
-    glCompileShader(vertexShaderId); // compile the vertex shader
-    // check for shader compile errors
-    glGetShaderiv(vertexShaderId, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(vertexShaderId, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-
-        return false;
-    }
-
-    glCompileShader(fragmentShaderId); // compile the fragment shader
-    // check for shader compile errors
-    glGetShaderiv(fragmentShaderId, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(fragmentShaderId, sizeof(infoLog), NULL, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-
-        return false;
-    }
-
-    // Attached compiled shaders to the shader program
-    glAttachShader(programId, vertexShaderId);
-    glAttachShader(programId, fragmentShaderId);
-
-    glLinkProgram(programId);   // links the shader program
-    // check for linking errors
-    glGetProgramiv(programId, GL_LINK_STATUS, &success);
-    if (!success)
-    {
-        glGetProgramInfoLog(programId, sizeof(infoLog), NULL, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-
-        return false;
-    }
-
-    glUseProgram(programId);    // Uses the shader program
-
-    return true;
-}
-
-
-void UDestroyShaderProgram(GLuint programId)
-{
-    glDeleteProgram(programId);
-}
+#include <iostream>         // cout, cerr
+#include <cstdlib>          // EXIT_FAILURE
+#include <algorithm>        // sort
+#include <cfloat>           // FLT_MAX
+#include <cstring>          // memcpy
+#include <vector>           // vector
+#include <atomic>           // atomic
+#include <GL/glew.h>        // GLEW library
+#include <GLFW/glfw3.h>     // GLFW library
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"      // Image loading Utility functions
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+#include <glm/gtx/transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "camera.h" // Camera class
+#include "lightmap.h" // Lightmap baker
+#include "scene_graph.h" // Transform hierarchy
+#include "scene_entities.h" // Entity-component store and its systems
+#include "frustum_cull.h" // SIMD view frustum culling
+#include "object_bvh.h" // Bounding volume hierarchy over the scene objects
+#include "occlusion_raster.h" // CPU occlusion culling rasterizer
+#include "mesh_simplify.h" // Level of detail generation and selection
+#include "static_primitives.h" // Procedural plane, disk, cylinder, capsule, sphere and box meshes, the scene's compiled in
+#include "mesh_picking.h" // Ray picking through the object and triangle BVHs
+#include "stress_scene.h" // Seeded generator of large scenes for scaling tests
+#include "world_streaming.h" // Chunked world loaded around the camera
+#include "simulation.h" // Fixed timestep simulation thread, input queue and state snapshots
+#include "draw_commands.h" // Draw lists recorded in parallel and merged for submission
+#include "frame_limiter.h" // Sleep then spin frame rate limiter
+#include "frame_capture.h" // Frame image and video writer thread
+#include "stream_buffer.h" // Per-frame regions of the streaming vertex buffer
+#include "benchmark_clock.h" // Wall clock of the --benchmark modes
+#include "debug_draw.h" // Lines, boxes, spheres, frusta and axes queued from any thread, debug builds only
+
+using namespace std; // Standard namespace
+
+/*Shader program Macro*/
+#ifndef GLSL
+#define GLSL(Version, Source) "#version " #Version " core \n" #Source
+#endif
+
+// Unnamed namespace
+namespace
+{
+    const char* const WINDOW_TITLE = "Final Project"; // Macro for window title
+
+    // Variables for window width and height
+    const int WINDOW_WIDTH = 800;
+    const int WINDOW_HEIGHT = 600;
+
+    // Stores the GL data relative to a given mesh
+    struct GLMesh
+    {
+        GLuint vao;         // Handle for the vertex array object
+        GLuint vbos[2];         // Handles for the vertex buffer objects: vertices, lightmap coordinates
+        GLuint nVertices;    // Number of vertices of the mesh
+        GLuint depthVao;     // Position-only vertex array used by the depth pre-pass
+        GLuint depthVbo;     // Tightly packed positions for the depth pre-pass
+        GLuint nLodVertices; // Vertices of the generated levels of detail, stored after the scene's own
+    };
+
+    // Range of the shared mesh that makes up one object and how it is textured
+    struct SceneObject
+    {
+        const char* name;       // Object name, used in log output
+        GLint firstVertex;      // First vertex of the object in the mesh (in verts[] until the mesh is created)
+        GLsizei nVertices;      // Number of vertices of the object
+        GLuint* textureId;      // Texture bound while drawing the object
+        GLuint lightmapId;      // Baked diffuse lighting, 0 until the lightmaps are created
+        bool occluder;          // Rendered by the CPU occlusion rasterizer to hide other objects
+        PrimitiveShape shape;   // Generated shape, PRIMITIVE_NONE for the objects modeled in verts[]
+        glm::vec3 center;       // Center of the object bounds in model space, used for sorting
+        glm::vec3 extent;       // Half size of the object bounds in model space, used for culling
+        uint32_t node;          // Scene graph node holding the object's transform
+        LodLevel lods[MAX_LOD_COUNT];   // Level 0 is the object as modeled, the coarser levels follow
+        int lodCount;
+        int lod;                // Level drawn this frame
+    };
+
+    // Offscreen framebuffer with a color and a depth texture
+    struct GLRenderTarget
+    {
+        GLuint fbo;             // Handle for the framebuffer object
+        GLuint colorTexture;    // Color attachment
+        GLuint depthTexture;    // Depth attachment
+        int width;
+        int height;
+    };
+
+    // Per-object data of the GPU culling pass, laid out like CullObject in the shaders (std430)
+    struct GpuCullObject
+    {
+        glm::vec4 center;       // World space bounds, w unused
+        glm::vec4 extent;
+        glm::mat4 model;
+        GLuint range[4];        // First vertex and vertex count, then padding
+    };
+
+    // Draw command as read by glDrawArraysIndirect and glMultiDrawArraysIndirect
+    struct DrawArraysIndirectCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint first;
+        GLuint baseInstance;    // Object index, read by the vertex shader through an instanced attribute
+    };
+
+    // Survivor counts are copied out of the culling pass and read this many frames later
+    const int CULL_READBACK_COUNT = 3;
+
+    // Buffers of the GPU occlusion culling pass
+    struct GLCullBuffers
+    {
+        GLuint objects;             // GpuCullObject of every object
+        GLuint candidates;          // Objects that passed frustum culling this frame, front to back
+        GLuint count;               // Number of survivors, written by the culling pass
+        GLuint drawCommands;        // Survivors compacted into consecutive draw commands
+        GLuint objectCommands;      // One draw command per object, with no instance when it is occluded
+        GLuint objectIndices;       // 0 to OBJECT_COUNT - 1, one per instance
+        GLuint depthVao;            // Depth pre-pass positions plus the object index of the draw
+        GLuint readback[CULL_READBACK_COUNT];
+        GLsync fences[CULL_READBACK_COUNT];
+        unsigned candidateCount[CULL_READBACK_COUNT];
+    };
+
+    const int CAPTURE_RING_SIZE = 3;        // Frame captures in flight before the oldest must have been read
+
+    // Frame capture: the back buffer is read into the next pixel pack buffer of a ring, and a fence
+    // tells when the copy has landed and the buffer can be mapped without stalling
+    struct GLCaptureRing
+    {
+        GLuint buffers[CAPTURE_RING_SIZE];
+        GLsync fences[CAPTURE_RING_SIZE];
+        uint64_t frames[CAPTURE_RING_SIZE];     // Frame index read into each buffer
+        int widths[CAPTURE_RING_SIZE];          // Pixels read into each buffer
+        int heights[CAPTURE_RING_SIZE];
+        GLsizeiptr sizes[CAPTURE_RING_SIZE];    // Storage allocated for each buffer
+        int next;                               // Buffer the next frame is read into
+    };
+
+    // Streaming buffer for geometry rewritten every frame: allocated once with immutable storage and
+    // mapped persistently and coherently, so callers write vertices straight into it with no
+    // glBufferData or glBufferSubData. Each frame writes its own region, fenced once the frame's draws
+    // are queued.
+    struct GLStreamBuffer
+    {
+        GLuint buffer;
+        unsigned char* mapped;                  // The whole buffer, for as long as it exists
+        GLsync fences[STREAM_REGION_COUNT];     // Of the last frame drawn from each region
+        StreamAllocator allocator;
+    };
+
+    // Occlusion culling of the objects that pass frustum culling
+    enum OcclusionMode
+    {
+        OCCLUSION_OFF,
+        OCCLUSION_GPU,          // Compute pass against the depth of the previous frame
+        OCCLUSION_CPU           // Software rasterizer drawing this frame's occluders
+    };
+
+    // Debug views that replace the normal shading
+    enum OverdrawView
+    {
+        OVERDRAW_OFF,
+        OVERDRAW_FRAGMENTS,     // Fragments shaded per pixel
+        OVERDRAW_LIGHTS         // Lights evaluated per pixel
+    };
+
+    // Camera as published by the simulation, all the render thread needs of it
+    struct CameraState
+    {
+        glm::vec3 position;
+        glm::vec3 front;
+        glm::vec3 up;
+        glm::vec3 right;
+        float zoom;
+    };
+
+    // State the simulation publishes after every batch of steps, along with the one it published
+    // before so the render thread can interpolate between the two whatever frames it skipped
+    struct SimulationSnapshot
+    {
+        uint64_t tick;                          // Steps simulated so far
+        double time;                            // Simulated seconds, on the simulation thread's clock
+        double previousTime;
+        CameraState camera;
+        CameraState previousCamera;
+        double inputTime;                       // Oldest input applied since the previous snapshot, 0 without any
+        std::vector<LightPacket> lights;
+        std::vector<LightPacket> previousLights;
+        std::vector<DrawPacket> draws;          // Instances of the stress scene, only extracted when there is one
+    };
+
+    // Swap interval of the window, in the order the V key cycles through them
+    enum VsyncMode
+    {
+        VSYNC_ON,
+        VSYNC_ADAPTIVE,         // Vsync, except late frames are shown right away and tear
+        VSYNC_OFF
+    };
+
+    // Per-frame counters, reported once per second
+    struct FrameStats
+    {
+        GLuint64 shadedFragments[2];    // Last fragment count read back, without [0] and with [1] the depth pre-pass
+        unsigned frames;                // Frames rendered since the last report
+        float overdrawAverage;          // Fragments shaded per covered pixel, when the overdraw view is on
+        float overdrawMax;
+        float lightsAverage;            // Lights evaluated per covered pixel
+        float lightsMax;
+        float frameTimeMs;              // Duration of the last frame
+        float resolutionScale;          // Resolution scale the last frame was rendered at
+        unsigned visibleObjects;        // Objects that passed frustum culling in the last frame
+        unsigned culledObjects;
+        unsigned occludedObjects;       // Of the visible ones, rejected by occlusion culling (a few frames late on the GPU)
+        unsigned submittedTriangles;    // Triangles of the objects drawn in the last frame, at their level of detail
+        unsigned drawnInstances;        // Stress scene instances that passed frustum culling in the last frame
+        unsigned culledInstances;
+        float recordMs;                 // Recording the instances' draw commands in the last frame, on all threads
+        float submitMs;                 // Replaying them on the GL thread
+        double presentIntervalSum;      // Seconds between consecutive presents since the last report, and their squares
+        double presentIntervalSquares;
+        unsigned presentIntervals;
+        double inputLatencySum;         // Seconds from an input callback to the present of the first frame showing it
+        double inputLatencyMax;
+        unsigned inputLatencies;
+        unsigned skippedFrames;         // Passes of the render loop that found nothing to redraw, since the last report
+        unsigned capturedFrames;        // Frames read back for capture since the last report
+        unsigned captureOverBudget;     // Frames not captured to stay within the capture margin
+        unsigned captureRingBusy;       // Frames not captured because the next readback had not landed yet
+        double captureSeconds;          // Spent capturing on the render thread since the last report
+        double captureFrameSeconds;     // Frame time over the same frames, for the share capture took
+        double streamWaitSeconds;       // Waiting for the GPU to release a region of the streaming buffer, since the last report
+    };
+
+    // Command line options
+    struct Options
+    {
+        bool headless = false;          // Render to a hidden window and exit after a fixed number of frames
+        unsigned frames = 300;          // Frames rendered in headless mode
+        float targetFrameTimeMs = 1000.0f / 60.0f;  // Frame time dynamic resolution tries to hold
+        string benchmark;               // CPU benchmark to run instead of the render loop
+        bool selfTest = false;          // Check the CPU kernels against their reference versions and exit, no window
+        size_t stressInstances = 0;     // Instances scattered by the stress scene generator, none without --stress
+        uint32_t stressSeed = STRESS_DEFAULT_SEED;
+        size_t streamInstances = 0;     // Instances of the streamed world, none without --stream
+        size_t streamBudgetMb = 64;     // Memory the resident chunks may take
+        double maxFps = 0.0;            // Frame rate the limiter holds, 0 for no limit
+        string capturePath;             // A .y4m video, or the prefix of numbered .ppm images; no capture when empty
+        float captureMargin = 0.05f;    // Share of the frame time capture may take
+    };
+
+    // Main GLFW window
+    GLFWwindow* gWindow = nullptr;
+    // Triangle mesh data
+    GLMesh gMesh;
+    // Texture id
+    GLuint gTextureGlassId;
+    GLuint gTextureSilverId;
+    GLuint gTextureFloorId;
+    GLuint gTextureBottleId;
+    glm::vec2 gUVScale(5.0f, 5.0f);
+
+    // Textures the material index of a Renderable refers to
+    GLuint* const gMaterialTextures[] = { &gTextureFloorId, &gTextureSilverId, &gTextureGlassId, &gTextureBottleId };
+    const int MATERIAL_COUNT = sizeof(gMaterialTextures) / sizeof(gMaterialTextures[0]);
+
+    // Objects of the scene, in vertex order. Modeled objects give their range of verts[], the others
+    // the primitive they are generated from.
+    SceneObject gObjects[] = {
+        { "Floor",       0,   6,  &gTextureFloorId,  0, true },
+        { "Jar lid",     0,   0,  &gTextureSilverId, 0, false, { PRIMITIVE_CYLINDER, glm::vec3(0.45f, 1.75f, 0.0f), glm::vec3(0.24f, 0.5f, 0.11f) } },
+        { "Glass",       0,   0,  &gTextureGlassId,  0, true,  { PRIMITIVE_BOX, glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(1.0f, 2.0f, 1.0f) } },
+        { "Bottle",      0,   0,  &gTextureBottleId, 0, true,  { PRIMITIVE_CYLINDER, glm::vec3(-3.45f, 2.75f, 3.0f), glm::vec3(0.24f, 6.5f, 0.12f) } },
+        { "Pen body",    6,   36, &gTextureBottleId, 0, false },
+        { "Pen tip",     42,  12, &gTextureBottleId, 0, false },
+        { "Book cover",  54,  12, &gTextureBottleId, 0, false },
+        { "Book pages",  66,  36, &gTextureBottleId, 0, true },
+    };
+    const int OBJECT_COUNT = sizeof(gObjects) / sizeof(gObjects[0]);
+
+    // Transform hierarchy: a root node places the whole arrangement, every object hangs below it
+    SceneGraph gScene;
+    uint32_t gSceneRoot;
+
+    // Frustum culling: world space bounds of every object, refreshed when the scene graph changes
+    bool gFrustumCulling = true;
+    CullBounds gCullBounds;
+
+    // Level of detail: every object draws the coarsest level whose error stays under a pixel on screen
+    bool gLevelOfDetail = true;
+    const float LOD_PIXEL_ERROR = 1.0f;     // Largest error allowed on screen, in pixels
+    const float LOD_HYSTERESIS = 0.25f;     // Part of the budget a coarser level must leave free before switching to it
+    const int PRIMITIVE_SEGMENTS = 32;      // Segments of the generated round shapes at full detail, halved for every coarser level
+
+    // Entities (the lights, and the instances of the stress scene), updated by the entity systems every
+    // simulation step
+    EntityStore gEntities;
+    std::vector<LightPacket> gLights;       // Lights of the current frame, interpolated between snapshots
+
+    // Stress scene: the instances extracted by the simulation are frustum culled and recorded into
+    // command buffers in parallel every frame, then replayed grouped by material
+    CullBounds gInstanceBounds;
+    std::vector<uint32_t> gVisibleInstances;
+    std::vector<CommandBuffer> gCommandBuffers;     // One per partition of the visible instances
+    CommandBuffer gDrawCommands;                    // All of them merged in material order
+    std::vector<StressPrototype> gStressPrototypes;     // Objects the instances draw, all but the floor
+
+    // World streaming: a stress scene saved in chunks, whose entities are created as the camera comes
+    // near and destroyed once it is far. At most STREAM_SPAWN_BUDGET instances are created per frame.
+    ChunkStreamer gStreamer;
+    std::vector<std::vector<Entity>> gChunkEntities;    // Entities created for every resident chunk
+    glm::vec3 gLastCameraPosition;
+    const char* const WORLD_CHUNKS_PATH = "world.chunks";
+    const float WORLD_CHUNK_SIZE = 16.0f;
+    const size_t STREAM_SPAWN_BUDGET = 20000;
+
+    // Static lighting: diffuse comes from the baked lightmaps, only specular is computed per pixel
+    bool gUseLightmap = true;
+    bool gLightmapsBaked = false;           // Every object got a lightmap, loaded or baked
+    const char* const LIGHTMAP_CACHE_PATH = "lightmaps.cache";
+
+    // Depth pre-pass: lay down depth first so the main pass only shades visible fragments
+    bool gDepthPrepass = false;
+
+    // Occlusion queries counting the fragments shaded by the main pass. Results are read a few
+    // frames later so the CPU never waits on the GPU.
+    const int FRAGMENT_QUERY_COUNT = 3;
+    GLuint gFragmentQueries[FRAGMENT_QUERY_COUNT];
+    bool gFragmentQueryPending[FRAGMENT_QUERY_COUNT];
+    bool gFragmentQueryPrepass[FRAGMENT_QUERY_COUNT];
+    unsigned gFrameIndex = 0;
+
+    FrameStats gFrameStats;
+    double gLastStatsReport = 0.0;
+
+    Options gOptions;
+
+    // Overdraw view: per-pixel counters are accumulated in a float target, then false-colored
+    OverdrawView gOverdrawView = OVERDRAW_OFF;
+    GLRenderTarget gOverdrawTarget;
+    GLuint gFullscreenVao;                  // Empty vertex array for full screen passes
+    const int SHADER_LIGHT_COUNT = 2;       // Lights the forward shader evaluates for every fragment
+    const float HEATMAP_MAX_COUNT = 8.0f;   // Count shown as the hottest color
+
+    // Dynamic resolution: the scene renders into part of an offscreen target, sized to hold the
+    // target frame time, and is then upscaled into the window
+    bool gDynamicResolution = true;
+    GLRenderTarget gSceneTarget;
+    float gResolutionScale = 1.0f;          // Fraction of the window resolution rendered on each axis
+    float gSmoothedFrameTime = 0.0f;        // Frame time averaged over the last few frames, in seconds
+    const float MIN_RESOLUTION_SCALE = 0.5f;
+    const float MAX_RESOLUTION_SCALE = 1.0f;
+
+    // Checkerboard shading: each frame shades every other pixel, alternating between frames, and the
+    // rest is reprojected from the previous resolved frame. The history targets are ping-ponged and
+    // keep the distance of every pixel along the view axis in alpha to detect disocclusions.
+    bool gCheckerboard = false;
+    GLRenderTarget gHistoryTargets[2];
+    bool gHistoryValid = false;             // Whether the previous frame left a usable history
+    glm::mat4 gPreviousViewProjection;      // Camera of the frame in the history
+    glm::ivec2 gHistorySize;                // Pixels of the history covered by the previous frame
+
+    OcclusionMode gOcclusion = OCCLUSION_OFF;
+
+    // GPU occlusion culling: a compute pass tests the frustum culled objects against a max depth
+    // pyramid (Hi-Z) built from the previous frame's depth and writes the indirect draw commands
+    GLCullBuffers gCullBuffers;
+    GLuint gHiZTexture = 0;
+    glm::ivec2 gHiZSize;                    // Size of level 0, which covers the whole scene
+    int gHiZLevels = 0;
+    bool gHiZValid = false;                 // Whether the pyramid holds the previous frame
+    glm::mat4 gHiZViewProjection;           // Camera of the frame in the pyramid
+
+    // CPU occlusion culling: the occluder objects are rasterized at low resolution on the CPU and
+    // the other objects are tested against that depth before anything is sent to the GPU
+    OcclusionRasterizer gOcclusionRasterizer;
+    std::vector<GLfloat> gMeshPositions;    // Position of every vertex of the mesh
+    const int OCCLUSION_RASTER_WIDTH = 256;
+    const int OCCLUSION_RASTER_HEIGHT = 192;
+
+    // Picking: every object's full detail triangles in a BVH, under a BVH over the objects' world
+    // bounds. Object i of the pick scene is gObjects[i].
+    PickScene gPickScene;
+    // Shader program
+    GLuint gProgramId;
+    GLuint gDebugProgramId;
+    GLuint gDepthProgramId;
+    GLuint gOverdrawProgramId;
+    GLuint gHeatmapProgramId;
+    GLuint gUpscaleProgramId;
+    GLuint gCheckerboardMaskProgramId;
+    GLuint gCheckerboardResolveProgramId;
+    GLuint gHiZCopyProgramId;
+    GLuint gHiZReduceProgramId;
+    GLuint gOcclusionCullProgramId;
+    GLuint gCullDepthProgramId;
+
+    // camera
+    Camera gCamera(glm::vec3(0.0f, 0.0f, 3.0f));
+    float gLastX = WINDOW_WIDTH / 2.0f;
+    float gLastY = WINDOW_HEIGHT / 2.0f;
+    bool gFirstMouse = true;
+
+    // timing
+    float gDeltaTime = 0.0f; // time between current frame and last frame
+    float gLastFrame = 0.0f;
+
+    // Simulation: camera and entity updates run SIMULATION_STEP seconds at a time on their own thread.
+    // Once started it owns gSimulationCamera, gEntities and the streaming state; the GLFW callbacks
+    // reach it through gInputQueue, and every frame gCamera and gLights are interpolated from the
+    // latest snapshot it published.
+    const double SIMULATION_STEP = 1.0 / 60.0;
+    FixedStepThread gSimulation;
+    SpscQueue<InputEvent, 1024> gInputQueue;
+    TripleBuffer<SimulationSnapshot> gSnapshots;
+    Camera gSimulationCamera(glm::vec3(0.0f, 0.0f, 3.0f));
+    bool gMovementKeys[UP + 1] = {};        // Held state of every Camera_Movement
+    CameraState gPublishedCamera;           // Last published state, the previous one of the next snapshot
+    std::vector<LightPacket> gPublishedLights;
+    double gPublishedTime = 0.0;
+    double gOldestInputTime = 0.0;          // Of the input applied since the last snapshot was published
+    bool gSimulationChanged = true;         // Whether a step since the last snapshot changed anything
+    bool gPublishSkipped = false;           // Whether the simulation held back snapshots since the last one
+
+    // Idle mode: when nothing changed since the last frame the render loop blocks on window events
+    // instead of rendering the same frame again. The simulation posts an empty event to wake it when
+    // it publishes something new.
+    bool gIdleMode = true;
+    bool gRedraw = true;                    // Set when the window needs repainting whatever the scene does
+    std::atomic<bool> gIdle(false);         // Whether the render loop is blocked waiting
+    const double IDLE_TIMEOUT = 0.5;        // Longest block, in seconds
+
+    // Presentation: vsync, the frame limiter for when it is off, and the input to present latency
+    VsyncMode gVsync = VSYNC_ON;
+    FrameLimiter gFrameLimiter;
+    double gLastPresent = 0.0;
+    double gLastInputPresented = 0.0;       // Input time of the last snapshot whose latency was counted
+
+    // Capture: every frame is read back through the ring and encoded and written on the writer thread,
+    // unless that would take more than the capture margin of the frame time. gCaptureBudget earns the
+    // margin of every frame and spends what capturing took, frames are skipped while it is negative.
+    GLCaptureRing gCaptureRing;
+    CaptureWriter gCaptureWriter;
+    double gCaptureBudget = 0.0;            // Seconds
+
+    // Per-frame dynamic geometry
+    GLStreamBuffer gStreamBuffer;
+    const size_t STREAM_REGION_BYTES = 4 << 20;     // Most one frame can stream
+
+    // Debug view: object bounds (green drawn, red culled), lights, the scene axes and the camera
+    // frustum as it was when the view was turned on, drawn as debug lines over the frame. The lines
+    // queued during a frame are streamed and drawn in one call; release builds leave all of it out.
+    bool gDebugView = false;
+    GLuint gDebugVao = 0;                   // Debug vertices of the streaming buffer
+    glm::mat4 gDebugFrustum;
+    bool gDebugFrustumValid = false;        // Whether gDebugFrustum holds the camera of this debug view
+
+    //Object Color
+    glm::vec3 gObjectColor(1.f, 0.2f, 0.0f);
+}
+
+/* User-defined Function prototypes to:
+ * initialize the program, set the window size,
+ * redraw graphics on the window when resized,
+ * and render graphics on the screen
+ */
+bool UInitialize(int, char* [], GLFWwindow** window);
+bool UParseCommandLine(int argc, char* argv[]);
+void UResizeWindow(GLFWwindow* window, int width, int height);
+void UProcessInput(GLFWwindow* window);
+void UMousePositionCallback(GLFWwindow* window, double xpos, double ypos);
+void UMouseScrollCallback(GLFWwindow* window, double xoffset, double yoffset);
+void UMouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+void UKeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+glm::mat4 UModelMatrix();
+void UCreateSceneGraph();
+void UUpdateCullBounds();
+int UCullObjects(const glm::mat4& viewProjection, int drawOrder[]);
+int URasterizeOcclusion(const glm::mat4& viewProjection, int drawOrder[], int nDraws);
+void USelectLods(const glm::mat4& projection, const int drawOrder[], int nDraws);
+void UCreateSceneEntities();
+void UCreatePickScene();
+void UCreateStressPrototypes();
+void UCreateStressScene();
+bool UCreateStreamedWorld();
+bool UStreamWorld(float deltaTime);
+void UStartSimulation();
+void USimulationStep();
+void UPublishSnapshot(double time);
+bool UInterpolateSnapshot();
+void UWaitIdle();
+void UWindowRefreshCallback(GLFWwindow* window);
+void UApplyVsync();
+void UPresentFrame();
+void UStartCapture();
+void UCaptureFrame();
+void UCollectCaptures(bool wait);
+void UStopCapture();
+bool UCreateStreamBuffer(GLStreamBuffer& stream, size_t regionBytes);
+void UDestroyStreamBuffer(GLStreamBuffer& stream);
+void UBeginStreamFrame(GLStreamBuffer& stream);
+void* UStreamAllocate(GLStreamBuffer& stream, size_t bytes, size_t alignment, GLintptr& offset);
+void UEndStreamFrame(GLStreamBuffer& stream);
+void URunUploadBenchmark();
+void UQueueDebugView(const glm::mat4& viewProjection, const int drawOrder[], int nDraws);
+void UDrawDebug(const glm::mat4& viewProjection);
+void UDrawInstances(const glm::mat4& viewProjection);
+void UPickObject();
+bool URunBenchmark(const string& name);
+bool URunSelfTests();
+void UCreateMesh(GLMesh& mesh);
+void UDestroyMesh(GLMesh& mesh);
+void UCreateLightmaps(GLMesh& mesh, const GLfloat* verts, GLuint floatsPerVertex);
+void UDestroyLightmaps();
+bool UCreateTexture(const char* filename, GLuint& textureId);
+void UDestroyTexture(GLuint textureId);
+void URender();
+void USortFrontToBack(int drawOrder[], int nDraws);
+void UDrawDepthPrepass(const glm::mat4& view, const glm::mat4& projection, const int drawOrder[], int nDraws, bool indirect);
+void UReadFragmentQuery(int query);
+void UReportFrameStats(bool force = false);
+void URenderOverdraw(const glm::mat4& view, const glm::mat4& projection, const int drawOrder[], int nDraws);
+void UMeasureOverdraw();
+bool UCreateRenderTarget(GLRenderTarget& target, int width, int height, GLenum colorFormat);
+bool UEnsureRenderTarget(GLRenderTarget& target, int width, int height, GLenum colorFormat);
+void UDestroyRenderTarget(GLRenderTarget& target);
+void UUpdateDynamicResolution(float frameTime);
+void UUpscaleScene(const GLRenderTarget& source, int sceneWidth, int sceneHeight, int width, int height);
+bool UEnsureCheckerboardTargets(int width, int height);
+void UWriteCheckerboardMask(int parity);
+void UResolveCheckerboard(const glm::mat4& viewProjection, int sceneWidth, int sceneHeight);
+void UCreateOcclusionCulling();
+void UDestroyOcclusionCulling();
+void UUploadCullObjects();
+void UCullOccludedObjects(const int drawOrder[], int nDraws);
+void UReadCullCount(int slot);
+void UBuildHiZ(const GLRenderTarget& source, int sceneWidth, int sceneHeight, const glm::mat4& viewProjection);
+bool UCreateShaderProgram(const char* vtxShaderSource, const char* fragShaderSource, GLuint& programId);
+bool UCreateComputeProgram(const char* shaderSource, GLuint& programId);
+void UDestroyShaderProgram(GLuint programId);
+bool viewProjection = true;
+
+
+/* Vertex Shader Source Code*/
+const GLchar* vertexShaderSource = GLSL(440,
+    layout(location = 0) in vec3 position; //Vertex data
+layout(location = 1) in vec3 normal;  //Light data
+layout(location = 2) in vec2 textureCoordinate;  //Texture data
+layout(location = 3) in vec2 lightmapCoordinate;  //Lightmap data
+
+out vec3 vertexNormal; // For outgoing normals to fragment shader
+out vec3 vertexFragmentPos; // For outgoing color / pixels to fragment shader
+out vec2 vertexTextureCoordinate;
+out vec2 vertexLightmapCoordinate;
+
+invariant gl_Position; // Must match the depth pre-pass exactly for GL_EQUAL depth testing
+
+//Global variables for the transform matrices
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(position, 1.0f); // transforms vertices to clip coordinates
+    vertexTextureCoordinate = textureCoordinate;
+
+    vertexFragmentPos = vec3(model * vec4(position, 1.0f)); // Gets fragment / pixel position in world space only (exclude view and projection)
+
+    vertexNormal = mat3(transpose(inverse(model))) * normal; // get normal vectors in world space only and exclude normal translation properties
+    vertexTextureCoordinate = textureCoordinate;
+    vertexLightmapCoordinate = lightmapCoordinate;
+}
+);
+
+
+/* Fragment Shader Source Code*/
+const GLchar* fragmentShaderSource = GLSL(440,
+    in vec3 vertexNormal; // For incoming normals
+in vec3 vertexFragmentPos; // For incoming fragment position
+in vec2 vertexTextureCoordinate;
+in vec2 vertexLightmapCoordinate;
+
+out vec4 fragmentColor;
+
+// Uniform / Global variables for object color, light color, light position, and camera/view position
+uniform vec3 objectColor;
+uniform vec3 lightColor;
+uniform vec3 lightPos;
+uniform vec3 lightColor2;
+uniform vec3 lightPos2;
+uniform vec3 viewPosition;
+uniform sampler2D uTexture;
+uniform vec2 uvScale;
+uniform sampler2D uLightmap; // Baked diffuse lighting of both lights
+uniform bool uUseLightmap;
+
+void main()
+{
+    /*Phong lighting model calculations to generate ambient, diffuse, and specular components*/
+
+        //Calculate Ambient lighting*/
+    float ambientStrength = 0.1f; // Set ambient or global lighting strength
+    vec3 ambient = ambientStrength * lightColor; // Generate ambient light color
+
+    //Calculate Diffuse lighting*/
+    vec3 norm = normalize(vertexNormal); // Normalize vectors to 1 unit
+    vec3 lightDirection = normalize(lightPos - vertexFragmentPos); // Calculate distance (light direction) between light source and fragments/pixels on cube
+    vec3 diffuse = vec3(0.0f); // Diffuse is baked into the lightmap in lightmap mode
+    if (!uUseLightmap)
+    {
+        float impact = max(dot(norm, lightDirection), 0.0);// Calculate diffuse impact by generating dot product of normal and light
+        diffuse = impact * lightColor; // Generate diffuse light color
+    }
+
+    //Calculate Specular lighting*/
+    float specularIntensity = 0.8f; // Set specular light strength
+    float highlightSize = 16.0f; // Set specular highlight size
+    vec3 viewDir = normalize(viewPosition - vertexFragmentPos); // Calculate view direction
+    vec3 reflectDir = reflect(-lightDirection, norm);// Calculate reflection vector
+    //Calculate specular component
+    float specularComponent = pow(max(dot(viewDir, reflectDir), 0.0), highlightSize);
+    vec3 specular = specularIntensity * specularComponent * lightColor;
+
+    // Texture holds the color to be used for all three components
+    vec4 textureColor = texture(uTexture, vertexTextureCoordinate * uvScale);
+
+    // Calculate phong result
+    vec3 phong = (ambient + diffuse + specular) * textureColor.xyz;
+
+    fragmentColor = vec4(phong, 1.0); // Send lighting results to GPU
+
+     //Calculate Ambient lighting*/
+    float ambientStrength2 = 0.1f; // Set ambient or global lighting strength
+    vec3 ambient2 = ambientStrength2 * lightColor2; // Generate ambient light color
+
+    //Calculate Diffuse lighting*/
+    vec3 norm2 = normalize(vertexNormal); // Normalize vectors to 1 unit
+    vec3 lightDirection2 = normalize(lightPos2 - vertexFragmentPos); // Calculate distance (light direction) between light source and fragments/pixels on cube
+    vec3 diffuse2 = vec3(0.0f);
+    if (!uUseLightmap)
+    {
+        float impact2 = max(dot(norm2, lightDirection2), 0.0);// Calculate diffuse impact by generating dot product of normal and light
+        diffuse2 = impact2 * lightColor2; // Generate diffuse light color
+    }
+
+    //Calculate Specular lighting*/
+    float specularIntensity2 = 0.1f; // Set specular light strength
+    float highlightSize2 = 16.0f; // Set specular highlight size
+    vec3 viewDir2 = normalize(viewPosition - vertexFragmentPos); // Calculate view direction
+    vec3 reflectDir2 = reflect(-lightDirection2, norm);// Calculate reflection vector
+    //Calculate specular component
+    float specularComponent2 = pow(max(dot(viewDir2, reflectDir2), 0.0), highlightSize2);
+    vec3 specular2 = specularIntensity2 * specularComponent2 * lightColor2;
+
+    // Texture holds the color to be used for all three components
+    vec4 textureColor2 = texture(uTexture, vertexTextureCoordinate * uvScale);
+
+    // Calculate phong result
+    vec3 phong2 = (ambient2 + diffuse2 + specular2) * textureColor2.xyz;
+
+    // Baked diffuse of both lights, shadows included
+    vec3 bakedDiffuse = vec3(0.0f);
+    if (uUseLightmap)
+        bakedDiffuse = texture(uLightmap, vertexLightmapCoordinate).rgb * textureColor.xyz;
+
+    fragmentColor = vec4(phong + phong2 + bakedDiffuse, 1.0); // Send lighting results to GPU
+}
+);
+
+/* Depth Pre-pass Shader Source Code*/
+const GLchar* depthVertexShaderSource = GLSL(440,
+
+    layout(location = 0) in vec3 position; // Position-only vertex stream
+
+invariant gl_Position; // Same transform as the main pass, bit for bit
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(position, 1.0f); // transforms vertices to clip coordinates
+}
+);
+
+
+/* Depth pre-pass writes depth only, so the fragment shader is empty*/
+const GLchar* depthFragmentShaderSource = GLSL(440,
+
+void main()
+{
+}
+);
+
+
+/* Overdraw Counter Fragment Shader Source Code*/
+const GLchar* overdrawFragmentShaderSource = GLSL(440,
+
+    out vec4 counter; // Added to the target: x counts fragments and y counts lights
+
+uniform float uLightCount; // Lights the forward shader evaluates for each fragment
+
+void main()
+{
+    counter = vec4(1.0f, uLightCount, 0.0f, 0.0f);
+}
+);
+
+
+/* Full Screen Triangle Vertex Shader Source Code*/
+const GLchar* fullscreenVertexShaderSource = GLSL(440,
+
+    out vec2 screenCoordinate;
+
+void main()
+{
+    // One triangle covering the whole screen, generated from the vertex index
+    vec2 corner = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+    screenCoordinate = corner;
+    gl_Position = vec4(corner * 2.0f - 1.0f, 0.0f, 1.0f);
+}
+);
+
+
+/* Heatmap Fragment Shader Source Code*/
+const GLchar* heatmapFragmentShaderSource = GLSL(440,
+
+    out vec4 fragmentColor;
+
+uniform sampler2D uCounter; // Per-pixel counters written by the overdraw pass
+uniform int uChannel;       // 0 for fragments, 1 for lights
+uniform float uMaxCount;    // Count mapped to the hottest color
+
+void main()
+{
+    float count = texelFetch(uCounter, ivec2(gl_FragCoord.xy), 0)[uChannel];
+    if (count < 0.5f)
+    {
+        fragmentColor = vec4(0.0f, 0.0f, 0.0f, 1.0f); // Nothing drawn here
+        return;
+    }
+
+    // Blue for a single fragment up to red at uMaxCount
+    float t = clamp((count - 1.0f) / (uMaxCount - 1.0f), 0.0f, 1.0f);
+    vec3 heat = clamp(vec3(1.5f) - abs(4.0f * t - vec3(3.0f, 2.0f, 1.0f)), 0.0f, 1.0f);
+    fragmentColor = vec4(heat, 1.0f);
+}
+);
+
+
+/* Upscale Fragment Shader Source Code*/
+const GLchar* upscaleFragmentShaderSource = GLSL(440,
+
+    in vec2 screenCoordinate;
+
+out vec4 fragmentColor;
+
+uniform sampler2D uScene;   // Scene rendered at the reduced resolution
+uniform vec2 uRegion;       // Rendered part of the scene texture, in texture coordinates
+uniform vec2 uTexelSize;    // Size of one texel of the scene texture
+
+void main()
+{
+    // Bilinear upscale, kept half a texel inside the rendered region so texels outside it never blend in
+    vec2 coordinate = clamp(screenCoordinate * uRegion, 0.5f * uTexelSize, uRegion - 0.5f * uTexelSize);
+    fragmentColor = vec4(texture(uScene, coordinate).rgb, 1.0f);
+}
+);
+
+
+/* Checkerboard Mask Fragment Shader Source Code*/
+const GLchar* checkerboardMaskFragmentShaderSource = GLSL(440,
+
+    uniform int uParity; // Alternates every frame
+
+void main()
+{
+    // Only the pixels shaded this frame survive to write the stencil buffer
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    if (((pixel.x + pixel.y + uParity) & 1) != 0)
+        discard;
+}
+);
+
+
+/* Checkerboard Resolve Fragment Shader Source Code*/
+const GLchar* checkerboardResolveFragmentShaderSource = GLSL(440,
+
+    out vec4 fragmentColor; // Resolved color, distance along the view axis in alpha
+
+uniform sampler2D uColor;               // This frame, only the pixels of the current parity are shaded
+uniform sampler2D uDepth;               // Depth of every pixel of this frame
+uniform sampler2D uHistory;             // Previous resolved frame
+uniform mat4 uInverseViewProjection;
+uniform mat4 uPreviousViewProjection;
+uniform ivec2 uSceneSize;               // Pixels rendered this frame
+uniform ivec2 uHistorySize;             // Pixels of the history covered by the previous frame
+uniform int uParity;
+uniform bool uHistoryValid;
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+
+    // World position of the surface seen through this pixel, and its distance along the view axis
+    float depth = texelFetch(uDepth, pixel, 0).r;
+    vec2 uv = (vec2(pixel) + 0.5f) / vec2(uSceneSize);
+    vec4 world = uInverseViewProjection * vec4(vec3(uv, depth) * 2.0f - 1.0f, 1.0f);
+    float viewDepth = 1.0f / world.w;
+    world /= world.w;
+
+    if (((pixel.x + pixel.y + uParity) & 1) == 0)
+    {
+        fragmentColor = vec4(texelFetch(uColor, pixel, 0).rgb, viewDepth); // Shaded this frame
+        return;
+    }
+
+    // Reproject into the previous frame. The pixel was hidden there (or off screen) when the
+    // history holds a surface at a different distance.
+    vec4 previousClip = uPreviousViewProjection * vec4(world.xyz, 1.0f);
+    vec2 previousUv = previousClip.xy / previousClip.w * 0.5f + 0.5f;
+    bool disoccluded = !uHistoryValid || previousClip.w <= 0.0f
+        || any(lessThan(previousUv, vec2(0.0f))) || any(greaterThanEqual(previousUv, vec2(1.0f)));
+
+    if (!disoccluded)
+    {
+        vec4 history = texelFetch(uHistory, ivec2(previousUv * vec2(uHistorySize)), 0);
+        if (abs(history.a - previousClip.w) <= 0.02f * previousClip.w)
+        {
+            fragmentColor = vec4(history.rgb, viewDepth);
+            return;
+        }
+    }
+
+    // Refill disocclusions from the four direct neighbors, all of them were shaded this frame
+    ivec2 offsets[4] = ivec2[](ivec2(-1, 0), ivec2(1, 0), ivec2(0, -1), ivec2(0, 1));
+    vec3 sum = vec3(0.0f);
+    float count = 0.0f;
+    for (int i = 0; i < 4; ++i)
+    {
+        ivec2 neighbor = pixel + offsets[i];
+        if (any(lessThan(neighbor, ivec2(0))) || any(greaterThanEqual(neighbor, uSceneSize)))
+            continue;
+
+        sum += texelFetch(uColor, neighbor, 0).rgb;
+        count += 1.0f;
+    }
+    fragmentColor = vec4(sum / max(count, 1.0f), viewDepth);
+}
+);
+
+
+/* Hi-Z Copy Compute Shader Source Code*/
+const GLchar* hiZCopyComputeShaderSource = GLSL(440,
+
+    layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(r32f, binding = 0) uniform writeonly image2D uLevel; // Level 0 of the pyramid
+
+uniform sampler2D uDepth;   // Depth of the scene target
+uniform vec2 uScale;        // Depth texels per pyramid texel, the scene may only cover part of the target
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, imageSize(uLevel))))
+        return;
+
+    // The scene is never larger than the target, so every texel lies within a single depth texel
+    float depth = texelFetch(uDepth, ivec2((vec2(texel) + 0.5f) * uScale), 0).r;
+    imageStore(uLevel, texel, vec4(depth));
+}
+);
+
+
+/* Hi-Z Reduction Compute Shader Source Code*/
+const GLchar* hiZReduceComputeShaderSource = GLSL(440,
+
+    layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(r32f, binding = 0) uniform readonly image2D uSource;   // Previous level
+layout(r32f, binding = 1) uniform writeonly image2D uTarget;  // Level being built
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 targetSize = imageSize(uTarget);
+    if (any(greaterThanEqual(texel, targetSize)))
+        return;
+
+    // Farthest depth of the 2x2 texels below. Along an odd axis the last texel also takes the
+    // leftover row or column, so no source texel is skipped.
+    ivec2 sourceSize = imageSize(uSource);
+    ivec2 last = texel * 2 + 1 + ivec2(equal(texel, targetSize - 1)) * (sourceSize & 1);
+    float depth = 0.0f;
+    for (int y = texel.y * 2; y <= last.y; ++y)
+        for (int x = texel.x * 2; x <= last.x; ++x)
+            depth = max(depth, imageLoad(uSource, min(ivec2(x, y), sourceSize - 1)).r);
+    imageStore(uTarget, texel, vec4(depth));
+}
+);
+
+
+/* Occlusion Culling Compute Shader Source Code*/
+const GLchar* occlusionCullComputeShaderSource = GLSL(440,
+
+    layout(local_size_x = 64) in;
+
+struct CullObject
+{
+    vec4 center;    // World space bounds
+    vec4 extent;
+    mat4 model;
+    uvec4 range;    // First vertex and vertex count
+};
+
+struct DrawCommand
+{
+    uint count;
+    uint instanceCount;
+    uint first;
+    uint baseInstance;
+};
+
+layout(std430, binding = 0) readonly buffer Objects { CullObject objects[]; };
+layout(std430, binding = 1) readonly buffer Candidates { uint candidates[]; };
+layout(std430, binding = 2) buffer Count { uint survivorCount; };
+layout(std430, binding = 3) writeonly buffer DrawCommands { DrawCommand drawCommands[]; };
+layout(std430, binding = 4) writeonly buffer ObjectCommands { DrawCommand objectCommands[]; };
+
+uniform uint uCandidateCount;
+uniform sampler2D uHiZ;
+uniform mat4 uHiZViewProjection;    // Camera the pyramid was rendered with
+uniform bool uHiZValid;
+
+// Whether the box lies entirely behind the depth stored in the pyramid
+bool Occluded(vec3 center, vec3 extent)
+{
+    vec2 uvMin = vec2(1.0f);
+    vec2 uvMax = vec2(0.0f);
+    float nearestDepth = 1.0f;
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        vec3 offset = vec3(ivec3(corner, corner >> 1, corner >> 2) & 1) * 2.0f - 1.0f;
+        vec4 clip = uHiZViewProjection * vec4(center + extent * offset, 1.0f);
+        if (clip.w <= 0.0f)
+            return false; // Reaches behind the camera, the footprint is unbounded
+
+        vec3 ndc = clip.xyz / clip.w;
+        uvMin = min(uvMin, ndc.xy * 0.5f + 0.5f);
+        uvMax = max(uvMax, ndc.xy * 0.5f + 0.5f);
+        nearestDepth = min(nearestDepth, ndc.z * 0.5f + 0.5f);
+    }
+
+    // Nothing is known about objects outside of the previous view
+    if (any(greaterThan(uvMin, vec2(1.0f))) || any(lessThan(uvMax, vec2(0.0f))))
+        return false;
+
+    // Footprint in level 0 texels, then the level at which it spans at most 2x2 texels
+    ivec2 size = textureSize(uHiZ, 0);
+    ivec2 texelMin = ivec2(clamp(uvMin, 0.0f, 1.0f) * vec2(size));
+    ivec2 texelMax = min(ivec2(clamp(uvMax, 0.0f, 1.0f) * vec2(size)), size - 1);
+    ivec2 span = texelMax - texelMin + 1;
+    int level = min(findMSB(max(span.x, span.y) - 1) + 1, textureQueryLevels(uHiZ) - 1);
+
+    // Each level keeps the farthest depth of the texels below it
+    ivec2 levelSize = textureSize(uHiZ, level);
+    ivec2 first = min(texelMin >> level, levelSize - 1);
+    ivec2 last = min(texelMax >> level, levelSize - 1);
+    float farthest = 0.0f;
+    for (int y = first.y; y <= last.y; ++y)
+        for (int x = first.x; x <= last.x; ++x)
+            farthest = max(farthest, texelFetch(uHiZ, ivec2(x, y), level).r);
+
+    return nearestDepth > farthest;
+}
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= uCandidateCount)
+        return;
+
+    uint object = candidates[i];
+    bool visible = !uHiZValid || !Occluded(objects[object].center.xyz, objects[object].extent.xyz);
+    uvec4 range = objects[object].range;
+
+    // Per-object command for draws that bind their own textures, and the compacted list for the rest
+    objectCommands[object] = DrawCommand(range.y, visible ? 1u : 0u, range.x, object);
+    if (visible)
+        drawCommands[atomicAdd(survivorCount, 1u)] = DrawCommand(range.y, 1u, range.x, object);
+}
+);
+
+
+/* Indirect Depth Pre-pass Vertex Shader Source Code*/
+const GLchar* cullDepthVertexShaderSource = GLSL(440,
+
+    layout(location = 0) in vec3 position; // Position-only vertex stream
+layout(location = 1) in uint objectIndex;  // Per draw, selected by the base instance of the command
+
+struct CullObject
+{
+    vec4 center;
+    vec4 extent;
+    mat4 model;
+    uvec4 range;
+};
+
+layout(std430, binding = 0) readonly buffer Objects { CullObject objects[]; };
+
+invariant gl_Position; // Same transform as the main pass, bit for bit
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    gl_Position = projection * view * objects[objectIndex].model * vec4(position, 1.0f); // transforms vertices to clip coordinates
+}
+);
+
+
+/* Flat Vertex Shader Source Code*/
+// Positions only, drawn in plain white by the upload benchmark
+const GLchar* flatVertexShaderSource = GLSL(440,
+
+    layout(location = 0) in vec3 position; // VAP position 0 for vertex position data
+
+        //Uniform / Global variables for the  transform matrices
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(position, 1.0f); // Transforms vertices into clip coordinates
+}
+);
+
+
+/* Flat Fragment Shader Source Code*/
+const GLchar* flatFragmentShaderSource = GLSL(440,
+
+    out vec4 fragmentColor; // For outgoing flat color to the GPU
+
+void main()
+{
+    fragmentColor = vec4(1.0f); // Set color to white (1.0f,1.0f,1.0f) with alpha 1.0
+}
+);
+
+
+// Debug lines: world space positions with a color each
+const GLchar* debugVertexShaderSource = GLSL(440,
+    layout(location = 0) in vec3 position;
+layout(location = 1) in vec4 color;     // Four normalized bytes
+
+out vec4 vertexColor;
+
+uniform mat4 viewProjection;
+
+void main()
+{
+    gl_Position = viewProjection * vec4(position, 1.0f);
+    vertexColor = color;
+}
+);
+
+
+const GLchar* debugFragmentShaderSource = GLSL(440,
+    in vec4 vertexColor;
+
+out vec4 fragmentColor;
+
+void main()
+{
+    fragmentColor = vertexColor;
+}
+);
+
+
+// Images are loaded with Y axis going down, but OpenGL's Y axis goes up, so let's flip it
+void flipImageVertically(unsigned char* image, int width, int height, int channels)
+{
+    for (int j = 0; j < height / 2; ++j)
+    {
+        int index1 = j * width * channels;
+        int index2 = (height - 1 - j) * width * channels;
+
+        for (int i = width * channels; i > 0; --i)
+        {
+            unsigned char tmp = image[index1];
+            image[index1] = image[index2];
+            image[index2] = tmp;
+            ++index1;
+            ++index2;
+        }
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    // The thread creating the GL context is the only one that may make GL calls
+    Jobs().SetMainThread();
+
+    if (!UInitialize(argc, argv, &gWindow))
+        return EXIT_FAILURE;
+
+    // Benchmarks replace the render loop
+    if (!gOptions.benchmark.empty())
+        exit(URunBenchmark(gOptions.benchmark) ? EXIT_SUCCESS : EXIT_FAILURE);
+
+    // Place the objects and lights, the lightmap baker needs their world transforms
+    UCreateSceneGraph();
+    UCreateSceneEntities();
+
+    // Create the mesh
+    UCreateMesh(gMesh); // Calls the function to create the Vertex Buffer Object
+
+    // Scatter the generated instances, they draw ranges of the mesh
+    UCreateStressPrototypes();
+    if (gOptions.stressInstances > 0)
+        UCreateStressScene();
+    if (gOptions.streamInstances > 0 && !UCreateStreamedWorld())
+        return EXIT_FAILURE;
+
+    // Create the shader program
+    if (!UCreateShaderProgram(vertexShaderSource, fragmentShaderSource, gProgramId))
+        return EXIT_FAILURE;
+    if (!UCreateShaderProgram(depthVertexShaderSource, depthFragmentShaderSource, gDepthProgramId))
+        return EXIT_FAILURE;
+    if (!UCreateShaderProgram(depthVertexShaderSource, overdrawFragmentShaderSource, gOverdrawProgramId))
+        return EXIT_FAILURE;
+    if (!UCreateShaderProgram(fullscreenVertexShaderSource, heatmapFragmentShaderSource, gHeatmapProgramId))
+        return EXIT_FAILURE;
+    if (!UCreateShaderProgram(fullscreenVertexShaderSource, upscaleFragmentShaderSource, gUpscaleProgramId))
+        return EXIT_FAILURE;
+    if (!UCreateShaderProgram(fullscreenVertexShaderSource, checkerboardMaskFragmentShaderSource, gCheckerboardMaskProgramId))
+        return EXIT_FAILURE;
+    if (!UCreateShaderProgram(fullscreenVertexShaderSource, checkerboardResolveFragmentShaderSource, gCheckerboardResolveProgramId))
+        return EXIT_FAILURE;
+    if (!UCreateComputeProgram(hiZCopyComputeShaderSource, gHiZCopyProgramId))
+        return EXIT_FAILURE;
+    if (!UCreateComputeProgram(hiZReduceComputeShaderSource, gHiZReduceProgramId))
+        return EXIT_FAILURE;
+    if (!UCreateComputeProgram(occlusionCullComputeShaderSource, gOcclusionCullProgramId))
+        return EXIT_FAILURE;
+    if (!UCreateShaderProgram(cullDepthVertexShaderSource, depthFragmentShaderSource, gCullDepthProgramId))
+        return EXIT_FAILURE;
+
+    // Buffers of the GPU culling pass, filled with the objects placed above
+    UCreateOcclusionCulling();
+
+    // Full screen passes generate their vertices, but core profile still needs a vertex array bound
+    glGenVertexArrays(1, &gFullscreenVao);
+
+    // Geometry rewritten every frame
+    if (!UCreateStreamBuffer(gStreamBuffer, STREAM_REGION_BYTES))
+        return EXIT_FAILURE;
+
+#ifndef NDEBUG
+    // Debug lines are read straight out of the streaming buffer, each draw starting at its offset
+    if (!UCreateShaderProgram(debugVertexShaderSource, debugFragmentShaderSource, gDebugProgramId))
+        return EXIT_FAILURE;
+    glGenVertexArrays(1, &gDebugVao);
+    glBindVertexArray(gDebugVao);
+    glBindBuffer(GL_ARRAY_BUFFER, gStreamBuffer.buffer);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DebugVertex), (void*)offsetof(DebugVertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(DebugVertex), (void*)offsetof(DebugVertex, color));
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+#endif
+
+    // Queries counting shaded fragments
+    glGenQueries(FRAGMENT_QUERY_COUNT, gFragmentQueries);
+
+    // Load texture
+    const char* texFilename = "../../Final Project/resources/textures/glass.jpg";
+    if (!UCreateTexture(texFilename, gTextureGlassId))
+    {
+        cout << "Failed to load texture " << texFilename << endl;
+        return EXIT_FAILURE;
+    }
+    texFilename = "../../Final Project/resources/textures/silver.jpg";
+    if (!UCreateTexture(texFilename, gTextureSilverId))
+    {
+        cout << "Failed to load texture " << texFilename << endl;
+        return EXIT_FAILURE;
+    }
+    texFilename = "../../Final Project/resources/textures/floor.png";
+    if (!UCreateTexture(texFilename, gTextureFloorId))
+    {
+        cout << "Failed to load texture " << texFilename << endl;
+        return EXIT_FAILURE;
+    }
+    texFilename = "../../Final Project/resources/textures/galaxy.jpg";
+    if (!UCreateTexture(texFilename, gTextureBottleId))
+    {
+        cout << "Failed to load texture " << texFilename << endl;
+        return EXIT_FAILURE;
+    }
+
+    // tell opengl for each sampler to which texture unit it belongs to (only has to be done once)
+    glUseProgram(gProgramId);
+    // We set the texture as texture unit 0
+    glUniform1i(glGetUniformLocation(gProgramId, "uTexture"), 0);
+    // and the lightmap as texture unit 1
+    glUniform1i(glGetUniformLocation(gProgramId, "uLightmap"), 1);
+
+    // Sets the background color of the window to black (it will be implicitely used by glClear)
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+    // From here on the camera and the entities are only updated by the simulation thread
+    UStartSimulation();
+
+    if (!gOptions.capturePath.empty())
+        UStartCapture();
+
+    // render loop
+    // -----------
+    while (!glfwWindowShouldClose(gWindow))
+    {
+        // Headless runs stop after the requested number of frames
+        if (gOptions.headless && gFrameIndex >= gOptions.frames)
+            break;
+
+        // Camera and lights of this frame, between the last two states the simulation published
+        const bool changed = UInterpolateSnapshot();
+
+        // Nothing to show that is not on screen already: wait for something to happen instead
+        if (gIdleMode && !gOptions.headless && !changed && !gRedraw)
+        {
+            ++gFrameStats.skippedFrames;
+            UReportFrameStats();
+            UWaitIdle();
+            continue;
+        }
+        gRedraw = false;
+
+        // per-frame timing
+        // --------------------
+        float currentFrame = glfwGetTime();
+        gDeltaTime = currentFrame - gLastFrame;
+        gLastFrame = currentFrame;
+
+        // Pick the resolution of this frame from the time the previous ones took
+        UUpdateDynamicResolution(gDeltaTime);
+
+        // input
+        // -----
+        UProcessInput(gWindow);
+
+        // GL work that jobs handed back to this thread
+        Jobs().RunMainThreadJobs();
+
+        // Render this frame
+        URender();
+
+        UReportFrameStats();
+
+        // Hold the frame rate, then pick up the input as late as possible before the next frame
+        gFrameLimiter.Wait();
+        glfwPollEvents();
+    }
+
+    // Final numbers for headless runs
+    if (gOptions.headless)
+        UReportFrameStats(true);
+
+    gSimulation.Stop();
+    gStreamer.Close();
+    UStopCapture();
+    glDeleteQueries(FRAGMENT_QUERY_COUNT, gFragmentQueries);
+    glDeleteVertexArrays(1, &gFullscreenVao);
+    glDeleteVertexArrays(1, &gDebugVao);
+    UDestroyStreamBuffer(gStreamBuffer);
+    UDestroyOcclusionCulling();
+    UDestroyRenderTarget(gOverdrawTarget);
+    UDestroyRenderTarget(gSceneTarget);
+    UDestroyRenderTarget(gHistoryTargets[0]);
+    UDestroyRenderTarget(gHistoryTargets[1]);
+
+    // Release mesh data
+    UDestroyMesh(gMesh);
+
+    // Release texture
+    UDestroyTexture(gTextureGlassId);
+    UDestroyTexture(gTextureSilverId);
+    UDestroyTexture(gTextureFloorId);
+    UDestroyTexture(gTextureBottleId);
+    UDestroyLightmaps();
+
+    // Release shader program
+    UDestroyShaderProgram(gProgramId);
+    UDestroyShaderProgram(gDebugProgramId);
+    UDestroyShaderProgram(gDepthProgramId);
+    UDestroyShaderProgram(gOverdrawProgramId);
+    UDestroyShaderProgram(gHeatmapProgramId);
+    UDestroyShaderProgram(gUpscaleProgramId);
+    UDestroyShaderProgram(gCheckerboardMaskProgramId);
+    UDestroyShaderProgram(gCheckerboardResolveProgramId);
+    UDestroyShaderProgram(gHiZCopyProgramId);
+    UDestroyShaderProgram(gHiZReduceProgramId);
+    UDestroyShaderProgram(gOcclusionCullProgramId);
+    UDestroyShaderProgram(gCullDepthProgramId);
+
+    exit(EXIT_SUCCESS); // Terminates the program successfully
+}
+
+
+// Initialize GLFW, GLEW, and create a window
+bool UInitialize(int argc, char* argv[], GLFWwindow** window)
+{
+    if (!UParseCommandLine(argc, argv))
+        return false;
+
+    // The checks need no GL context
+    if (gOptions.selfTest)
+        exit(URunSelfTests() ? EXIT_SUCCESS : EXIT_FAILURE);
+
+    // GLFW: initialize and configure
+    // ------------------------------
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 4);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+    // Headless runs still need a GL context, just not a visible window
+    if (gOptions.headless)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    // GLFW: window creation
+    // ---------------------
+    * window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_TITLE, NULL, NULL);
+    if (*window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return false;
+    }
+    glfwMakeContextCurrent(*window);
+    UApplyVsync();
+    gFrameLimiter.SetTargetFps(gOptions.maxFps);
+    glfwSetFramebufferSizeCallback(*window, UResizeWindow);
+    glfwSetWindowRefreshCallback(*window, UWindowRefreshCallback);
+    glfwSetCursorPosCallback(*window, UMousePositionCallback);
+    glfwSetScrollCallback(*window, UMouseScrollCallback);
+    glfwSetMouseButtonCallback(*window, UMouseButtonCallback);
+    glfwSetKeyCallback(*window, UKeyCallback);
+
+    // tell GLFW to capture our mouse
+    if (!gOptions.headless)
+        glfwSetInputMode(*window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    // GLEW: initialize
+    // ----------------
+    // Note: if using GLEW version 1.13 or earlier
+    glewExperimental = GL_TRUE;
+    GLenum GlewInitResult = glewInit();
+
+    if (GLEW_OK != GlewInitResult)
+    {
+        std::cerr << glewGetErrorString(GlewInitResult) << std::endl;
+        return false;
+    }
+
+    // Displays GPU OpenGL version
+    cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << endl;
+
+    return true;
+}
+
+
+// Reads the command line options, prints the usage and returns false on bad input
+bool UParseCommandLine(int argc, char* argv[])
+{
+    bool vsyncGiven = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        const string arg = argv[i];
+        if (arg == "--headless")
+            gOptions.headless = true;
+        else if (arg == "--frames" && i + 1 < argc)
+            gOptions.frames = unsigned(atoi(argv[++i]));
+        else if (arg == "--prepass")
+            gDepthPrepass = true;
+        else if (arg == "--no-lightmap")
+            gUseLightmap = false;
+        else if (arg == "--overdraw")
+            gOverdrawView = OVERDRAW_FRAGMENTS;
+        else if (arg == "--overdraw-lights")
+            gOverdrawView = OVERDRAW_LIGHTS;
+        else if (arg == "--full-resolution")
+            gDynamicResolution = false;
+        else if (arg == "--target-ms" && i + 1 < argc)
+            gOptions.targetFrameTimeMs = float(atof(argv[++i]));
+        else if (arg == "--checkerboard")
+            gCheckerboard = true;
+        else if (arg == "--no-culling")
+            gFrustumCulling = false;
+        else if (arg == "--occlusion")
+            gOcclusion = OCCLUSION_GPU;
+        else if (arg == "--occlusion-cpu")
+            gOcclusion = OCCLUSION_CPU;
+        else if (arg == "--no-lod")
+            gLevelOfDetail = false;
+        else if (arg == "--stress" && i + 1 < argc)
+            gOptions.stressInstances = size_t(atof(argv[++i]));
+        else if (arg == "--stream" && i + 1 < argc)
+            gOptions.streamInstances = size_t(atof(argv[++i]));
+        else if (arg == "--stream-budget" && i + 1 < argc)
+            gOptions.streamBudgetMb = size_t(atoi(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc)
+            gOptions.stressSeed = uint32_t(atoi(argv[++i]));
+        else if (arg == "--vsync" && i + 1 < argc && (string(argv[i + 1]) == "off" || string(argv[i + 1]) == "on" || string(argv[i + 1]) == "adaptive"))
+        {
+            const string mode = argv[++i];
+            gVsync = mode == "off" ? VSYNC_OFF : mode == "on" ? VSYNC_ON : VSYNC_ADAPTIVE;
+            vsyncGiven = true;
+        }
+        else if (arg == "--no-idle")
+            gIdleMode = false;
+        else if (arg == "--max-fps" && i + 1 < argc)
+            gOptions.maxFps = atof(argv[++i]);
+        else if (arg == "--capture" && i + 1 < argc)
+            gOptions.capturePath = argv[++i];
+        else if (arg == "--capture-margin" && i + 1 < argc)
+            gOptions.captureMargin = std::max(float(atof(argv[++i])), 0.0f) / 100.0f;
+        else if (arg == "--self-test")
+            gOptions.selfTest = true;
+        else if (arg == "--benchmark" && i + 1 < argc)
+        {
+            gOptions.benchmark = argv[++i];
+            gOptions.headless = true;
+        }
+        else
+        {
+            cout << "Usage: " << argv[0] << " [--headless] [--frames N] [--prepass] [--no-lightmap] [--overdraw | --overdraw-lights] [--full-resolution] [--target-ms MS] [--checkerboard] [--no-culling] [--occlusion | --occlusion-cpu] [--no-lod] [--stress N] [--stream N] [--stream-budget MB] [--seed S] [--vsync off|on|adaptive] [--max-fps N] [--no-idle] [--capture FILE.y4m|PREFIX] [--capture-margin PERCENT] [--benchmark ecs|bvh|occlusion|pick|stress|streaming|jobs|upload] [--self-test]" << endl;
+            return false;
+        }
+    }
+
+    // Headless runs measure how fast frames render, so they leave vsync off unless asked
+    if (gOptions.headless && !vsyncGiven)
+        gVsync = VSYNC_OFF;
+
+    return true;
+}
+
+
+// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly.
+// Camera movement is not polled here: UKeyCallback queues the movement keys for the simulation thread.
+void UProcessInput(GLFWwindow* window)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+
+    //Change projections between ortho and perspective
+    //if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS)
+        //changeProjection = !changeProjection;
+}
+
+
+// glfw: whenever the window size changed (by OS or user resize) this callback function executes
+void UResizeWindow(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+    gRedraw = true;
+}
+
+
+// glfw: whenever the window contents need repainting (uncovered, restored), this callback is called
+void UWindowRefreshCallback(GLFWwindow* window)
+{
+    gRedraw = true;
+}
+
+
+// glfw: whenever the mouse moves, this callback is called
+// -------------------------------------------------------
+void UMousePositionCallback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (gFirstMouse)
+    {
+        gLastX = xpos;
+        gLastY = ypos;
+        gFirstMouse = false;
+    }
+
+    float xoffset = xpos - gLastX;
+    float yoffset = gLastY - ypos; // reversed since y-coordinates go from bottom to top
+
+    gLastX = xpos;
+    gLastY = ypos;
+
+    // The simulation thread turns its camera
+    gInputQueue.Push(InputEvent{ INPUT_MOUSE_MOVE, 0, 0, xoffset, yoffset, glfwGetTime() });
+}
+
+
+// glfw: whenever the mouse scroll wheel scrolls, this callback is called
+// ----------------------------------------------------------------------
+void UMouseScrollCallback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    // The simulation thread zooms its camera
+    gInputQueue.Push(InputEvent{ INPUT_SCROLL, 0, 0, 0.0f, float(yoffset), glfwGetTime() });
+}
+
+// glfw: handle mouse button events
+// --------------------------------
+void UMouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
+{
+    switch (button)
+    {
+    case GLFW_MOUSE_BUTTON_LEFT:
+    {
+        if (action == GLFW_PRESS)
+        {
+            cout << "Left mouse button pressed" << endl;
+            UPickObject();
+        }
+        else
+            cout << "Left mouse button released" << endl;
+    }
+    break;
+
+    case GLFW_MOUSE_BUTTON_MIDDLE:
+    {
+        if (action == GLFW_PRESS)
+            cout << "Middle mouse button pressed" << endl;
+        else
+            cout << "Middle mouse button released" << endl;
+    }
+    break;
+
+    case GLFW_MOUSE_BUTTON_RIGHT:
+    {
+        if (action == GLFW_PRESS)
+            cout << "Right mouse button pressed" << endl;
+        else
+            cout << "Right mouse button released" << endl;
+    }
+    break;
+
+    default:
+        cout << "Unhandled mouse button event" << endl;
+        break;
+    }
+}
+
+
+// glfw: handle key presses that toggle render modes
+// -------------------------------------------------
+void UKeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    // Presses and releases go to the simulation thread, which keeps the movement keys held down
+    if (action != GLFW_REPEAT)
+        gInputQueue.Push(InputEvent{ INPUT_KEY, key, action, 0.0f, 0.0f, glfwGetTime() });
+
+    if (action != GLFW_PRESS)
+        return;
+
+    switch (key)
+    {
+    case GLFW_KEY_L:
+        if (!gLightmapsBaked)
+        {
+            cout << "Lightmap mode unavailable: the lightmaps could not be baked" << endl;
+            break;
+        }
+        gUseLightmap = !gUseLightmap;
+        cout << "Lightmap mode " << (gUseLightmap ? "on" : "off") << endl;
+        break;
+
+    case GLFW_KEY_Z:
+        gDepthPrepass = !gDepthPrepass;
+        cout << "Depth pre-pass " << (gDepthPrepass ? "on" : "off") << endl;
+        break;
+
+    case GLFW_KEY_R:
+        gDynamicResolution = !gDynamicResolution;
+        cout << "Dynamic resolution " << (gDynamicResolution ? "on" : "off") << endl;
+        break;
+
+    case GLFW_KEY_C:
+        gCheckerboard = !gCheckerboard;
+        cout << "Checkerboard shading " << (gCheckerboard ? "on" : "off") << endl;
+        break;
+
+    case GLFW_KEY_F:
+        gFrustumCulling = !gFrustumCulling;
+        cout << "Frustum culling " << (gFrustumCulling ? "on" : "off") << endl;
+        break;
+
+    case GLFW_KEY_O:
+        // Cycles off -> GPU -> CPU
+        gOcclusion = OcclusionMode((gOcclusion + 1) % 3);
+        cout << "Occlusion culling " << (gOcclusion == OCCLUSION_GPU ? "on the GPU" : gOcclusion == OCCLUSION_CPU ? "on the CPU" : "off") << endl;
+        break;
+
+    case GLFW_KEY_V:
+        // Cycles on -> adaptive -> off
+        gVsync = VsyncMode((gVsync + 1) % 3);
+        UApplyVsync();
+        cout << "Vsync " << (gVsync == VSYNC_ON ? "on" : gVsync == VSYNC_ADAPTIVE ? "adaptive" : "off") << endl;
+        break;
+
+    case GLFW_KEY_B:
+#ifndef NDEBUG
+        gDebugView = !gDebugView;
+        gDebugFrustumValid = false;
+        cout << "Debug view " << (gDebugView ? "on" : "off") << endl;
+#else
+        cout << "Debug view is left out of release builds" << endl;
+#endif
+        break;
+
+    case GLFW_KEY_K:
+        gLevelOfDetail = !gLevelOfDetail;
+        cout << "Level of detail " << (gLevelOfDetail ? "on" : "off") << endl;
+        break;
+
+    case GLFW_KEY_H:
+        // Cycles normal shading -> fragments per pixel -> lights per pixel
+        gOverdrawView = OverdrawView((gOverdrawView + 1) % 3);
+        if (gOverdrawView == OVERDRAW_FRAGMENTS)
+            cout << "Overdraw view: fragments shaded per pixel (blue = 1, red = " << HEATMAP_MAX_COUNT << "+)" << endl;
+        else if (gOverdrawView == OVERDRAW_LIGHTS)
+            cout << "Overdraw view: lights evaluated per pixel (blue = 1, red = " << HEATMAP_MAX_COUNT * SHADER_LIGHT_COUNT << "+)" << endl;
+        else
+            cout << "Overdraw view off" << endl;
+        break;
+
+    default:
+        break;
+    }
+}
+
+
+// Local transform of the scene root, which places every object of the scene
+glm::mat4 UModelMatrix()
+{
+    // 1. Scales the object by 2
+    glm::mat4 scale = glm::scale(glm::vec3(2.0f, 2.0f, 2.0f));
+    // 2. Rotates shape by 15 degrees in the x axis
+    glm::mat4 rotation = glm::rotate(45.0f, glm::vec3(1.0, 1.0f, 1.0f));
+    // 3. Place object at the origin
+    glm::mat4 translation = glm::translate(glm::vec3(0.0f, 0.0f, 0.0f));
+    // Model matrix: transformations are applied right-to-left order
+    return translation * rotation * scale;
+}
+
+
+// Builds the transform hierarchy: the root carries the model matrix and every object is a child
+// of it, with an identity local transform since the mesh vertices are already laid out together
+void UCreateSceneGraph()
+{
+    gSceneRoot = gScene.AddNode("Scene", SceneGraph::NO_PARENT, UModelMatrix());
+    for (int i = 0; i < OBJECT_COUNT; ++i)
+        gObjects[i].node = gScene.AddNode(gObjects[i].name, gSceneRoot, glm::mat4(1.0f), i);
+
+    gScene.Update();
+}
+
+
+// Moves the model space bounds of every object into world space, into the culling arrays
+void UUpdateCullBounds()
+{
+    gCullBounds.Resize(OBJECT_COUNT);
+    for (int i = 0; i < OBJECT_COUNT; ++i)
+        gCullBounds.Set(i, gScene.World(gObjects[i].node), gObjects[i].center, gObjects[i].extent);
+
+    // The GPU culling pass keeps its own copy, once it exists
+    if (gCullBuffers.objects != 0)
+        UUploadCullObjects();
+
+    // So does picking, which refits its object level
+    if (gPickScene.ObjectCount() == OBJECT_COUNT)
+    {
+        for (int i = 0; i < OBJECT_COUNT; ++i)
+            gPickScene.SetTransform(i, gScene.World(gObjects[i].node));
+        gPickScene.Update();
+    }
+}
+
+
+// Creates the entities of the scene: the two lights the forward shader evaluates
+void UCreateSceneEntities()
+{
+    const glm::vec3 lightPosition(1.5f, 4.5f, 3.0f);
+    const WorldTransform world = { glm::mat4(1.0f) };
+    gEntities.Create(LocalTransform{ lightPosition, glm::vec3(0.0f), glm::vec3(1.0f) }, world, PointLight{ glm::vec3(1.0f, 1.0f, 1.0f), 1.0f });
+    gEntities.Create(LocalTransform{ lightPosition, glm::vec3(0.0f), glm::vec3(1.0f) }, world, PointLight{ glm::vec3(0.0f, 1.0f, 0.0f), 1.0f });
+
+    UpdateTransforms(gEntities, 0.0f);
+    ExtractLights(gEntities, gLights);
+}
+
+
+// Builds the picking BVHs: one triangle BVH per object over its full detail vertices in model space,
+// placed by the object's world transform
+void UCreatePickScene()
+{
+    const double start = glfwGetTime();
+    for (int i = 0; i < OBJECT_COUNT; ++i)
+    {
+        std::vector<glm::vec3> positions(gObjects[i].nVertices);
+        for (GLsizei v = 0; v < gObjects[i].nVertices; ++v)
+        {
+            const GLfloat* position = &gMeshPositions[(gObjects[i].firstVertex + v) * 3];
+            positions[v] = glm::vec3(position[0], position[1], position[2]);
+        }
+        gPickScene.AddObject(gPickScene.AddMesh(positions), gScene.World(gObjects[i].node));
+    }
+    gPickScene.Update();
+
+    cout << "INFO: Built the picking BVHs over " << gPickScene.TriangleCount() << " triangles in "
+        << (glfwGetTime() - start) * 1000.0 << " ms" << endl;
+}
+
+
+// Picks the object under the crosshair: the cursor is captured by the camera, so the ray goes through
+// the center of the screen
+void UPickObject()
+{
+    const glm::mat4 view = gCamera.GetViewMatrix();
+    const glm::mat4 projection = glm::perspective(glm::radians(gCamera.Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+    glm::vec3 origin, direction;
+    ScreenRay(glm::inverse(projection * view), 0.0f, 0.0f, origin, direction);
+
+    const double start = glfwGetTime();
+    PickScene::Hit hit;
+    const bool found = gPickScene.Pick(origin, direction, FLT_MAX, hit);
+    const double pickUs = (glfwGetTime() - start) * 1000000.0;
+
+    if (found)
+        cout << "Picked " << gObjects[hit.object].name << " at (" << hit.point.x << ", " << hit.point.y << ", " << hit.point.z
+            << "), triangle " << hit.triangle << ", distance " << hit.distance << " (" << pickUs << " us)" << endl;
+    else
+        cout << "Picked nothing (" << pickUs << " us)" << endl;
+}
+
+
+// Every object but the floor can be instanced, at full detail
+void UCreateStressPrototypes()
+{
+    gStressPrototypes.clear();
+    for (int i = 1; i < OBJECT_COUNT; ++i)
+        gStressPrototypes.push_back({ uint32_t(gObjects[i].firstVertex), uint32_t(gObjects[i].nVertices), gObjects[i].center, gObjects[i].extent });
+}
+
+
+// Scatters the instances of the stress scene
+void UCreateStressScene()
+{
+    const double start = glfwGetTime();
+    const StressSceneInfo info = GenerateStressScene(gEntities, gStressPrototypes, MATERIAL_COUNT, gOptions.stressInstances, gOptions.stressSeed);
+    UpdateTransforms(gEntities, 0.0f);
+    ExtractLights(gEntities, gLights);
+
+    cout << "INFO: Generated a stress scene of " << info.instances << " instances (" << info.triangles << " triangles) and "
+        << info.lights << " lights over " << info.halfSize * 2.0f << " units with seed " << gOptions.stressSeed << " in "
+        << (glfwGetTime() - start) * 1000.0 << " ms" << endl;
+}
+
+
+// Writes a stress scene of --stream instances to the chunk file and starts streaming it
+bool UCreateStreamedWorld()
+{
+    std::vector<StressInstance> instances;
+    std::vector<StressLight> lights;
+    const StressSceneInfo info = ScatterStressScene(gStressPrototypes, MATERIAL_COUNT, gOptions.streamInstances, gOptions.stressSeed, instances, lights);
+    if (!SaveWorldChunks(WORLD_CHUNKS_PATH, WORLD_CHUNK_SIZE, instances, lights))
+    {
+        cout << "ERROR::STREAMING::WRITE_FAILED " << WORLD_CHUNKS_PATH << endl;
+        return false;
+    }
+
+    ChunkStreamer::Settings settings;
+    settings.memoryBudget = gOptions.streamBudgetMb << 20;
+    if (!gStreamer.Open(WORLD_CHUNKS_PATH, settings))
+    {
+        cout << "ERROR::STREAMING::OPEN_FAILED " << WORLD_CHUNKS_PATH << endl;
+        return false;
+    }
+    gChunkEntities.assign(gStreamer.ChunkCount(), std::vector<Entity>());
+    gLastCameraPosition = gSimulationCamera.Position;
+
+    cout << "INFO: Streaming " << info.instances << " instances and " << info.lights << " lights in " << gStreamer.ChunkCount()
+        << " chunks of " << WORLD_CHUNK_SIZE << " units from " << WORLD_CHUNKS_PATH << ", budget " << gOptions.streamBudgetMb << " MB" << endl;
+    return true;
+}
+
+
+// Requests the chunks around the camera and where it is heading, destroys the entities of the evicted
+// ones and creates those of the chunks that finished loading, up to the per-step budget. Returns whether
+// any entity was created or destroyed.
+bool UStreamWorld(float deltaTime)
+{
+    if (!gStreamer.IsOpen())
+        return false;
+
+    const glm::vec3 velocity = deltaTime > 0.0f ? (gSimulationCamera.Position - gLastCameraPosition) / deltaTime : glm::vec3(0.0f);
+    gLastCameraPosition = gSimulationCamera.Position;
+
+    std::vector<uint32_t> evicted;
+    gStreamer.Update(gSimulationCamera.Position, velocity, evicted);
+    for (uint32_t chunk : evicted)
+    {
+        for (Entity entity : gChunkEntities[chunk])
+            gEntities.Destroy(entity);
+        gChunkEntities[chunk].clear();
+    }
+
+    bool changed = !evicted.empty();
+    size_t spawned = 0;
+    ChunkStreamer::LoadedChunk loaded;
+    while (spawned < STREAM_SPAWN_BUDGET && gStreamer.TakeLoaded(loaded))
+    {
+        changed = true;
+        SpawnStressScene(gEntities, gStressPrototypes, loaded.data.instances.data(), loaded.data.instances.size(),
+            loaded.data.lights.data(), loaded.data.lights.size(), &gChunkEntities[loaded.chunk]);
+        spawned += loaded.data.instances.size();
+
+        const ChunkEntry& entry = gStreamer.Entry(loaded.chunk);
+        cout << "INFO: Streamed in chunk (" << entry.x << ", " << entry.z << "): " << entry.nInstances << " instances, "
+            << entry.nLights << " lights, " << loaded.latencyMs << " ms after the request" << endl;
+    }
+    return changed;
+}
+
+
+// Publishes the scene as set up so far and starts stepping it on the simulation thread
+void UStartSimulation()
+{
+    gSimulationCamera = gCamera;
+    gPublishedCamera = { gCamera.Position, gCamera.Front, gCamera.Up, gCamera.Right, gCamera.Zoom };
+    gPublishedLights = gLights;
+    UPublishSnapshot(0.0);
+    gSimulation.Start(SIMULATION_STEP, USimulationStep, UPublishSnapshot);
+}
+
+
+// One step of the simulation thread: applies the queued input, moves the camera, streams the world
+// around it, then runs the transform system
+void USimulationStep()
+{
+    const float deltaTime = float(SIMULATION_STEP);
+
+    InputEvent event;
+    while (gInputQueue.Pop(event))
+    {
+        gSimulationChanged = true;
+        if (gOldestInputTime == 0.0 || event.time < gOldestInputTime)
+            gOldestInputTime = event.time;
+
+        switch (event.type)
+        {
+        case INPUT_KEY:
+        {
+            const bool held = event.action == GLFW_PRESS;
+            if (event.key == GLFW_KEY_W)
+                gMovementKeys[FORWARD] = held;
+            else if (event.key == GLFW_KEY_S)
+                gMovementKeys[BACKWARD] = held;
+            else if (event.key == GLFW_KEY_A)
+                gMovementKeys[LEFT] = held;
+            else if (event.key == GLFW_KEY_D)
+                gMovementKeys[RIGHT] = held;
+            //Controls up and down movement
+            else if (event.key == GLFW_KEY_Q)
+                gMovementKeys[DOWN] = held;
+            else if (event.key == GLFW_KEY_E)
+                gMovementKeys[UP] = held;
+        }
+        break;
+
+        case INPUT_MOUSE_MOVE:
+            gSimulationCamera.ProcessMouseMovement(event.x, event.y);
+            break;
+
+        case INPUT_SCROLL:
+            gSimulationCamera.ProcessMouseScroll(event.y);
+            if (gSimulationCamera.MovementSpeed < 2.5f)
+                gSimulationCamera.MovementSpeed = 2.5f;
+
+            // If wheel is scrolled forward to speed up the camera the speed at which the camera moves is capped at 10.0f
+            if (gSimulationCamera.MovementSpeed > 10.0f)
+                gSimulationCamera.MovementSpeed = 10.0f;
+            break;
+        }
+    }
+
+    for (int movement = FORWARD; movement <= UP; ++movement)
+    {
+        if (gMovementKeys[movement])
+        {
+            gSimulationCamera.ProcessKeyboard(Camera_Movement(movement), deltaTime);
+            gSimulationChanged = true;
+        }
+    }
+
+    // Bring in the chunks around the camera and drop the far ones, before the entity systems run
+    const bool streamed = UStreamWorld(deltaTime);
+
+    // Transforms only change when entities move on their own or were just created
+    const bool moving = !gEntities.Chunks<Motion>().empty();
+    if (streamed || moving)
+    {
+        UpdateTransforms(gEntities, deltaTime);
+        gSimulationChanged = true;
+    }
+}
+
+
+// Fills the simulation's copy of the snapshot from the current state and hands it to the render thread
+void UPublishSnapshot(double time)
+{
+    // Nothing changed: the last snapshot still holds, and extracting the same state again is wasted
+    if (!gSimulationChanged)
+    {
+        gPublishSkipped = true;
+        return;
+    }
+    gSimulationChanged = false;
+
+    SimulationSnapshot& snapshot = gSnapshots.WriteBuffer();
+    snapshot.tick = gSimulation.Ticks();
+    snapshot.time = time;
+    // After a pause the published state held until a step ago, interpolate over that step only
+    snapshot.previousTime = gPublishSkipped ? std::max(gPublishedTime, time - SIMULATION_STEP) : gPublishedTime;
+    gPublishSkipped = false;
+    snapshot.camera = { gSimulationCamera.Position, gSimulationCamera.Front, gSimulationCamera.Up, gSimulationCamera.Right, gSimulationCamera.Zoom };
+    snapshot.previousCamera = gPublishedCamera;
+    snapshot.inputTime = gOldestInputTime;
+    gOldestInputTime = 0.0;
+    ExtractLights(gEntities, snapshot.lights);
+    snapshot.previousLights = gPublishedLights;
+    if (gOptions.stressInstances > 0 || gOptions.streamInstances > 0)
+        ExtractDraws(gEntities, gSimulationCamera.Position, snapshot.draws);
+
+    gPublishedTime = snapshot.time;
+    gPublishedCamera = snapshot.camera;
+    gPublishedLights = snapshot.lights;
+    gSnapshots.Publish();
+
+    if (gIdle)
+        glfwPostEmptyEvent();
+}
+
+
+// Sets gCamera and gLights between the two states of the latest snapshot, at how far the simulation's
+// clock has moved past it. Instances are drawn as published: they do not move on their own. Returns
+// whether the result can differ from the last frame's.
+bool UInterpolateSnapshot()
+{
+    const bool acquired = gSnapshots.Acquire();
+    const SimulationSnapshot& snapshot = gSnapshots.ReadBuffer();
+
+    const double interval = snapshot.time - snapshot.previousTime;
+    const float alpha = interval > 0.0 ? float(std::min(std::max((gSimulation.Now() - snapshot.time) / interval, 0.0), 1.0)) : 1.0f;
+    const CameraState& from = snapshot.previousCamera;
+    const CameraState& to = snapshot.camera;
+    gCamera.Position = from.position + (to.position - from.position) * alpha;
+    gCamera.Front = glm::normalize(from.front + (to.front - from.front) * alpha);
+    gCamera.Up = glm::normalize(from.up + (to.up - from.up) * alpha);
+    gCamera.Right = glm::normalize(from.right + (to.right - from.right) * alpha);
+    gCamera.Zoom = from.zoom + (to.zoom - from.zoom) * alpha;
+
+    // Lights streamed in or out between the two states leave nothing to pair them with
+    gLights = snapshot.lights;
+    if (snapshot.previousLights.size() == gLights.size())
+    {
+        for (size_t i = 0; i < gLights.size(); ++i)
+        {
+            const LightPacket& previous = snapshot.previousLights[i];
+            gLights[i].position = previous.position + (gLights[i].position - previous.position) * alpha;
+        }
+    }
+
+    // Still on the way from one state to the other, or a state not shown yet
+    return acquired || alpha < 1.0f;
+}
+
+
+// Blocks the render loop until a window event arrives, the simulation publishes or IDLE_TIMEOUT
+// passes. The simulation only posts its wake up event once gIdle is set, so a snapshot published
+// just before is caught by checking for one after setting it.
+void UWaitIdle()
+{
+    gIdle = true;
+    if (gSnapshots.Fresh())
+        glfwPollEvents();
+    else
+        glfwWaitEventsTimeout(IDLE_TIMEOUT);
+    gIdle = false;
+
+    // The time spent waiting belongs to no frame
+    gLastFrame = glfwGetTime();
+    gLastPresent = 0.0;
+}
+
+
+// Runs the named CPU benchmark, returns false when there is no such benchmark
+bool URunBenchmark(const string& name)
+{
+    if (name == "ecs")
+    {
+        RunEntityBenchmark();
+        return true;
+    }
+    if (name == "bvh")
+    {
+        RunBvhBenchmark();
+        return true;
+    }
+    if (name == "occlusion")
+    {
+        RunOcclusionBenchmark();
+        return true;
+    }
+    if (name == "pick")
+    {
+        RunPickBenchmark();
+        return true;
+    }
+    if (name == "stress")
+    {
+        // --stress picks a single size
+        if (gOptions.stressInstances > 0)
+            RunStressBenchmark({ gOptions.stressInstances }, gOptions.stressSeed);
+        else
+            RunStressBenchmark({ 1000, 100000, 1000000 }, gOptions.stressSeed);
+        return true;
+    }
+    if (name == "jobs")
+    {
+        RunJobBenchmark(gOptions.stressInstances > 0 ? gOptions.stressInstances : 1000000, gOptions.stressSeed);
+        return true;
+    }
+    if (name == "upload")
+    {
+        URunUploadBenchmark();
+        return true;
+    }
+    if (name == "streaming")
+    {
+        RunStreamingBenchmark(gOptions.streamInstances > 0 ? gOptions.streamInstances : 100000, gOptions.stressSeed, gOptions.streamBudgetMb << 20, STREAM_SPAWN_BUDGET);
+        return true;
+    }
+
+    cout << "ERROR::BENCHMARK::UNKNOWN " << name << endl;
+    return false;
+}
+
+
+// Runs every check of the CPU kernels, returns whether they all passed
+bool URunSelfTests()
+{
+    bool passed = true;
+    const auto check = [&](const char* name, bool result)
+    {
+        cout << (result ? "PASS: " : "FAIL: ") << name << endl;
+        passed = passed && result;
+    };
+
+    check("frustum culling kernel matches the scalar one", CheckCullBounds());
+    check("occlusion rasterizer hides the right boxes, its rows match the scalar ones", CheckOcclusionRasterizer());
+    return passed;
+}
+
+
+// Functioned called to render a frame
+void URender()
+{
+    if (!Jobs().IsMainThread())
+    {
+        cout << "ERROR::JOBS::GL_CALL_OFF_MAIN_THREAD URender" << endl;
+        return;
+    }
+
+    // Dynamic geometry of this frame goes to the next region of the streaming buffer
+    UBeginStreamFrame(gStreamBuffer);
+
+    // Enable z-depth
+    glEnable(GL_DEPTH_TEST);
+
+    // Refresh the world matrices of whatever moved since the last frame, and their bounds
+    if (gScene.Update() > 0)
+        UUpdateCullBounds();
+
+    // camera/view transformation
+    glm::mat4 view = gCamera.GetViewMatrix();
+
+    // Creates a perspective projection
+    glm::mat4 projection = glm::perspective(glm::radians(gCamera.Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+
+    //Switch between ortho and perspective projections
+    /*glm::mat4 projection;
+        if (changeProjection) {
+            glm::mat4 projection = glm::perspective(glm::radians(gCamera.Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+        }
+        else {
+            glm::mat4 projection = glm::ortho(-5.0f, 5.0f, -5.0f, 5.0f, 0.1f, 100.0f);
+        }*/
+
+        // Set the shader to be used
+    glUseProgram(gProgramId);
+
+    // Retrieves and passes transform matrices to the Shader program
+    // (the model matrix is set per object from the scene graph)
+    GLint modelLoc = glGetUniformLocation(gProgramId, "model");
+    GLint viewLoc = glGetUniformLocation(gProgramId, "view");
+    GLint projLoc = glGetUniformLocation(gProgramId, "projection");
+
+    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
+
+    // Reference matrix uniforms from the Cube Shader program for the cub color, light color, light position, and camera position
+    GLint objectColorLoc = glGetUniformLocation(gProgramId, "objectColor");
+    GLint viewPositionLoc = glGetUniformLocation(gProgramId, "viewPosition");
+
+    // Pass color, light, and camera data to the Cube Shader program's corresponding uniforms
+    glUniform3f(objectColorLoc, gObjectColor.r, gObjectColor.g, gObjectColor.b);
+
+    // The shader takes the first SHADER_LIGHT_COUNT extracted lights, missing ones are black
+    const char* const lightColorNames[SHADER_LIGHT_COUNT] = { "lightColor", "lightColor2" };
+    const char* const lightPositionNames[SHADER_LIGHT_COUNT] = { "lightPos", "lightPos2" };
+    for (int i = 0; i < SHADER_LIGHT_COUNT; ++i)
+    {
+        const LightPacket light = i < int(gLights.size()) ? gLights[i] : LightPacket{ glm::vec3(0.0f), glm::vec3(0.0f) };
+        glUniform3fv(glGetUniformLocation(gProgramId, lightColorNames[i]), 1, glm::value_ptr(light.color));
+        glUniform3fv(glGetUniformLocation(gProgramId, lightPositionNames[i]), 1, glm::value_ptr(light.position));
+    }
+    const glm::vec3 cameraPosition = gCamera.Position;
+    glUniform3f(viewPositionLoc, cameraPosition.x, cameraPosition.y, cameraPosition.z);
+
+    GLint UVScaleLoc = glGetUniformLocation(gProgramId, "uvScale");
+    glUniform2fv(UVScaleLoc, 1, glm::value_ptr(gUVScale));
+
+    glUniform1i(glGetUniformLocation(gProgramId, "uUseLightmap"), gUseLightmap);
+
+    // Only the objects in view are drawn, front to back so nearer objects reject the fragments behind them
+    int drawOrder[OBJECT_COUNT];
+    int nDraws = UCullObjects(projection * view, drawOrder);
+    if (gOcclusion == OCCLUSION_CPU)
+        nDraws = URasterizeOcclusion(projection * view, drawOrder, nDraws);
+    USortFrontToBack(drawOrder, nDraws);
+    USelectLods(projection, drawOrder, nDraws);
+    if (gDebugView)
+        UQueueDebugView(projection * view, drawOrder, nDraws);
+
+    // The overdraw view replaces the normal shading
+    if (gOverdrawView != OVERDRAW_OFF)
+    {
+        URenderOverdraw(view, projection, drawOrder, nDraws);
+        gHiZValid = false;
+
+        UDrawDebug(projection * view);
+        UPresentFrame();
+        return;
+    }
+
+    // With dynamic resolution the scene goes to the lower left part of the offscreen target.
+    // Checkerboard shading and occlusion culling render offscreen too, they read the depth of the scene.
+    int width, height;
+    glfwGetFramebufferSize(gWindow, &width, &height);
+    const bool offscreen = (gDynamicResolution || gCheckerboard || gOcclusion == OCCLUSION_GPU) && UEnsureRenderTarget(gSceneTarget, width, height, GL_RGBA8);
+    const bool occlusion = offscreen && gOcclusion == OCCLUSION_GPU;
+    const bool checkerboard = offscreen && gCheckerboard && UEnsureCheckerboardTargets(width, height);
+    const float scale = offscreen && gDynamicResolution ? gResolutionScale : 1.0f;
+    const int sceneWidth = std::max(1, int(width * scale));
+    const int sceneHeight = std::max(1, int(height * scale));
+    gFrameStats.resolutionScale = scale;
+
+    if (offscreen)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, gSceneTarget.fbo);
+        glViewport(0, 0, sceneWidth, sceneHeight);
+    }
+
+    // Clear the frame, z and stencil buffers
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+    // Decide on the GPU which of the objects in view are hidden behind last frame's depth
+    if (occlusion)
+        UCullOccludedObjects(drawOrder, nDraws);
+    else if (gOcclusion == OCCLUSION_OFF)
+        gFrameStats.occludedObjects = 0;
+
+    // With the pre-pass the depth buffer is final before shading: only fragments matching it get shaded.
+    // Checkerboard shading always runs it, the pixels it skips are reprojected with the full depth.
+    const bool prepass = gDepthPrepass || checkerboard;
+    if (prepass)
+    {
+        UDrawDepthPrepass(view, projection, drawOrder, nDraws, occlusion);
+        glUseProgram(gProgramId);
+        glDepthFunc(GL_EQUAL);
+        glDepthMask(GL_FALSE);
+    }
+
+    // Only shade the pixels of this frame's parity
+    if (checkerboard)
+    {
+        UWriteCheckerboardMask(gFrameIndex & 1);
+        glUseProgram(gProgramId);
+    }
+
+    // Count the fragments shaded by the main pass
+    const int query = gFrameIndex % FRAGMENT_QUERY_COUNT;
+    UReadFragmentQuery(query);
+    glBeginQuery(GL_SAMPLES_PASSED, gFragmentQueries[query]);
+    gFragmentQueryPending[query] = true;
+    gFragmentQueryPrepass[query] = prepass;
+
+    // Activate the VBOs contained within the mesh's VAO
+    glBindVertexArray(gMesh.vao);
+
+    // Draws every visible object with its transform, texture and lightmap. With occlusion culling
+    // each object draws its own command, which has no instance when the GPU found it hidden.
+    if (occlusion)
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, gCullBuffers.objectCommands);
+    for (int i = 0; i < nDraws; ++i)
+    {
+        const SceneObject& object = gObjects[drawOrder[i]];
+        const LodLevel& level = object.lods[object.lod];
+
+        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(gScene.World(object.node)));
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, *object.textureId);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, object.lightmapId);
+
+        if (occlusion)
+            glDrawArraysIndirect(GL_TRIANGLES, (const void*)(drawOrder[i] * sizeof(DrawArraysIndirectCommand)));
+        else
+            glDrawArrays(GL_TRIANGLES, level.firstVertex, level.nVertices);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    glEndQuery(GL_SAMPLES_PASSED);
+
+    // Back to regular depth testing for the instances
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+
+    UDrawInstances(projection * view);
+
+    // Deactivate the Vertex Array Object
+    glBindVertexArray(0);
+
+    glDisable(GL_STENCIL_TEST);
+
+    // This frame's depth becomes the occluders of the next one
+    if (occlusion)
+        UBuildHiZ(gSceneTarget, sceneWidth, sceneHeight, projection * view);
+    else
+        gHiZValid = false;
+
+    // Fill in the skipped pixels, then stretch the reduced resolution scene over the window
+    if (checkerboard)
+    {
+        UResolveCheckerboard(projection * view, sceneWidth, sceneHeight);
+        UUpscaleScene(gHistoryTargets[gFrameIndex & 1], sceneWidth, sceneHeight, width, height);
+    }
+    else
+    {
+        gHistoryValid = false;
+        if (offscreen)
+            UUpscaleScene(gSceneTarget, sceneWidth, sceneHeight, width, height);
+    }
+
+    UDrawDebug(projection * view);
+    UPresentFrame();
+}
+
+
+// Sets the swap interval of the vsync mode. Adaptive vsync needs the swap control tear extension,
+// without it vsync stays on.
+void UApplyVsync()
+{
+    int interval = gVsync == VSYNC_OFF ? 0 : 1;
+    if (gVsync == VSYNC_ADAPTIVE)
+    {
+        if (glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear"))
+            interval = -1;
+        else
+            cout << "INFO: Adaptive vsync is not supported, vsync stays on" << endl;
+    }
+    glfwSwapInterval(interval);
+}
+
+
+// Swaps the buffers and counts the frame, with the time since the last present and, when the frame
+// is the first to show some input, how long ago the callback received it
+void UPresentFrame()
+{
+    // Every draw from the streaming buffer is queued by now
+    UEndStreamFrame(gStreamBuffer);
+
+    // The back buffer is only defined until the swap
+    UCaptureFrame();
+
+    // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+    glfwSwapBuffers(gWindow);    // Flips the the back buffer with the front buffer every frame.
+    const double now = glfwGetTime();
+
+    if (gLastPresent > 0.0)
+    {
+        const double interval = now - gLastPresent;
+        gFrameStats.presentIntervalSum += interval;
+        gFrameStats.presentIntervalSquares += interval * interval;
+        ++gFrameStats.presentIntervals;
+    }
+    gLastPresent = now;
+
+    const double inputTime = gSnapshots.ReadBuffer().inputTime;
+    if (inputTime > gLastInputPresented)
+    {
+        const double latency = now - inputTime;
+        gFrameStats.inputLatencySum += latency;
+        gFrameStats.inputLatencyMax = std::max(gFrameStats.inputLatencyMax, latency);
+        ++gFrameStats.inputLatencies;
+        gLastInputPresented = inputTime;
+    }
+
+    ++gFrameIndex;
+    ++gFrameStats.frames;
+}
+
+
+// Opens the capture writer. The ring's buffers are sized on the first frames read into them.
+void UStartCapture()
+{
+    gCaptureRing = GLCaptureRing();
+    glGenBuffers(CAPTURE_RING_SIZE, gCaptureRing.buffers);
+
+    // Video frames are stamped at the target frame rate
+    const int fps = int(std::lround(gOptions.maxFps > 0.0 ? gOptions.maxFps : 1000.0 / gOptions.targetFrameTimeMs));
+    gCaptureWriter.Open(gOptions.capturePath, fps);
+    gCaptureBudget = 0.0;
+    cout << "INFO: Capturing frames to " << gOptions.capturePath << (IsY4mPath(gOptions.capturePath) ? "" : "_NNNNNN.ppm")
+        << " within " << gOptions.captureMargin * 100.0f << "% of the frame time" << endl;
+}
+
+
+// Reads the back buffer into the next buffer of the ring, after handing the readbacks that have
+// landed to the writer thread. Nothing here waits on the GPU: when the next buffer is still in
+// flight, or the capture budget is spent, the frame is skipped.
+void UCaptureFrame()
+{
+    if (!gCaptureWriter.IsOpen())
+        return;
+
+    const double start = glfwGetTime();
+    const double allowance = gOptions.captureMargin * gSmoothedFrameTime;
+    gCaptureBudget = std::min(gCaptureBudget + allowance, allowance);
+    gFrameStats.captureFrameSeconds += gSmoothedFrameTime;
+
+    UCollectCaptures(false);
+
+    GLCaptureRing& ring = gCaptureRing;
+    const int slot = ring.next;
+    if (gCaptureBudget < 0.0)
+        ++gFrameStats.captureOverBudget;
+    else if (ring.fences[slot])
+        ++gFrameStats.captureRingBusy;
+    else
+    {
+        int width, height;
+        glfwGetFramebufferSize(gWindow, &width, &height);
+        const GLsizeiptr size = GLsizeiptr(width) * height * 4;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, ring.buffers[slot]);
+        if (ring.sizes[slot] != size)
+        {
+            glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+            ring.sizes[slot] = size;
+        }
+
+        // Into the buffer, so glReadPixels returns as soon as the copy is queued
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        glReadBuffer(GL_BACK);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        ring.fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        ring.frames[slot] = gFrameIndex;
+        ring.widths[slot] = width;
+        ring.heights[slot] = height;
+        ring.next = (slot + 1) % CAPTURE_RING_SIZE;
+        ++gFrameStats.capturedFrames;
+    }
+
+    const double elapsed = glfwGetTime() - start;
+    gCaptureBudget -= elapsed;
+    gFrameStats.captureSeconds += elapsed;
+}
+
+
+// Copies the readbacks whose fences have signaled out of the ring, oldest first, and queues them on
+// the writer thread. With wait it blocks until every readback in flight has landed.
+void UCollectCaptures(bool wait)
+{
+    GLCaptureRing& ring = gCaptureRing;
+    for (int i = 0; i < CAPTURE_RING_SIZE; ++i)
+    {
+        const int slot = (ring.next + i) % CAPTURE_RING_SIZE;
+        if (!ring.fences[slot])
+            continue;
+
+        // The GPU finishes the readbacks in order, so the first one still in flight ends the pass
+        const GLenum status = wait ? glClientWaitSync(ring.fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000))
+            : glClientWaitSync(ring.fences[slot], 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED && !wait)
+            break;
+        glDeleteSync(ring.fences[slot]);
+        ring.fences[slot] = 0;
+        if (status == GL_WAIT_FAILED || status == GL_TIMEOUT_EXPIRED)
+        {
+            cout << "ERROR::CAPTURE::READBACK_FAILED for frame " << ring.frames[slot] << endl;
+            continue;
+        }
+
+        CaptureFrame frame = { ring.frames[slot], ring.widths[slot], ring.heights[slot], gCaptureWriter.TakeBuffer() };
+        frame.pixels.resize(size_t(ring.sizes[slot]));
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, ring.buffers[slot]);
+        const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, ring.sizes[slot], GL_MAP_READ_BIT);
+        if (pixels)
+        {
+            memcpy(frame.pixels.data(), pixels, frame.pixels.size());
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            gCaptureWriter.Submit(std::move(frame));
+        }
+        else
+            cout << "ERROR::CAPTURE::MAP_FAILED for frame " << ring.frames[slot] << endl;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+}
+
+
+// Hands the readbacks still in flight to the writer, then waits for it to write everything queued
+void UStopCapture()
+{
+    if (!gCaptureWriter.IsOpen())
+        return;
+
+    UCollectCaptures(true);
+    gCaptureWriter.Close();
+    cout << "INFO: Capture written to " << gOptions.capturePath << (IsY4mPath(gOptions.capturePath) ? "" : "_NNNNNN.ppm") << endl;
+    glDeleteBuffers(CAPTURE_RING_SIZE, gCaptureRing.buffers);
+    gCaptureRing = GLCaptureRing();
+}
+
+
+// Creates the streaming buffer with regionBytes for each frame in flight and maps it for good
+bool UCreateStreamBuffer(GLStreamBuffer& stream, size_t regionBytes)
+{
+    stream = GLStreamBuffer();
+    stream.allocator.Reset(regionBytes);
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &stream.buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, stream.buffer);
+    glBufferStorage(GL_ARRAY_BUFFER, GLsizeiptr(stream.allocator.TotalBytes()), nullptr, flags);
+    stream.mapped = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, GLsizeiptr(stream.allocator.TotalBytes()), flags));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (!stream.mapped)
+    {
+        cout << "ERROR::STREAM_BUFFER::MAP_FAILED" << endl;
+        UDestroyStreamBuffer(stream);
+        return false;
+    }
+    return true;
+}
+
+
+void UDestroyStreamBuffer(GLStreamBuffer& stream)
+{
+    for (GLsync& fence : stream.fences)
+        if (fence)
+            glDeleteSync(fence);
+    if (stream.mapped)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, stream.buffer);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &stream.buffer);
+    stream = GLStreamBuffer();
+}
+
+
+// Moves to the next region, waiting for the GPU to finish the frame that last drew from it. With
+// a region per frame in flight this only blocks when the GPU is that many frames behind.
+void UBeginStreamFrame(GLStreamBuffer& stream)
+{
+    if (!stream.mapped)
+        return;
+
+    GLsync& fence = stream.fences[stream.allocator.BeginFrame()];
+    if (!fence)
+        return;
+
+    const double start = glfwGetTime();
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    while (status == GL_TIMEOUT_EXPIRED)
+        status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000));
+    if (status == GL_WAIT_FAILED)
+        cout << "ERROR::STREAM_BUFFER::WAIT_FAILED" << endl;
+    glDeleteSync(fence);
+    fence = 0;
+    gFrameStats.streamWaitSeconds += glfwGetTime() - start;
+}
+
+
+// Space for bytes in this frame's region, at an offset from the start of the buffer that is a
+// multiple of alignment (a vertex stride gives offset / stride as the first vertex). The caller
+// writes through the pointer and draws from stream.buffer before the frame ends. Returns nullptr
+// when the region is full.
+void* UStreamAllocate(GLStreamBuffer& stream, size_t bytes, size_t alignment, GLintptr& offset)
+{
+    if (!stream.mapped)
+        return nullptr;
+    const size_t allocated = stream.allocator.Allocate(bytes, alignment);
+    if (allocated == STREAM_ALLOCATION_FAILED)
+        return nullptr;
+    offset = GLintptr(allocated);
+    return stream.mapped + allocated;
+}
+
+
+// Fences the region of this frame once its draws are queued, if anything was allocated from it
+void UEndStreamFrame(GLStreamBuffer& stream)
+{
+    if (stream.mapped && stream.allocator.UsedBytes() > 0)
+        stream.fences[stream.allocator.Region()] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+
+// Streams a point cloud rewritten every frame through a persistently mapped buffer, and through a
+// single buffer orphaned every frame, first with glBufferData plus glBufferSubData, then with
+// glMapBufferRange and GL_MAP_INVALIDATE_BUFFER_BIT. The time per frame includes the GPU catching up.
+void URunUploadBenchmark()
+{
+    const int FRAMES = 300;
+
+    GLuint programId;
+    if (!UCreateShaderProgram(flatVertexShaderSource, flatFragmentShaderSource, programId))
+        return;
+    glUseProgram(programId);
+    const glm::mat4 identity(1.0f);
+    glUniformMatrix4fv(glGetUniformLocation(programId, "model"), 1, GL_FALSE, glm::value_ptr(identity));
+    glUniformMatrix4fv(glGetUniformLocation(programId, "view"), 1, GL_FALSE, glm::value_ptr(identity));
+    glUniformMatrix4fv(glGetUniformLocation(programId, "projection"), 1, GL_FALSE, glm::value_ptr(identity));
+    glDisable(GL_DEPTH_TEST);
+
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glEnableVertexAttribArray(0);
+
+    // Points along a spiral that turns a little every frame, written wherever the method says
+    const auto writePoints = [](glm::vec3* points, size_t nPoints, int frame)
+    {
+        for (size_t i = 0; i < nPoints; ++i)
+        {
+            const float t = float(i) / float(nPoints), angle = t * 60.0f + frame * 0.01f;
+            points[i] = glm::vec3(std::cos(angle) * t, std::sin(angle) * t, 0.0f);
+        }
+    };
+
+    const char* methods[] = { "persistent map", "orphan + glBufferSubData", "orphan + map invalidate" };
+    for (size_t nPoints : { size_t(4096), size_t(65536), size_t(1) << 20 })
+    {
+        const size_t bytes = nPoints * sizeof(glm::vec3);
+        std::vector<glm::vec3> staging(nPoints);
+        double frameMs[3];
+        double waitMs = 0.0;
+        for (int method = 0; method < 3; ++method)
+        {
+            GLStreamBuffer stream;
+            GLuint orphaned = 0;
+            if (method == 0)
+            {
+                if (!UCreateStreamBuffer(stream, bytes))
+                    return;
+                glBindBuffer(GL_ARRAY_BUFFER, stream.buffer);
+            }
+            else
+            {
+                glGenBuffers(1, &orphaned);
+                glBindBuffer(GL_ARRAY_BUFFER, orphaned);
+                glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+            }
+            glFinish();
+
+            const double waitStart = gFrameStats.streamWaitSeconds;
+            const auto start = BenchmarkClock::now();
+            for (int frame = 0; frame < FRAMES; ++frame)
+            {
+                GLintptr offset = 0;
+                if (method == 0)
+                {
+                    UBeginStreamFrame(stream);
+                    writePoints(static_cast<glm::vec3*>(UStreamAllocate(stream, bytes, sizeof(glm::vec3), offset)), nPoints, frame);
+                }
+                else if (method == 1)
+                {
+                    writePoints(staging.data(), nPoints, frame);
+                    glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+                    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, staging.data());
+                }
+                else
+                {
+                    void* points = glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+                    writePoints(static_cast<glm::vec3*>(points), nPoints, frame);
+                    glUnmapBuffer(GL_ARRAY_BUFFER);
+                }
+
+                glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
+                glDrawArrays(GL_POINTS, GLint(offset / sizeof(glm::vec3)), GLsizei(nPoints));
+                if (method == 0)
+                    UEndStreamFrame(stream);
+                glFlush();
+            }
+            glFinish();
+            frameMs[method] = ElapsedMs(start) / FRAMES;
+
+            if (method == 0)
+            {
+                waitMs = (gFrameStats.streamWaitSeconds - waitStart) * 1000.0 / FRAMES;
+                UDestroyStreamBuffer(stream);
+            }
+            else
+                glDeleteBuffers(1, &orphaned);
+        }
+
+        cout << nPoints << " points (" << (bytes >> 10) << " KB) per frame:";
+        for (int method = 0; method < 3; ++method)
+            cout << " | " << methods[method] << " " << frameMs[method] << " ms";
+        cout << " | persistent map waited " << waitMs << " ms per frame on fences, " << frameMs[1] / frameMs[0] << "x faster than glBufferSubData" << endl;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &vao);
+    UDestroyShaderProgram(programId);
+}
+
+
+// Queues the debug view: every object's bounds, green when drawn and red when culled, a sphere on
+// every light, the axes of the scene root and the camera frustum frozen when the view was turned on
+void UQueueDebugView(const glm::mat4& viewProjection, const int drawOrder[], int nDraws)
+{
+    bool drawn[OBJECT_COUNT] = {};
+    for (int i = 0; i < nDraws; ++i)
+        drawn[drawOrder[i]] = true;
+    for (int i = 0; i < OBJECT_COUNT; ++i)
+        DebugDrawBox(gScene.World(gObjects[i].node), gObjects[i].center, gObjects[i].extent, drawn[i] ? DEBUG_GREEN : DEBUG_RED);
+
+    for (const LightPacket& light : gLights)
+        DebugDrawSphere(light.position, 0.25f, DebugColor(light.color.r, light.color.g, light.color.b));
+
+    DebugDrawAxes(gScene.World(gSceneRoot), 1.0f);
+
+    if (!gDebugFrustumValid)
+    {
+        gDebugFrustum = viewProjection;
+        gDebugFrustumValid = true;
+    }
+    DebugDrawFrustum(gDebugFrustum, DEBUG_YELLOW);
+}
+
+
+// Streams the debug lines queued on every thread since the last frame and draws them over the
+// window in one call, with no depth test so nothing hides them
+void UDrawDebug(const glm::mat4& viewProjection)
+{
+#ifndef NDEBUG
+    size_t nLines = DebugDraw().Pending();
+    if (nLines == 0 || !gStreamBuffer.mapped)
+        return;
+
+    // What does not fit in this frame's region stays queued for the next one
+    const StreamAllocator& allocator = gStreamBuffer.allocator;
+    const size_t lineBytes = 2 * sizeof(DebugVertex);
+    const size_t room = (allocator.RegionBytes() - allocator.UsedBytes()) / lineBytes;
+    nLines = std::min(nLines, room > 0 ? room - 1 : 0);     // One line of room may go to alignment
+
+    GLintptr offset = 0;
+    DebugVertex* vertices = static_cast<DebugVertex*>(UStreamAllocate(gStreamBuffer, nLines * lineBytes, sizeof(DebugVertex), offset));
+    if (!vertices)
+        return;
+    nLines = DebugDraw().Flush(vertices, nLines);
+
+    int width, height;
+    glfwGetFramebufferSize(gWindow, &width, &height);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, width, height);
+    glDisable(GL_DEPTH_TEST);
+
+    glUseProgram(gDebugProgramId);
+    glUniformMatrix4fv(glGetUniformLocation(gDebugProgramId, "viewProjection"), 1, GL_FALSE, glm::value_ptr(viewProjection));
+    glBindVertexArray(gDebugVao);
+    glDrawArrays(GL_LINES, GLint(offset / sizeof(DebugVertex)), GLsizei(nLines * 2));
+    glBindVertexArray(0);
+    glEnable(GL_DEPTH_TEST);
+#endif
+}
+
+
+// Draws the stress scene instances in view with the main program, grouped by material so every texture
+// is bound once. They have no lightmaps and are lit per pixel.
+void UDrawInstances(const glm::mat4& viewProjection)
+{
+    gFrameStats.drawnInstances = 0;
+    gFrameStats.culledInstances = 0;
+    if (gOptions.stressInstances == 0 && gOptions.streamInstances == 0)
+        return;
+
+    const std::vector<DrawPacket>& draws = gSnapshots.ReadBuffer().draws;
+    const size_t nInstances = draws.size();
+
+    // The kernel writes whole groups of CULL_WIDTH indices
+    gVisibleInstances.resize(nInstances + CULL_WIDTH);
+    size_t nVisible = nInstances;
+    if (gFrustumCulling)
+    {
+        StressCullBounds(draws, gInstanceBounds);
+        nVisible = gInstanceBounds.Cull(ExtractFrustum(viewProjection), gVisibleInstances.data());
+    }
+    else
+    {
+        for (size_t i = 0; i < nInstances; ++i)
+            gVisibleInstances[i] = uint32_t(i);
+    }
+
+    // Record the visible instances into command buffers in parallel, then merge them in material order
+    const double recordStart = glfwGetTime();
+    RecordDrawCommands(draws, gVisibleInstances.data(), nVisible, gCommandBuffers);
+    MergeDrawCommands(gCommandBuffers, gDrawCommands);
+    const double submitStart = glfwGetTime();
+
+    glUseProgram(gProgramId);
+    glUniform1i(glGetUniformLocation(gProgramId, "uUseLightmap"), false);
+    const GLint modelLoc = glGetUniformLocation(gProgramId, "model");
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+
+    // Submission: nothing but the commands and the transforms they point at
+    unsigned triangles = 0;
+    uint32_t boundMaterial = UINT32_MAX;
+    for (const DrawCommand& command : gDrawCommands)
+    {
+        if (command.key != boundMaterial)
+        {
+            glBindTexture(GL_TEXTURE_2D, *gMaterialTextures[command.key]);
+            boundMaterial = command.key;
+        }
+        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(draws[command.transform].model));
+        glDrawArrays(GL_TRIANGLES, command.firstVertex, command.nVertices);
+        triangles += command.nVertices / 3;
+    }
+    glUniform1i(glGetUniformLocation(gProgramId, "uUseLightmap"), gUseLightmap);
+
+    gFrameStats.recordMs = float((submitStart - recordStart) * 1000.0);
+    gFrameStats.submitMs = float((glfwGetTime() - submitStart) * 1000.0);
+    gFrameStats.drawnInstances = unsigned(nVisible);
+    gFrameStats.culledInstances = unsigned(nInstances - nVisible);
+    gFrameStats.submittedTriangles += triangles;
+}
+
+
+// Fills drawOrder with the objects intersecting the view frustum and returns how many there are
+int UCullObjects(const glm::mat4& viewProjection, int drawOrder[])
+{
+    int nDraws = OBJECT_COUNT;
+    if (gFrustumCulling)
+    {
+        // The kernel writes whole groups of CULL_WIDTH indices
+        uint32_t visible[OBJECT_COUNT + CULL_WIDTH];
+        nDraws = int(gCullBounds.Cull(ExtractFrustum(viewProjection), visible));
+        for (int i = 0; i < nDraws; ++i)
+            drawOrder[i] = int(visible[i]);
+    }
+    else
+    {
+        for (int i = 0; i < OBJECT_COUNT; ++i)
+            drawOrder[i] = i;
+    }
+
+    gFrameStats.visibleObjects = nDraws;
+    gFrameStats.culledObjects = OBJECT_COUNT - nDraws;
+    return nDraws;
+}
+
+
+// Rasterizes the occluder objects on the CPU, then removes the objects hidden behind them from the
+// first nDraws entries of drawOrder. Returns how many are left.
+int URasterizeOcclusion(const glm::mat4& viewProjection, int drawOrder[], int nDraws)
+{
+    if (gOcclusionRasterizer.Width() == 0)
+        gOcclusionRasterizer.Resize(OCCLUSION_RASTER_WIDTH, OCCLUSION_RASTER_HEIGHT);
+
+    gOcclusionRasterizer.BeginFrame(viewProjection);
+    for (int i = 0; i < nDraws; ++i)
+    {
+        const SceneObject& object = gObjects[drawOrder[i]];
+        // Always the full mesh, a coarser level can reach outside it and hide what is visible
+        if (object.occluder)
+            gOcclusionRasterizer.AddOccluder(&gMeshPositions[object.firstVertex * 3], object.nVertices, 3, gScene.World(object.node));
+    }
+    gOcclusionRasterizer.Rasterize();
+
+    glm::vec3 centers[OBJECT_COUNT], extents[OBJECT_COUNT];
+    for (int i = 0; i < nDraws; ++i)
+    {
+        const SceneObject& object = gObjects[drawOrder[i]];
+        TransformBounds(gScene.World(object.node), object.center, object.extent, centers[i], extents[i]);
+    }
+    uint8_t visible[OBJECT_COUNT];
+    gOcclusionRasterizer.TestBoxes(centers, extents, nDraws, visible);
+
+    int nVisible = 0;
+    for (int i = 0; i < nDraws; ++i)
+        if (visible[i])
+            drawOrder[nVisible++] = drawOrder[i];
+
+    gFrameStats.occludedObjects = nDraws - nVisible;
+    return nVisible;
+}
+
+
+// Picks the level of detail of the first nDraws objects of drawOrder from how large their error
+// shows on screen, and counts the triangles they submit
+void USelectLods(const glm::mat4& projection, const int drawOrder[], int nDraws)
+{
+    int width, height;
+    glfwGetFramebufferSize(gWindow, &width, &height);
+
+    // Pixels covered by one world unit at distance one
+    const float pixelsPerUnit = projection[1][1] * height * 0.5f;
+
+    bool changed = false;
+    unsigned triangles = 0;
+    for (int i = 0; i < nDraws; ++i)
+    {
+        SceneObject& object = gObjects[drawOrder[i]];
+        const glm::mat4& model = gScene.World(object.node);
+
+        // The errors are in model space: scale them by the largest axis scale and measure the distance to
+        // the nearest point of the bounds, no closer than the near plane
+        glm::vec3 center, extent;
+        TransformBounds(model, object.center, object.extent, center, extent);
+        const float scale = std::sqrt(std::max(glm::dot(glm::vec3(model[0]), glm::vec3(model[0])),
+            std::max(glm::dot(glm::vec3(model[1]), glm::vec3(model[1])), glm::dot(glm::vec3(model[2]), glm::vec3(model[2])))));
+        const float distance = std::max(glm::length(glm::max(glm::abs(center - gCamera.Position) - extent, glm::vec3(0.0f))), 0.1f);
+
+        const int lod = gLevelOfDetail ? SelectLod(object.lods, object.lodCount, object.lod, pixelsPerUnit * scale / distance, LOD_PIXEL_ERROR, LOD_HYSTERESIS) : 0;
+        changed = changed || lod != object.lod;
+        object.lod = lod;
+        triangles += object.lods[lod].nVertices / 3;
+    }
+    gFrameStats.submittedTriangles = triangles;
+
+    // The GPU culling pass writes the draw commands from its own copy of the ranges
+    if (changed && gCullBuffers.objects != 0)
+        UUploadCullObjects();
+}
+
+
+// Sorts the first nDraws object indices of drawOrder by distance to the camera, nearest first
+void USortFrontToBack(int drawOrder[], int nDraws)
+{
+    float distance[OBJECT_COUNT];
+    for (int i = 0; i < OBJECT_COUNT; ++i)
+    {
+        const glm::vec3 center = glm::vec3(gScene.World(gObjects[i].node) * glm::vec4(gObjects[i].center, 1.0f));
+        distance[i] = glm::length(center - gCamera.Position);
+    }
+
+    std::sort(drawOrder, drawOrder + nDraws, [&distance](int a, int b) { return distance[a] < distance[b]; });
+}
+
+
+// Renders depth only, with the position-only vertex stream and an empty fragment shader.
+// Indirect draws the survivors of the GPU culling pass in a single call, the model matrices
+// coming from the culling pass's object buffer.
+void UDrawDepthPrepass(const glm::mat4& view, const glm::mat4& projection, const int drawOrder[], int nDraws, bool indirect)
+{
+    const GLuint program = indirect ? gCullDepthProgramId : gDepthProgramId;
+    glUseProgram(program);
+    const GLint modelLoc = glGetUniformLocation(program, "model");
+    glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+
+    if (indirect)
+    {
+        glBindVertexArray(gCullBuffers.depthVao);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, gCullBuffers.objects);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, gCullBuffers.drawCommands);
+
+        // The survivor count stays on the GPU when it can be read as the draw count, otherwise
+        // every candidate's slot is drawn and the ones past the survivors are empty
+        if (GLEW_ARB_indirect_parameters)
+        {
+            glBindBuffer(GL_PARAMETER_BUFFER_ARB, gCullBuffers.count);
+            glMultiDrawArraysIndirectCountARB(GL_TRIANGLES, 0, 0, nDraws, 0);
+            glBindBuffer(GL_PARAMETER_BUFFER_ARB, 0);
+        }
+        else
+        {
+            glMultiDrawArraysIndirect(GL_TRIANGLES, 0, nDraws, 0);
+        }
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+    else
+    {
+        glBindVertexArray(gMesh.depthVao);
+        for (int i = 0; i < nDraws; ++i)
+        {
+            const SceneObject& object = gObjects[drawOrder[i]];
+            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(gScene.World(object.node)));
+            glDrawArrays(GL_TRIANGLES, object.lods[object.lod].firstVertex, object.lods[object.lod].nVertices);
+        }
+    }
+
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+
+// Collects the result of a fragment query issued a few frames ago, if the GPU has finished it
+void UReadFragmentQuery(int query)
+{
+    if (!gFragmentQueryPending[query])
+        return;
+
+    GLint available = 0;
+    glGetQueryObjectiv(gFragmentQueries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available)
+    {
+        GLuint64 fragments = 0;
+        glGetQueryObjectui64v(gFragmentQueries[query], GL_QUERY_RESULT, &fragments);
+        gFrameStats.shadedFragments[gFragmentQueryPrepass[query] ? 1 : 0] = fragments;
+    }
+    gFragmentQueryPending[query] = false;
+}
+
+
+// Prints the frame counters once per second (or right away when forced)
+void UReportFrameStats(bool force)
+{
+    const double now = glfwGetTime();
+    if (!force && now - gLastStatsReport < 1.0)
+        return;
+
+    cout << "FPS: " << gFrameStats.frames / (now - gLastStatsReport)
+        << " | objects: " << gFrameStats.visibleObjects << " visible, " << gFrameStats.culledObjects << " culled, "
+        << gFrameStats.occludedObjects << " occluded"
+        << " | triangles: " << gFrameStats.submittedTriangles << " submitted (LOD " << (gLevelOfDetail ? "on" : "off") << ")";
+    if (gOptions.stressInstances > 0 || gOptions.streamInstances > 0)
+        cout << " | instances: " << gFrameStats.drawnInstances << " drawn, " << gFrameStats.culledInstances << " culled, recorded in "
+            << gFrameStats.recordMs << " ms on " << WorkerThreadCount() << " threads, submitted in " << gFrameStats.submitMs << " ms";
+    if (gStreamer.IsOpen())
+    {
+        const ChunkStreamer::Stats streaming = gStreamer.GetStats();
+        cout << " | streaming: " << streaming.residentChunks << " chunks resident (" << (streaming.residentBytes >> 10) << " KB of "
+            << (gOptions.streamBudgetMb << 10) << " KB), " << streaming.queuedChunks << " queued, " << streaming.loadedChunks << " loaded and "
+            << streaming.evictedChunks << " evicted, load latency " << streaming.averageLatencyMs << " ms average, "
+            << streaming.maxLatencyMs << " ms worst";
+        gStreamer.ResetStats();
+    }
+    if (gIdleMode && !gOptions.headless)
+        cout << " | idle: " << gFrameStats.skippedFrames << " frames skipped";
+    cout << " | frame time: " << gFrameStats.frameTimeMs << " ms at " << gFrameStats.resolutionScale * 100.0f << "% resolution"
+        << " | shaded fragments per frame: " << gFrameStats.shadedFragments[0] << " without pre-pass, "
+        << gFrameStats.shadedFragments[1] << " with pre-pass"
+        << " (pre-pass " << (gDepthPrepass ? "on" : "off") << ", checkerboard " << (gCheckerboard ? "on" : "off")
+        << ", occlusion culling " << (gOcclusion == OCCLUSION_GPU ? "GPU" : gOcclusion == OCCLUSION_CPU ? "CPU" : "off") << ")" << endl;
+
+    // Pacing: how evenly the frames were presented, and how long input took to show up
+    if (gFrameStats.presentIntervals > 0)
+    {
+        const double mean = gFrameStats.presentIntervalSum / gFrameStats.presentIntervals;
+        const double deviation = std::sqrt(std::max(gFrameStats.presentIntervalSquares / gFrameStats.presentIntervals - mean * mean, 0.0));
+        cout << "Present: vsync " << (gVsync == VSYNC_ON ? "on" : gVsync == VSYNC_ADAPTIVE ? "adaptive" : "off")
+            << " | interval " << mean * 1000.0 << " ms average, " << deviation * 1000.0 << " ms deviation";
+        if (gFrameLimiter.Enabled())
+        {
+            const FrameLimiter::Stats limiter = gFrameLimiter.GetStats();
+            cout << " | limiter at " << gFrameLimiter.TargetFps() << " fps: slept " << limiter.sleptMs << " ms, spun " << limiter.spunMs << " ms";
+            gFrameLimiter.ResetStats();
+        }
+        if (gFrameStats.inputLatencies > 0)
+            cout << " | input to present: " << gFrameStats.inputLatencySum / gFrameStats.inputLatencies * 1000.0 << " ms average, "
+                << gFrameStats.inputLatencyMax * 1000.0 << " ms worst";
+        cout << endl;
+    }
+
+    if (gCaptureWriter.IsOpen())
+    {
+        const CaptureWriter::Stats capture = gCaptureWriter.GetStats();
+        cout << "Capture: " << gFrameStats.capturedFrames << " frames read back, " << capture.written << " written, "
+            << gFrameStats.captureOverBudget << " skipped over budget, " << gFrameStats.captureRingBusy << " skipped with the ring busy, "
+            << capture.dropped << " dropped with the writer behind";
+        if (capture.failed > 0)
+            cout << ", " << capture.failed << " failed to write";
+        if (gFrameStats.captureFrameSeconds > 0.0)
+            cout << " | " << gFrameStats.captureSeconds * 1000.0 / std::max(gFrameStats.frames, 1u) << " ms per frame, "
+                << gFrameStats.captureSeconds / gFrameStats.captureFrameSeconds * 100.0 << "% of the frame time (margin "
+                << gOptions.captureMargin * 100.0f << "%)";
+        cout << endl;
+        gCaptureWriter.ResetStats();
+    }
+
+#ifndef NDEBUG
+    const size_t debugLinesDropped = DebugDraw().TakeDropped();
+    if (debugLinesDropped > 0)
+        cout << "Debug draw: " << debugLinesDropped << " lines dropped, more than " << DEBUG_LINES_PER_THREAD << " queued by a thread in a frame" << endl;
+#endif
+
+    const StreamAllocator::Stats streamed = gStreamBuffer.allocator.GetStats();
+    if (streamed.peakBytes > 0 || streamed.failedAllocations > 0)
+    {
+        cout << "Stream buffer: " << (streamed.peakBytes >> 10) << " KB peak of " << (gStreamBuffer.allocator.RegionBytes() >> 10)
+            << " KB per frame, " << gFrameStats.streamWaitSeconds * 1000.0 << " ms waiting on fences";
+        if (streamed.failedAllocations > 0)
+            cout << ", " << streamed.failedAllocations << " allocations did not fit";
+        cout << endl;
+        gStreamBuffer.allocator.ResetStats();
+    }
+
+    if (gOverdrawView != OVERDRAW_OFF)
+    {
+        UMeasureOverdraw();
+        cout << "Overdraw: " << gFrameStats.overdrawAverage << " average, " << gFrameStats.overdrawMax << " max fragments per pixel"
+            << " | lights: " << gFrameStats.lightsAverage << " average, " << gFrameStats.lightsMax << " max per pixel" << endl;
+    }
+
+    gFrameStats.frames = 0;
+    gFrameStats.presentIntervalSum = 0.0;
+    gFrameStats.presentIntervalSquares = 0.0;
+    gFrameStats.presentIntervals = 0;
+    gFrameStats.inputLatencySum = 0.0;
+    gFrameStats.inputLatencyMax = 0.0;
+    gFrameStats.inputLatencies = 0;
+    gFrameStats.skippedFrames = 0;
+    gFrameStats.capturedFrames = 0;
+    gFrameStats.captureOverBudget = 0;
+    gFrameStats.captureRingBusy = 0;
+    gFrameStats.captureSeconds = 0.0;
+    gFrameStats.captureFrameSeconds = 0.0;
+    gFrameStats.streamWaitSeconds = 0.0;
+    gLastStatsReport = now;
+}
+
+
+// Counts the fragments (and lights) shaded for every pixel with additive blending into a float
+// target, using the same depth setup as the normal shading, then false-colors the counts
+void URenderOverdraw(const glm::mat4& view, const glm::mat4& projection, const int drawOrder[], int nDraws)
+{
+    int width, height;
+    glfwGetFramebufferSize(gWindow, &width, &height);
+    if (!UEnsureRenderTarget(gOverdrawTarget, width, height, GL_RG32F))
+        return;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, gOverdrawTarget.fbo);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    if (gDepthPrepass)
+    {
+        UDrawDepthPrepass(view, projection, drawOrder, nDraws, false);
+        glDepthFunc(GL_EQUAL);
+        glDepthMask(GL_FALSE);
+    }
+
+    glUseProgram(gOverdrawProgramId);
+    const GLint modelLoc = glGetUniformLocation(gOverdrawProgramId, "model");
+    glUniformMatrix4fv(glGetUniformLocation(gOverdrawProgramId, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(gOverdrawProgramId, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform1f(glGetUniformLocation(gOverdrawProgramId, "uLightCount"), float(SHADER_LIGHT_COUNT));
+
+    // Every fragment that passes the depth test adds one to its pixel
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+
+    glBindVertexArray(gMesh.depthVao);
+    for (int i = 0; i < nDraws; ++i)
+    {
+        const SceneObject& object = gObjects[drawOrder[i]];
+        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(gScene.World(object.node)));
+        glDrawArrays(GL_TRIANGLES, object.lods[object.lod].firstVertex, object.lods[object.lod].nVertices);
+    }
+
+    glDisable(GL_BLEND);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+
+    // False-color the counters onto the window
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDisable(GL_DEPTH_TEST);
+
+    const bool showLights = gOverdrawView == OVERDRAW_LIGHTS;
+    glUseProgram(gHeatmapProgramId);
+    glUniform1i(glGetUniformLocation(gHeatmapProgramId, "uCounter"), 0);
+    glUniform1i(glGetUniformLocation(gHeatmapProgramId, "uChannel"), showLights ? 1 : 0);
+    glUniform1f(glGetUniformLocation(gHeatmapProgramId, "uMaxCount"), showLights ? HEATMAP_MAX_COUNT * SHADER_LIGHT_COUNT : HEATMAP_MAX_COUNT);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, gOverdrawTarget.colorTexture);
+    glBindVertexArray(gFullscreenVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    glEnable(GL_DEPTH_TEST);
+}
+
+
+// Reads the overdraw counters back and computes the average over covered pixels and the maximum.
+// This stalls on the GPU, so it only runs when the stats are reported.
+void UMeasureOverdraw()
+{
+    if (gOverdrawTarget.fbo == 0)
+        return;
+
+    std::vector<GLfloat> counters(size_t(gOverdrawTarget.width) * gOverdrawTarget.height * 2);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, gOverdrawTarget.fbo);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, gOverdrawTarget.width, gOverdrawTarget.height, GL_RG, GL_FLOAT, counters.data());
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    double fragments = 0.0, lights = 0.0;
+    size_t coveredPixels = 0;
+    gFrameStats.overdrawMax = 0.0f;
+    gFrameStats.lightsMax = 0.0f;
+    for (size_t i = 0; i < counters.size(); i += 2)
+    {
+        if (counters[i] <= 0.0f)
+            continue;
+
+        ++coveredPixels;
+        fragments += counters[i];
+        lights += counters[i + 1];
+        gFrameStats.overdrawMax = std::max(gFrameStats.overdrawMax, counters[i]);
+        gFrameStats.lightsMax = std::max(gFrameStats.lightsMax, counters[i + 1]);
+    }
+
+    gFrameStats.overdrawAverage = coveredPixels ? float(fragments / coveredPixels) : 0.0f;
+    gFrameStats.lightsAverage = coveredPixels ? float(lights / coveredPixels) : 0.0f;
+}
+
+
+// Creates a framebuffer with a color texture of the given format and a 24-bit depth, 8-bit stencil texture
+bool UCreateRenderTarget(GLRenderTarget& target, int width, int height, GLenum colorFormat)
+{
+    target.width = width;
+    target.height = height;
+
+    glGenTextures(1, &target.colorTexture);
+    glBindTexture(GL_TEXTURE_2D, target.colorTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, colorFormat, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenTextures(1, &target.depthTexture);
+    glBindTexture(GL_TEXTURE_2D, target.depthTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH24_STENCIL8, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &target.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.colorTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, target.depthTexture, 0);
+
+    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        cout << "ERROR::FRAMEBUFFER::INCOMPLETE " << status << endl;
+        UDestroyRenderTarget(target);
+        return false;
+    }
+
+    return true;
+}
+
+
+// Keeps target at the given size, recreating it when the size changes
+bool UEnsureRenderTarget(GLRenderTarget& target, int width, int height, GLenum colorFormat)
+{
+    if (target.fbo != 0 && target.width == width && target.height == height)
+        return true;
+
+    UDestroyRenderTarget(target);
+    return UCreateRenderTarget(target, width, height, colorFormat);
+}
+
+
+void UDestroyRenderTarget(GLRenderTarget& target)
+{
+    glDeleteFramebuffers(1, &target.fbo);
+    glDeleteTextures(1, &target.colorTexture);
+    glDeleteTextures(1, &target.depthTexture);
+    target = GLRenderTarget();
+}
+
+
+// Moves the resolution scale so the frame time converges on the target frame time
+void UUpdateDynamicResolution(float frameTime)
+{
+    gFrameStats.frameTimeMs = frameTime * 1000.0f;
+    if (frameTime <= 0.0f)
+        return;
+
+    // Smooth out single slow frames
+    gSmoothedFrameTime = gSmoothedFrameTime > 0.0f ? glm::mix(gSmoothedFrameTime, frameTime, 0.1f) : frameTime;
+    if (!gDynamicResolution)
+        return;
+
+    // Shading cost follows the pixel count (scale squared), so the scale moves with the square root
+    // of the time ratio. The step is halved again and small errors are ignored to avoid oscillating.
+    const float ratio = (gOptions.targetFrameTimeMs / 1000.0f) / gSmoothedFrameTime;
+    if (ratio < 0.95f || ratio > 1.05f)
+        gResolutionScale = glm::clamp(gResolutionScale * std::pow(ratio, 0.25f), MIN_RESOLUTION_SCALE, MAX_RESOLUTION_SCALE);
+}
+
+
+// Draws the scene (sceneWidth x sceneHeight pixels of source) onto the window with bilinear filtering
+void UUpscaleScene(const GLRenderTarget& source, int sceneWidth, int sceneHeight, int width, int height)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, width, height);
+    glDisable(GL_DEPTH_TEST);
+
+    glUseProgram(gUpscaleProgramId);
+    glUniform1i(glGetUniformLocation(gUpscaleProgramId, "uScene"), 0);
+    glUniform2f(glGetUniformLocation(gUpscaleProgramId, "uRegion"), float(sceneWidth) / source.width, float(sceneHeight) / source.height);
+    glUniform2f(glGetUniformLocation(gUpscaleProgramId, "uTexelSize"), 1.0f / source.width, 1.0f / source.height);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, source.colorTexture);
+    glBindVertexArray(gFullscreenVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    glEnable(GL_DEPTH_TEST);
+}
+
+
+// Keeps both history targets at the window size, the history is lost when they are recreated
+bool UEnsureCheckerboardTargets(int width, int height)
+{
+    if (gHistoryTargets[0].width != width || gHistoryTargets[0].height != height)
+        gHistoryValid = false;
+
+    return UEnsureRenderTarget(gHistoryTargets[0], width, height, GL_RGBA16F)
+        && UEnsureRenderTarget(gHistoryTargets[1], width, height, GL_RGBA16F);
+}
+
+
+// Marks the pixels of the given parity in the stencil buffer and leaves the stencil test set up
+// so that only those pixels get shaded. Depth is left untouched.
+void UWriteCheckerboardMask(int parity)
+{
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_STENCIL_TEST);
+    glStencilFunc(GL_ALWAYS, 1, 0xFF);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+
+    glUseProgram(gCheckerboardMaskProgramId);
+    glUniform1i(glGetUniformLocation(gCheckerboardMaskProgramId, "uParity"), parity);
+    glBindVertexArray(gFullscreenVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glEnable(GL_DEPTH_TEST);
+    glStencilFunc(GL_EQUAL, 1, 0xFF);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+}
+
+
+// Combines the half of the pixels shaded this frame with the previous frame reprojected through
+// the depth buffer into this frame's history target, which then becomes the history of the next frame
+void UResolveCheckerboard(const glm::mat4& viewProjection, int sceneWidth, int sceneHeight)
+{
+    const int parity = gFrameIndex & 1;
+    const GLRenderTarget& target = gHistoryTargets[parity];
+    const GLRenderTarget& history = gHistoryTargets[1 - parity];
+
+    glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+    glViewport(0, 0, sceneWidth, sceneHeight);
+    glDisable(GL_DEPTH_TEST);
+
+    const GLuint program = gCheckerboardResolveProgramId;
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "uColor"), 0);
+    glUniform1i(glGetUniformLocation(program, "uDepth"), 1);
+    glUniform1i(glGetUniformLocation(program, "uHistory"), 2);
+    glUniformMatrix4fv(glGetUniformLocation(program, "uInverseViewProjection"), 1, GL_FALSE, glm::value_ptr(glm::inverse(viewProjection)));
+    glUniformMatrix4fv(glGetUniformLocation(program, "uPreviousViewProjection"), 1, GL_FALSE, glm::value_ptr(gPreviousViewProjection));
+    glUniform2i(glGetUniformLocation(program, "uSceneSize"), sceneWidth, sceneHeight);
+    glUniform2i(glGetUniformLocation(program, "uHistorySize"), gHistorySize.x, gHistorySize.y);
+    glUniform1i(glGetUniformLocation(program, "uParity"), parity);
+    glUniform1i(glGetUniformLocation(program, "uHistoryValid"), gHistoryValid);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, gSceneTarget.colorTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, gSceneTarget.depthTexture);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, history.colorTexture);
+    glBindVertexArray(gFullscreenVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glActiveTexture(GL_TEXTURE0);
+
+    glEnable(GL_DEPTH_TEST);
+
+    gPreviousViewProjection = viewProjection;
+    gHistorySize = glm::ivec2(sceneWidth, sceneHeight);
+    gHistoryValid = true;
+}
+
+
+// Creates the buffers of the GPU culling pass and the vertex array of its depth pre-pass
+void UCreateOcclusionCulling()
+{
+    GLCullBuffers& buffers = gCullBuffers;
+    GLuint* const storage[] = { &buffers.objects, &buffers.candidates, &buffers.count, &buffers.drawCommands, &buffers.objectCommands, &buffers.objectIndices };
+    for (GLuint* buffer : storage)
+        glGenBuffers(1, buffer);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers.objects);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, OBJECT_COUNT * sizeof(GpuCullObject), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers.candidates);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, OBJECT_COUNT * sizeof(GLuint), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers.count);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers.drawCommands);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, OBJECT_COUNT * sizeof(DrawArraysIndirectCommand), nullptr, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers.objectCommands);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, OBJECT_COUNT * sizeof(DrawArraysIndirectCommand), nullptr, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    UUploadCullObjects();
+
+    // The depth pre-pass positions, plus the object index as an instanced attribute: a draw with a
+    // single instance reads entry baseInstance, so every command brings its own object index
+    GLuint objectIndices[OBJECT_COUNT];
+    for (int i = 0; i < OBJECT_COUNT; ++i)
+        objectIndices[i] = GLuint(i);
+
+    glGenVertexArrays(1, &buffers.depthVao);
+    glBindVertexArray(buffers.depthVao);
+    glBindBuffer(GL_ARRAY_BUFFER, gMesh.depthVbo);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 3, 0);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, buffers.objectIndices);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(objectIndices), objectIndices, GL_STATIC_DRAW);
+    glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(GLuint), 0);
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glGenBuffers(CULL_READBACK_COUNT, buffers.readback);
+    for (int i = 0; i < CULL_READBACK_COUNT; ++i)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffers.readback[i]);
+        glBufferData(GL_COPY_WRITE_BUFFER, sizeof(GLuint), nullptr, GL_STREAM_READ);
+        buffers.fences[i] = 0;
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+
+void UDestroyOcclusionCulling()
+{
+    GLCullBuffers& buffers = gCullBuffers;
+    GLuint* const storage[] = { &buffers.objects, &buffers.candidates, &buffers.count, &buffers.drawCommands, &buffers.objectCommands, &buffers.objectIndices };
+    for (GLuint* buffer : storage)
+        glDeleteBuffers(1, buffer);
+    glDeleteVertexArrays(1, &buffers.depthVao);
+    glDeleteBuffers(CULL_READBACK_COUNT, buffers.readback);
+    for (GLsync fence : buffers.fences)
+        glDeleteSync(fence);
+    buffers = GLCullBuffers();
+
+    glDeleteTextures(1, &gHiZTexture);
+    gHiZTexture = 0;
+}
+
+
+// Copies the world bounds, model matrix and vertex range (at the current level of detail) of every
+// object to the culling pass
+void UUploadCullObjects()
+{
+    GpuCullObject objects[OBJECT_COUNT];
+    for (int i = 0; i < OBJECT_COUNT; ++i)
+    {
+        const glm::mat4& model = gScene.World(gObjects[i].node);
+        glm::vec3 center, extent;
+        TransformBounds(model, gObjects[i].center, gObjects[i].extent, center, extent);
+        objects[i].center = glm::vec4(center, 0.0f);
+        objects[i].extent = glm::vec4(extent, 0.0f);
+        objects[i].model = model;
+        objects[i].range[0] = gObjects[i].lods[gObjects[i].lod].firstVertex;
+        objects[i].range[1] = gObjects[i].lods[gObjects[i].lod].nVertices;
+        objects[i].range[2] = objects[i].range[3] = 0;
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, gCullBuffers.objects);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(objects), objects);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+
+// Tests the frustum culled objects of drawOrder against the Hi-Z pyramid on the GPU. Survivors are
+// compacted into the draw command buffer and every candidate gets its own command as well.
+void UCullOccludedObjects(const int drawOrder[], int nDraws)
+{
+    GLCullBuffers& buffers = gCullBuffers;
+
+    // Counts come back a few frames later, by then the GPU is done with them
+    const int slot = gFrameIndex % CULL_READBACK_COUNT;
+    UReadCullCount(slot);
+
+    GLuint candidates[OBJECT_COUNT];
+    for (int i = 0; i < nDraws; ++i)
+        candidates[i] = GLuint(drawOrder[i]);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers.candidates);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, nDraws * sizeof(GLuint), candidates);
+
+    // Empty commands past the survivors draw nothing
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers.count);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers.drawCommands);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    const GLuint program = gOcclusionCullProgramId;
+    glUseProgram(program);
+    glUniform1ui(glGetUniformLocation(program, "uCandidateCount"), GLuint(nDraws));
+    glUniform1i(glGetUniformLocation(program, "uHiZ"), 0);
+    glUniformMatrix4fv(glGetUniformLocation(program, "uHiZViewProjection"), 1, GL_FALSE, glm::value_ptr(gHiZViewProjection));
+    glUniform1i(glGetUniformLocation(program, "uHiZValid"), gHiZValid);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, gHiZValid ? gHiZTexture : 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffers.objects);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, buffers.candidates);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, buffers.count);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, buffers.drawCommands);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, buffers.objectCommands);
+    glDispatchCompute((GLuint(nDraws) + 63) / 64, 1, 1);
+
+    // The draws read the commands, the count goes to this frame's readback buffer
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_COPY_READ_BUFFER, buffers.count);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffers.readback[slot]);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(GLuint));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    buffers.fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    buffers.candidateCount[slot] = unsigned(nDraws);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+
+// Collects the survivor count of a culling pass issued a few frames ago, if the GPU has finished it
+void UReadCullCount(int slot)
+{
+    GLCullBuffers& buffers = gCullBuffers;
+    if (!buffers.fences[slot])
+        return;
+
+    const GLenum status = glClientWaitSync(buffers.fences[slot], 0, 0);
+    if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+    {
+        GLuint survivors = 0;
+        glBindBuffer(GL_COPY_READ_BUFFER, buffers.readback[slot]);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(GLuint), &survivors);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        gFrameStats.occludedObjects = buffers.candidateCount[slot] - std::min(unsigned(survivors), buffers.candidateCount[slot]);
+    }
+    glDeleteSync(buffers.fences[slot]);
+    buffers.fences[slot] = 0;
+}
+
+
+// Builds the max depth pyramid from the scene's depth (sceneWidth x sceneHeight pixels of source),
+// level 0 at the size of the target. viewProjection is the camera the scene was rendered with.
+void UBuildHiZ(const GLRenderTarget& source, int sceneWidth, int sceneHeight, const glm::mat4& viewProjection)
+{
+    if (gHiZTexture == 0 || gHiZSize.x != source.width || gHiZSize.y != source.height)
+    {
+        glDeleteTextures(1, &gHiZTexture);
+        gHiZSize = glm::ivec2(source.width, source.height);
+        gHiZLevels = 1 + int(std::floor(std::log2(float(std::max(source.width, source.height)))));
+
+        glGenTextures(1, &gHiZTexture);
+        glBindTexture(GL_TEXTURE_2D, gHiZTexture);
+        glTexStorage2D(GL_TEXTURE_2D, gHiZLevels, GL_R32F, source.width, source.height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    // Level 0: the scene's depth stretched over the whole level
+    glUseProgram(gHiZCopyProgramId);
+    glUniform1i(glGetUniformLocation(gHiZCopyProgramId, "uDepth"), 0);
+    glUniform2f(glGetUniformLocation(gHiZCopyProgramId, "uScale"), float(sceneWidth) / source.width, float(sceneHeight) / source.height);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, source.depthTexture);
+    glBindImageTexture(0, gHiZTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+    glDispatchCompute((source.width + 7) / 8, (source.height + 7) / 8, 1);
+
+    // Every further level keeps the farthest depth of the one below
+    glUseProgram(gHiZReduceProgramId);
+    for (int level = 1; level < gHiZLevels; ++level)
+    {
+        const int levelWidth = std::max(1, gHiZSize.x >> level);
+        const int levelHeight = std::max(1, gHiZSize.y >> level);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        glBindImageTexture(0, gHiZTexture, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+        glBindImageTexture(1, gHiZTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute((levelWidth + 7) / 8, (levelHeight + 7) / 8, 1);
+    }
+
+    // The culling pass of the next frame samples the pyramid
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    gHiZViewProjection = viewProjection;
+    gHiZValid = true;
+}
+
+
+// Implements the UCreateMesh function
+void UCreateMesh(GLMesh& mesh)
+{
+    // Vertex data of the modeled objects, a constant in read-only memory
+    static constexpr GLfloat verts[] = {
+        // Vertex Positions    // Normals       //Texture Coords.
+        //Plane - Floor
+        -10.0f, -0.5f,-10.0f,   0.0f, 1.0f, 0.0f,   0.0f, 0.0f, //Bottom Left Vertex 1
+         10.0f, -0.5f,-10.0f,   0.0f, 1.0f, 0.0f,   1.0f, 0.0f, //Bottom Right Vertex 2
+         10.0f, -0.5f, 10.0f,   0.0f, 1.0f, 0.0f,   1.0f, 1.0f, //Top Right Vertex 3
+         10.0f, -0.5f, 10.0f,   0.0f, 1.0f, 0.0f,   1.0f, 1.0f, //Top Right Vertex 3
+        -10.0f, -0.5f, 10.0f,   0.0f, 1.0f, 0.0f,   0.0f, 1.0f, //Top Left Vertex 4
+        -10.0f, -0.5f,-10.0f,   0.0f, 1.0f, 0.0f,   0.0f, 0.0f, //Bottom Left Vertex 1
+
+        //Pen Body Cube
+         5.0f, -0.5f, -3.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, //Back br Vertex 91
+         0.0f, -0.5f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, //Back bl Vertex 92
+         0.0f, -0.7f, -1.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, //Back tl Vertex 93
+         0.0f, -0.7f, -1.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, //Back tl Vertex 94
+         5.0f, -0.7f, -3.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, //Back tr Vertex 95
+         5.0f, -0.5f, -3.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, //Back br Vertex 96
+
+         1.0f, -0.7f,  0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, //Front tl Vertex 97
+         1.0f, -0.5f,  0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, //Front bl Vertex 98
+         4.0f, -0.7f, -4.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, //Front tr Vertex 99
+         4.0f, -0.7f, -4.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, //Front tr Vertex 100
+         1.0f, -0.5f,  0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, //Front bl Vertex 101
+         4.0f, -0.5f, -4.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, //Front br Vertex 102
+
+         1.0f, -0.7f,  0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Left tr Vertex 103
+         0.0f, -0.7f, -1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Left tl Vertex 104
+         0.0f, -0.5f, -1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Left bl Vertex 105
+         0.0f, -0.5f, -1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Left bl Vertex 106
+         1.0f, -0.5f,  0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Left br Vertex 107
+         1.0f, -0.7f,  0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Left tr Vertex 108
+
+         4.0f, -0.7f, -4.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Right tl Vertex 109
+         5.0f, -0.7f, -3.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Right tr Vertex 110
+         5.0f, -0.5f, -3.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Right br Vertex 111
+         5.0f, -0.5f, -3.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Right br Vertex 112
+         4.0f, -0.5f, -4.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Right bl Vertex 113
+         4.0f, -0.7f, -4.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Right tl Vertex 114
+
+         1.0f, -0.5f,  0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, //Bottom bl Vertex 115
+         4.0f, -0.5f, -4.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, //Bottom br Vertex 116
+         5.0f, -0.5f, -3.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, //Bottom tr Vertex 117
+         5.0f, -0.5f, -3.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, //Bottom tr Vertex 118
+         0.0f, -0.5f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, //Bottom tl Vertex 119
+         1.0f, -0.5f,  0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, //Bottom bl Vertex 120
+
+         1.0f, -0.7f,  0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, //Top bl Vertex 121
+         4.0f, -0.7f, -4.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, //Top br Vertex 122
+         5.0f, -0.7f, -3.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, //Top tr Vertex 123
+         5.0f, -0.7f, -3.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, //Top tr Vertex 124
+         0.0f, -0.7f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, //Top tl Vertex 125
+         1.0f, -0.7f,  0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, //Top bl Vertex 126
+
+        //Pen Tip Pyramid
+        4.0f, -0.7f, -4.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, //Left tl Vertex 127
+        4.0f, -0.5f, -4.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, //Left bl Vertex 128
+        5.0f, -0.6f, -4.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, //Center Vertex 129
+
+        4.0f, -0.7f, -4.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Top tl Vertex 130
+        5.0f, -0.7f, -3.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Top tr Vertex 131
+        5.0f, -0.6f, -4.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Center Vertex 132
+
+        5.0f, -0.7f, -3.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, //Right tr Vertex 133
+        5.0f, -0.5f, -3.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, //Right br Vertex 134
+        5.0f, -0.6f, -4.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, //Center Vertex 135
+
+        5.0f, -0.5f, -3.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Bottom br Vertex 136
+        4.0f, -0.5f, -4.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Bottom bl Vertex 137
+        5.0f, -0.6f, -4.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Center Vertex 138
+
+        //Book Cover Planes
+         2.0f, 1.5f, 0.0f, 8.0f, 1.0f, 0.0f, 0.0f, 0.0f, //Top tl Vertex 139
+        10.0f, 1.5f, 3.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, //Top tr Vertex 140
+        -1.0f, 1.5f, 4.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, //Top bl Vertex 141
+        -1.0f, 1.5f, 4.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, //Top bl Vertex 142
+        10.0f, 1.5f, 3.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, //Top tr Vertex 143
+         7.0f, 1.5f,-1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, //Top br Vertex 144
+
+         2.0f, -0.5f, 0.0f, 8.0f, 1.0f, 0.0f, 0.0f, 0.0f, //Bottom tl Vertex 145
+        10.0f, -0.5f, 3.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, //Bottom tr Vertex 146
+        -1.0f, -0.5f, 4.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, //Bottom bl Vertex 147
+        -1.0f, -0.5f, 4.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, //Bottom bl Vertex 148
+        10.0f, -0.5f, 3.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, //Bottom tr Vertex 149
+         7.0f, -0.5f,-1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, //Bottom br Vertex 150
+
+        //Book Pages Cube
+        9.5f, -0.5f, 3.25f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, //Back br Vertex 151
+        2.5f, -0.5f, 7.75f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, //Back bl Vertex 152
+        2.5f,  1.5f, 7.75f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, //Back tl Vertex 153
+        2.5f,  1.5f, 7.75f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, //Back tl Vertex 154
+        9.5f,  1.5f, 3.25f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, //Back tr Vertex 155
+        9.5f, -0.5f, 3.25f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, //Back br Vertex 156
+
+         7.0f, -0.5f, -0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, //Front br Vertex 157
+        -0.5f, -0.5f,  4.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, //Front bl Vertex 158
+        -0.5f,  1.5f,  4.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, //Front tl Vertex 159
+        -0.5f,  1.5f,  4.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, //Front tl Vertex 160
+         7.0f,  1.5f, -0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, //Front tr Vertex 161
+         7.0f, -0.5f, -0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, //Front br Vertex 162
+
+        -0.5f,  1.5f,  4.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Left tr Vertex 163
+         2.5f,  1.5f, 7.75f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Left tl Vertex 164
+         2.5f, -0.5f, 7.75f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Left bl Vertex 165
+         2.5f, -0.5f, 7.75f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Left bl Vertex 166
+        -0.5f, -0.5f,  4.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Left br Vertex 167
+        -0.5f,  1.5f,  4.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Left tr Vertex 168
+
+         7.0f,  1.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Right tl Vertex 169
+         9.5f,  1.5f, 3.25f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Right tr Vertex 170
+         9.5f, -0.5f, 3.25f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Right br Vertex 171
+         9.5f, -0.5f, 3.25f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, //Right br Vertex 172
+         7.0f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, //Right bl Vertex 173
+         7.0f,  1.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, //Right tl Vertex 174
+
+        -0.5f, -0.5f,  4.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, //Bottom bl Vertex 175
+         7.0f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, //Bottom br Vertex 176
+         9.5f, -0.5f, 3.25f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, //Bottom tr Vertex 177
+         9.5f, -0.5f, 3.25f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, //Bottom tr Vertex 178
+         2.5f, -0.5f, 7.75f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, //Bottom tl Vertex 179
+        -0.5f, -0.5f,  4.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, //Bottom bl Vertex 180
+
+        -0.5f, 1.5f,  4.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, //Top bl Vertex 181
+         7.0f, 1.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, //Top br Vertex 182
+         9.5f, 1.5f, 3.25f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, //Top tr Vertex 183
+         9.5f, 1.5f, 3.25f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, //Top tr Vertex 184
+         2.5f, 1.5f, 7.75f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, //Top tl Vertex 185
+        -0.5f, 1.5f,  4.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, //Top bl Vertex 186
+
+
+    };
+
+    const GLuint floatsPerVertex = 3;
+    const GLuint floatsPerNormal = 3;
+    const GLuint floatsPerUV = 2;
+
+    const GLuint floatsPerFullVertex = floatsPerVertex + floatsPerNormal + floatsPerUV;
+    static_assert(sizeof(verts) / sizeof(verts[0]) % (floatsPerFullVertex * 3) == 0, "verts[] must hold whole triangles");
+
+    // Every object at full detail in object order, copied from verts[] or generated, then the coarser
+    // levels of detail. Generated round shapes get their levels from fewer segments, modeled objects
+    // are simplified.
+    const double lodStart = glfwGetTime();
+    std::vector<GLfloat> vertices, lodVertices;
+    int nLods = 0;
+    for (int i = 0; i < OBJECT_COUNT; ++i)
+    {
+        SceneObject& object = gObjects[i];
+        std::vector<GLfloat> full;
+        std::vector<MeshLod> lods;
+        if (object.shape.type == PRIMITIVE_NONE)
+        {
+            full.assign(verts + object.firstVertex * floatsPerFullVertex, verts + (object.firstVertex + object.nVertices) * floatsPerFullVertex);
+            lods = GenerateLods(full.data(), object.nVertices, floatsPerFullVertex, MAX_LOD_COUNT - 1);
+        }
+        else
+        {
+            // Shapes compiled into the program are only placed, the others are generated here
+            PrimitiveMesh primitive;
+            if (!AppendStaticPrimitive(primitive, object.shape, PRIMITIVE_SEGMENTS))
+                AppendPrimitive(primitive, object.shape, PRIMITIVE_SEGMENTS);
+            full = PrimitiveTriangles(primitive);
+            for (int l = 1; l < MAX_LOD_COUNT && PrimitiveHasLevels(object.shape); ++l)
+            {
+                PrimitiveMesh coarse;
+                if (!AppendStaticPrimitive(coarse, object.shape, PRIMITIVE_SEGMENTS >> l))
+                    AppendPrimitive(coarse, object.shape, PRIMITIVE_SEGMENTS >> l);
+                lods.push_back({ PrimitiveTriangles(coarse), PrimitiveError(object.shape, PRIMITIVE_SEGMENTS >> l) });
+            }
+        }
+
+        object.firstVertex = GLint(vertices.size() / floatsPerFullVertex);
+        object.nVertices = GLsizei(full.size() / floatsPerFullVertex);
+        vertices.insert(vertices.end(), full.begin(), full.end());
+
+        object.lods[0] = { uint32_t(object.firstVertex), uint32_t(object.nVertices), 0.0f };
+        object.lodCount = 1;
+        object.lod = 0;
+        for (const MeshLod& lod : lods)
+        {
+            object.lods[object.lodCount++] = { uint32_t(lodVertices.size() / floatsPerFullVertex), uint32_t(lod.vertices.size() / floatsPerFullVertex), lod.error };
+            lodVertices.insert(lodVertices.end(), lod.vertices.begin(), lod.vertices.end());
+        }
+        nLods += int(lods.size());
+    }
+
+    // The coarser levels were placed relative to the end of the full detail vertices
+    const GLuint nFullVertices = GLuint(vertices.size() / floatsPerFullVertex);
+    for (SceneObject& object : gObjects)
+        for (int l = 1; l < object.lodCount; ++l)
+            object.lods[l].firstVertex += nFullVertices;
+    vertices.insert(vertices.end(), lodVertices.begin(), lodVertices.end());
+
+    mesh.nVertices = GLuint(vertices.size() / floatsPerFullVertex);
+    mesh.nLodVertices = mesh.nVertices - nFullVertices;
+    cout << "INFO: Generated " << nLods << " levels of detail (" << mesh.nLodVertices / 3 << " triangles) in "
+        << (glfwGetTime() - lodStart) * 1000.0 << " ms" << endl;
+
+    glGenVertexArrays(1, &mesh.vao); // we can also generate multiple VAOs or buffers at the same time
+    glBindVertexArray(mesh.vao);
+
+    // Create VBO
+    glGenBuffers(2, mesh.vbos);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
+
+    // Strides between vertex coordinates
+    GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
+
+    // Create Vertex Attribute Pointers
+    glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (char*)(sizeof(float) * floatsPerVertex));
+    glEnableVertexAttribArray(1);
+
+    glVertexAttribPointer(2, floatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
+    glEnableVertexAttribArray(2);
+
+    // Position-only copy of the vertices for the depth pre-pass, and the bounds of every object
+    std::vector<GLfloat> positions;
+    positions.reserve(mesh.nVertices * floatsPerVertex);
+    for (GLuint v = 0; v < mesh.nVertices; ++v)
+        positions.insert(positions.end(), &vertices[v * floatsPerFullVertex], &vertices[v * floatsPerFullVertex] + floatsPerVertex);
+
+    for (int i = 0; i < OBJECT_COUNT; ++i)
+    {
+        glm::vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+        for (GLsizei v = 0; v < gObjects[i].nVertices; ++v)
+        {
+            const GLfloat* position = &positions[(gObjects[i].firstVertex + v) * floatsPerVertex];
+            boundsMin = glm::min(boundsMin, glm::vec3(position[0], position[1], position[2]));
+            boundsMax = glm::max(boundsMax, glm::vec3(position[0], position[1], position[2]));
+        }
+        gObjects[i].center = (boundsMin + boundsMax) * 0.5f;
+        gObjects[i].extent = (boundsMax - boundsMin) * 0.5f;
+    }
+    UUpdateCullBounds();
+    gMeshPositions = positions;
+    UCreatePickScene();
+
+    glGenVertexArrays(1, &mesh.depthVao);
+    glBindVertexArray(mesh.depthVao);
+    glGenBuffers(1, &mesh.depthVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.depthVbo);
+    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(GLfloat), positions.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * floatsPerVertex, 0);
+    glEnableVertexAttribArray(0);
+
+    // Bake (or load) the static lighting, fills the lightmap coordinates buffer
+    UCreateLightmaps(mesh, vertices.data(), floatsPerFullVertex);
+}
+
+
+void UDestroyMesh(GLMesh& mesh)
+{
+    glDeleteVertexArrays(1, &mesh.vao);
+    glDeleteBuffers(2, mesh.vbos);
+    glDeleteVertexArrays(1, &mesh.depthVao);
+    glDeleteBuffers(1, &mesh.depthVbo);
+}
+
+
+// Unwraps the static objects and bakes the diffuse lighting of both lights into one lightmap
+// per object. Every level of detail is unwrapped with its object, so coarser levels sample their
+// own charts. The result is cached on disk so the bake only runs on the first launch.
+void UCreateLightmaps(GLMesh& mesh, const GLfloat* verts, GLuint floatsPerVertex)
+{
+    // The baker works in world space, like the fragment shader
+    std::vector<LightmapObject> objects(OBJECT_COUNT);
+    for (int i = 0; i < OBJECT_COUNT; ++i)
+    {
+        const glm::mat4& model = gScene.World(gObjects[i].node);
+        const glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(model)));
+        for (int l = 0; l < gObjects[i].lodCount; ++l)
+        {
+            const LodLevel& level = gObjects[i].lods[l];
+            for (uint32_t v = 0; v < level.nVertices; ++v)
+            {
+                const GLfloat* vertex = verts + (level.firstVertex + v) * floatsPerVertex;
+                objects[i].positions.push_back(glm::vec3(model * glm::vec4(vertex[0], vertex[1], vertex[2], 1.0f)));
+                objects[i].normals.push_back(glm::normalize(normalMatrix * glm::vec3(vertex[3], vertex[4], vertex[5])));
+            }
+        }
+    }
+
+    std::vector<LightmapLight> lights;
+    for (const LightPacket& light : gLights)
+        lights.push_back({ light.position, light.color });
+    const LightmapSettings settings;
+    const uint64_t key = HashLightmapInputs(objects, lights, settings);
+
+    if (LoadLightmapCache(LIGHTMAP_CACHE_PATH, key, objects))
+    {
+        cout << "INFO: Loaded lightmaps from " << LIGHTMAP_CACHE_PATH << endl;
+        gLightmapsBaked = true;
+    }
+    else
+    {
+        const double bakeStart = glfwGetTime();
+        if (BakeLightmaps(objects, lights, settings))
+        {
+            cout << "INFO: Baked lightmaps in " << (glfwGetTime() - bakeStart) * 1000.0 << " ms on " << WorkerThreadCount() << " threads" << endl;
+            gLightmapsBaked = true;
+
+            if (!SaveLightmapCache(LIGHTMAP_CACHE_PATH, key, objects))
+                cout << "Failed to write lightmap cache " << LIGHTMAP_CACHE_PATH << endl;
+        }
+        else
+        {
+            // Objects that did not fit get an empty lightmap, so fall back to dynamic lighting
+            cout << "ERROR::LIGHTMAP::UNWRAP_FAILED charts do not fit in " << settings.maxSize << "x" << settings.maxSize << ", lightmap mode off" << endl;
+            gUseLightmap = false;
+        }
+    }
+
+    // Lightmap coordinates go in their own buffer, in vertex order
+    std::vector<glm::vec2> lightmapCoordinates(mesh.nVertices, glm::vec2(0.0f));
+    for (int i = 0; i < OBJECT_COUNT; ++i)
+    {
+        std::vector<glm::vec2>::const_iterator uvs = objects[i].uvs.begin();
+        for (int l = 0; l < gObjects[i].lodCount; ++l)
+        {
+            std::copy(uvs, uvs + gObjects[i].lods[l].nVertices, lightmapCoordinates.begin() + gObjects[i].lods[l].firstVertex);
+            uvs += gObjects[i].lods[l].nVertices;
+        }
+    }
+
+    glBindVertexArray(mesh.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[1]);
+    glBufferData(GL_ARRAY_BUFFER, lightmapCoordinates.size() * sizeof(glm::vec2), lightmapCoordinates.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), 0);
+    glEnableVertexAttribArray(3);
+
+    // Diffuse from both lights can go over 1, so the lightmaps are stored as half floats
+    for (int i = 0; i < OBJECT_COUNT; ++i)
+    {
+        glGenTextures(1, &gObjects[i].lightmapId);
+        glBindTexture(GL_TEXTURE_2D, gObjects[i].lightmapId);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, objects[i].size, objects[i].size, 0, GL_RGB, GL_FLOAT, objects[i].texels.data());
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+
+void UDestroyLightmaps()
+{
+    for (int i = 0; i < OBJECT_COUNT; ++i)
+        UDestroyTexture(gObjects[i].lightmapId);
+}
+
+
+/*Generate and load the texture*/
+bool UCreateTexture(const char* filename, GLuint& textureId)
+{
+    int width, height, channels;
+    unsigned char* image = stbi_load(filename, &width, &height, &channels, 0);
+    if (image)
+    {
+        flipImageVertically(image, width, height, channels);
+
+        glGenTextures(1, &textureId);
+        glBindTexture(GL_TEXTURE_2D, textureId);
+
+        // set the texture wrapping parameters
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        // set texture filtering parameters
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        if (channels == 3)
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
+        else if (channels == 4)
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
+        else
+        {
+            cout << "Not implemented to handle image with " << channels << " channels" << endl;
+            return false;
+        }
+
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        stbi_image_free(image);
+        glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+
+        return true;
+    }
+
+    // Error loading the image
+    return false;
+}
+
+
+void UDestroyTexture(GLuint textureId)
+{
+    glDeleteTextures(1, &textureId);
+}
+
+
+// Implements the UCreateShaders function
+bool UCreateShaderProgram(const char* vtxShaderSource, const char* fragShaderSource, GLuint& programId)
+{
+    // Compilation and linkage error reporting
+    int success = 0;
+    char infoLog[512];
+
+    // Create a Shader program object.
+    programId = glCreateProgram();
+
+    // Create the vertex and fragment shader objects
+    GLuint vertexShaderId = glCreateShader(GL_VERTEX_SHADER);
+    GLuint fragmentShaderId = glCreateShader(GL_FRAGMENT_SHADER);
+
+    // Retrive the shader source
+    glShaderSource(vertexShaderId, 1, &vtxShaderSource, NULL);
+    glShaderSource(fragmentShaderId, 1, &fragShaderSource, NULL);
+
+    // Compile the vertex shader, and print compilation errors (if any)
+    glCompileShader(vertexShaderId); // compile the vertex shader
+    // check for shader compile errors
+    glGetShaderiv(vertexShaderId, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(vertexShaderId, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+
+        return false;
+    }
+
+    glCompileShader(fragmentShaderId); // compile the fragment shader
+    // check for shader compile errors
+    glGetShaderiv(fragmentShaderId, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(fragmentShaderId, sizeof(infoLog), NULL, infoLog);
+        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+
+        return false;
+    }
+
+    // Attached compiled shaders to the shader program
+    glAttachShader(programId, vertexShaderId);
+    glAttachShader(programId, fragmentShaderId);
+
+    glLinkProgram(programId);   // links the shader program
+    // check for linking errors
+    glGetProgramiv(programId, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glGetProgramInfoLog(programId, sizeof(infoLog), NULL, infoLog);
+        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+
+        return false;
+    }
+
+    glUseProgram(programId);    // Uses the shader program
+
+    return true;
+}
+
+
+// Compiles and links a program made of a single compute shader
+bool UCreateComputeProgram(const char* shaderSource, GLuint& programId)
+{
+    int success = 0;
+    char infoLog[512];
+
+    programId = glCreateProgram();
+    GLuint shaderId = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(shaderId, 1, &shaderSource, NULL);
+
+    glCompileShader(shaderId);
+    glGetShaderiv(shaderId, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(shaderId, sizeof(infoLog), NULL, infoLog);
+        std::cout << "ERROR::SHADER::COMPUTE::COMPILATION_FAILED\n" << infoLog << std::endl;
+
+        return false;
+    }
+
+    glAttachShader(programId, shaderId);
+    glLinkProgram(programId);
+    glGetProgramiv(programId, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glGetProgramInfoLog(programId, sizeof(infoLog), NULL, infoLog);
+        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+
+        return false;
+    }
+
+    return true;
+}
+
+
+void UDestroyShaderProgram(GLuint programId)
+{
+    glDeleteProgram(programId);
+}
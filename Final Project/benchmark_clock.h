@@ -0,0 +1,23 @@
+#pragma once
+
+#ifndef BENCHMARK_CLOCK_H
+#define BENCHMARK_CLOCK_H
+
+#include <chrono>
+
+// Wall clock shared by the --benchmark modes
+typedef std::chrono::high_resolution_clock BenchmarkClock;
+
+// Milliseconds from start to end
+inline double ElapsedMs(BenchmarkClock::time_point start, BenchmarkClock::time_point end)
+{
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Milliseconds since start
+inline double ElapsedMs(BenchmarkClock::time_point start)
+{
+    return ElapsedMs(start, BenchmarkClock::now());
+}
+
+#endif
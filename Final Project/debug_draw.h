@@ -0,0 +1,214 @@
+#pragma once
+
+#ifndef DEBUG_DRAW_H
+#define DEBUG_DRAW_H
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef NDEBUG
+#include "simulation.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#endif
+
+// Immediate mode debug drawing: lines, boxes, spheres, frusta and axes queued from any thread during
+// a frame and drawn together by the render thread in one draw call. Every primitive is broken into
+// lines on the calling thread and queued in that thread's own buffer, so queuing takes no lock; the
+// render thread drains all the buffers when it flushes. A primitive is drawn once, by the next flush.
+// With NDEBUG defined none of this exists and the calls do nothing.
+
+// RGBA packed with red in the low byte, as the vertex shader reads it (four normalized bytes)
+inline uint32_t DebugColor(float r, float g, float b, float a = 1.0f)
+{
+    const auto byte = [](float value) { return uint32_t(std::fmin(std::fmax(value, 0.0f), 1.0f) * 255.0f + 0.5f); };
+    return byte(r) | byte(g) << 8 | byte(b) << 16 | byte(a) << 24;
+}
+
+const uint32_t DEBUG_RED = 0xff0000ff;
+const uint32_t DEBUG_GREEN = 0xff00ff00;
+const uint32_t DEBUG_BLUE = 0xffff0000;
+const uint32_t DEBUG_YELLOW = 0xff00ffff;
+const uint32_t DEBUG_WHITE = 0xffffffff;
+
+const int DEBUG_SPHERE_SEGMENTS = 24;           // Segments of each of the three circles drawing a sphere
+
+struct DebugVertex
+{
+    glm::vec3 position;
+    uint32_t color;
+};
+
+struct DebugLine
+{
+    DebugVertex from;
+    DebugVertex to;
+};
+
+#ifndef NDEBUG
+
+const size_t DEBUG_LINES_PER_THREAD = 16384;    // Lines a thread can queue before the next flush
+
+// Line buffers of every thread that queued a line. A thread's buffer is created on its first line
+// and only that thread pushes into it; the mutex guards the list of buffers, not the lines.
+class DebugDrawBuffers
+{
+public:
+    // Calling thread: queues a line, dropped when the thread's buffer is full
+    void Line(const DebugLine& line)
+    {
+        if (!LocalBuffer().Push(line))
+            dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Drawing thread: lines queued so far on every thread
+    size_t Pending() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t pending = 0;
+        for (const std::unique_ptr<ThreadBuffer>& buffer : buffers)
+            pending += buffer->Size();
+        return pending;
+    }
+
+    // Drawing thread: moves up to maxLines queued lines into out, two vertices each, and returns how
+    // many were moved. Lines that did not fit stay queued for the next flush.
+    size_t Flush(DebugVertex* out, size_t maxLines)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t flushed = 0;
+        DebugLine line;
+        for (size_t b = 0; b < buffers.size() && flushed < maxLines; ++b)
+            while (flushed < maxLines && buffers[b]->Pop(line))
+            {
+                out[flushed * 2] = line.from;
+                out[flushed * 2 + 1] = line.to;
+                ++flushed;
+            }
+        return flushed;
+    }
+
+    // Lines dropped since the last call
+    size_t TakeDropped() { return dropped.exchange(0, std::memory_order_relaxed); }
+
+private:
+    typedef SpscQueue<DebugLine, DEBUG_LINES_PER_THREAD> ThreadBuffer;
+
+    ThreadBuffer& LocalBuffer()
+    {
+        struct Local
+        {
+            const DebugDrawBuffers* owner;
+            ThreadBuffer* buffer;
+        };
+        static thread_local Local local = { nullptr, nullptr };
+        if (local.owner != this)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            buffers.emplace_back(new ThreadBuffer());
+            local = { this, buffers.back().get() };
+        }
+        return *local.buffer;
+    }
+
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;     // Kept when their thread exits, still drained
+    std::atomic<size_t> dropped{ 0 };
+};
+
+// Debug lines shared by the whole program
+inline DebugDrawBuffers& DebugDraw()
+{
+    static DebugDrawBuffers buffers;
+    return buffers;
+}
+
+inline void DebugDrawLine(const glm::vec3& from, const glm::vec3& to, uint32_t color)
+{
+    DebugDraw().Line({ { from, color }, { to, color } });
+}
+
+// Box of half size extent around center in the space of transform. Corner i takes the positive
+// extent on x, y and z for bits 0, 1 and 2, and every edge joins corners one bit apart.
+inline void DebugDrawBox(const glm::mat4& transform, const glm::vec3& center, const glm::vec3& extent, uint32_t color)
+{
+    glm::vec3 corners[8];
+    for (int i = 0; i < 8; ++i)
+    {
+        const glm::vec3 corner(center.x + (i & 1 ? extent.x : -extent.x), center.y + (i & 2 ? extent.y : -extent.y),
+            center.z + (i & 4 ? extent.z : -extent.z));
+        corners[i] = glm::vec3(transform * glm::vec4(corner, 1.0f));
+    }
+    for (int i = 0; i < 8; ++i)
+        for (int bit = 1; bit < 8; bit <<= 1)
+            if (!(i & bit))
+                DebugDrawLine(corners[i], corners[i | bit], color);
+}
+
+inline void DebugDrawAabb(const glm::vec3& min, const glm::vec3& max, uint32_t color)
+{
+    DebugDrawBox(glm::mat4(1.0f), (min + max) * 0.5f, (max - min) * 0.5f, color);
+}
+
+// Three circles, one around each axis
+inline void DebugDrawSphere(const glm::vec3& center, float radius, uint32_t color)
+{
+    const float step = 6.28318531f / DEBUG_SPHERE_SEGMENTS;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        glm::vec3 previous;
+        for (int i = 0; i <= DEBUG_SPHERE_SEGMENTS; ++i)
+        {
+            const float c = std::cos(i * step) * radius, s = std::sin(i * step) * radius;
+            const glm::vec3 point = center + (axis == 0 ? glm::vec3(0.0f, c, s) : axis == 1 ? glm::vec3(c, 0.0f, s) : glm::vec3(c, s, 0.0f));
+            if (i > 0)
+                DebugDrawLine(previous, point, color);
+            previous = point;
+        }
+    }
+}
+
+// Edges of the volume viewProjection maps to clip space, corners found by unprojecting the corners
+// of the normalized device cube
+inline void DebugDrawFrustum(const glm::mat4& viewProjection, uint32_t color)
+{
+    const glm::mat4 inverse = glm::inverse(viewProjection);
+    glm::vec3 corners[8];
+    for (int i = 0; i < 8; ++i)
+    {
+        const glm::vec4 corner = inverse * glm::vec4(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f, 1.0f);
+        corners[i] = glm::vec3(corner) / corner.w;
+    }
+    for (int i = 0; i < 8; ++i)
+        for (int bit = 1; bit < 8; bit <<= 1)
+            if (!(i & bit))
+                DebugDrawLine(corners[i], corners[i | bit], color);
+}
+
+// The x, y and z axes of transform in red, green and blue, size long
+inline void DebugDrawAxes(const glm::mat4& transform, float size)
+{
+    const glm::vec3 origin(transform[3]);
+    DebugDrawLine(origin, origin + glm::normalize(glm::vec3(transform[0])) * size, DEBUG_RED);
+    DebugDrawLine(origin, origin + glm::normalize(glm::vec3(transform[1])) * size, DEBUG_GREEN);
+    DebugDrawLine(origin, origin + glm::normalize(glm::vec3(transform[2])) * size, DEBUG_BLUE);
+}
+
+#else
+
+inline void DebugDrawLine(const glm::vec3&, const glm::vec3&, uint32_t) {}
+inline void DebugDrawBox(const glm::mat4&, const glm::vec3&, const glm::vec3&, uint32_t) {}
+inline void DebugDrawAabb(const glm::vec3&, const glm::vec3&, uint32_t) {}
+inline void DebugDrawSphere(const glm::vec3&, float, uint32_t) {}
+inline void DebugDrawFrustum(const glm::mat4&, uint32_t) {}
+inline void DebugDrawAxes(const glm::mat4&, float) {}
+
+#endif
+
+#endif
@@ -0,0 +1,87 @@
+#pragma once
+
+#ifndef DRAW_COMMANDS_H
+#define DRAW_COMMANDS_H
+
+#include "parallel_for.h"
+#include "scene_entities.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Draw lists recorded in parallel: the visible draws are split into partitions, each recorded into
+// its own command buffer and sorted there by whichever thread picks it up, then the sorted buffers
+// are merged into one list the GL thread replays without looking at anything else.
+
+// Everything the submission loop needs for a draw, in 16 bytes so a list of them streams through the
+// cache. transform indexes the draws the command was recorded from.
+struct DrawCommand
+{
+    uint32_t key;               // Submission order: the material, draws with the same key share their state
+    uint32_t firstVertex;
+    uint32_t nVertices;
+    uint32_t transform;
+};
+
+typedef std::vector<DrawCommand> CommandBuffer;
+
+const size_t DRAW_PARTITIONS_PER_THREAD = 4;    // More partitions than threads, so they balance
+const size_t MIN_DRAWS_PER_PARTITION = 1024;    // Below this a partition costs more than it saves
+
+// Records a command for every visible draw into buffers, one per partition of visible, in parallel.
+// Each buffer ends up sorted by key. Buffers are reused from frame to frame.
+inline void RecordDrawCommands(const std::vector<DrawPacket>& draws, const uint32_t* visible, size_t nVisible, std::vector<CommandBuffer>& buffers)
+{
+    const size_t nPartitions = std::max<size_t>(1, std::min<size_t>(WorkerThreadCount() * DRAW_PARTITIONS_PER_THREAD,
+        (nVisible + MIN_DRAWS_PER_PARTITION - 1) / MIN_DRAWS_PER_PARTITION));
+    buffers.resize(nPartitions);
+
+    ParallelFor(nPartitions, 1, [&](size_t begin, size_t end)
+    {
+        for (size_t p = begin; p < end; ++p)
+        {
+            CommandBuffer& buffer = buffers[p];
+            buffer.clear();
+            const size_t first = nVisible * p / nPartitions, last = nVisible * (p + 1) / nPartitions;
+            for (size_t i = first; i < last; ++i)
+            {
+                const DrawPacket& draw = draws[visible[i]];
+                buffer.push_back({ draw.material, draw.firstVertex, draw.nVertices, visible[i] });
+            }
+            std::sort(buffer.begin(), buffer.end(), [](const DrawCommand& a, const DrawCommand& b) { return a.key < b.key; });
+        }
+    });
+}
+
+// Merges the sorted buffers into one list sorted by key. Keys are few, so whole runs of equal keys
+// are copied at once.
+inline void MergeDrawCommands(const std::vector<CommandBuffer>& buffers, CommandBuffer& merged)
+{
+    size_t total = 0;
+    for (const CommandBuffer& buffer : buffers)
+        total += buffer.size();
+    merged.resize(total);
+
+    std::vector<size_t> heads(buffers.size(), 0);
+    size_t out = 0;
+    while (out < total)
+    {
+        // Buffer whose next command has the smallest key
+        size_t source = SIZE_MAX;
+        for (size_t b = 0; b < buffers.size(); ++b)
+            if (heads[b] < buffers[b].size() && (source == SIZE_MAX || buffers[b][heads[b]].key < buffers[source][heads[source]].key))
+                source = b;
+
+        const CommandBuffer& buffer = buffers[source];
+        const uint32_t key = buffer[heads[source]].key;
+        size_t runEnd = heads[source];
+        while (runEnd < buffer.size() && buffer[runEnd].key == key)
+            ++runEnd;
+        std::copy(buffer.begin() + heads[source], buffer.begin() + runEnd, merged.begin() + out);
+        out += runEnd - heads[source];
+        heads[source] = runEnd;
+    }
+}
+
+#endif
@@ -0,0 +1,345 @@
+#pragma once
+
+#ifndef ENTITY_STORE_H
+#define ENTITY_STORE_H
+
+#include "parallel_for.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// Handle to an entity. The generation changes when the slot is reused, so stale handles are detected.
+struct Entity
+{
+    uint32_t index;
+    uint32_t generation;
+};
+
+typedef uint64_t ComponentMask;
+const uint32_t MAX_COMPONENT_TYPES = 64;
+
+// Size of every registered component type, indexed by component id
+inline std::vector<size_t>& ComponentSizes()
+{
+    static std::vector<size_t> sizes;
+    return sizes;
+}
+
+// Small sequential id per component type, assigned on first use. Ids index fixed size tables and
+// bits of a ComponentMask, so registering more than MAX_COMPONENT_TYPES types stops the program.
+template <typename T>
+uint32_t ComponentId()
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Components are moved around with memcpy");
+    static const uint32_t id = []()
+    {
+        const uint32_t next = uint32_t(ComponentSizes().size());
+        if (next >= MAX_COMPONENT_TYPES)
+        {
+            std::cout << "ERROR::ENTITY_STORE::TOO_MANY_COMPONENT_TYPES more than " << MAX_COMPONENT_TYPES << " registered" << std::endl;
+            std::abort();
+        }
+        ComponentSizes().push_back(sizeof(T));
+        return next;
+    }();
+    return id;
+}
+
+template <typename... T>
+ComponentMask ComponentMaskOf()
+{
+    ComponentMask mask = 0;
+    const int expand[] = { 0, (mask |= ComponentMask(1) << ComponentId<T>(), 0)... };
+    (void)expand;
+    return mask;
+}
+
+// One chunk of an archetype as seen by a system: a run of entities with each component in its own array
+class EntityChunk
+{
+public:
+    EntityChunk(uint8_t* data, const uint32_t* offsets, const uint32_t* entities, uint32_t count)
+        : data(data), offsets(offsets), entities(entities), count(count)
+    {
+    }
+
+    // Component array of the chunk, nullptr when the archetype lacks the component
+    template <typename T>
+    T* Get() const
+    {
+        const uint32_t offset = offsets[ComponentId<T>()];
+        return offset != NO_COMPONENT ? reinterpret_cast<T*>(data + offset) : nullptr;
+    }
+
+    // Entity index of every row
+    const uint32_t* Entities() const { return entities; }
+    uint32_t Count() const { return count; }
+
+    static const uint32_t NO_COMPONENT = UINT32_MAX;
+
+private:
+    uint8_t* data;
+    const uint32_t* offsets;
+    const uint32_t* entities;
+    uint32_t count;
+};
+
+// Entity-component store grouping entities by their exact component set (archetype). Each archetype
+// keeps its entities in fixed size chunks laid out as struct of arrays, so systems stream through
+// exactly the components they use and different chunks can be processed on different threads.
+class EntityStore
+{
+public:
+    static const size_t CHUNK_BYTES = 16 * 1024;
+    static const size_t ARRAY_ALIGNMENT = 64;       // Every component array starts on a cache line
+
+    EntityStore() = default;
+    EntityStore(const EntityStore&) = delete;
+    EntityStore& operator=(const EntityStore&) = delete;
+
+    // Creates an entity with the given components
+    template <typename... T>
+    Entity Create(const T&... components)
+    {
+        const uint32_t archetypeIndex = FindOrCreateArchetype(ComponentMaskOf<T...>());
+        Archetype& archetype = *archetypes[archetypeIndex];
+        const Entity entity = AllocateEntity();
+        uint32_t chunkIndex, row;
+        AddRow(archetypeIndex, entity.index, chunkIndex, row);
+
+        Chunk& chunk = archetype.chunks[chunkIndex];
+        const int expand[] = { 0, (std::memcpy(chunk.data.get() + archetype.offsets[ComponentId<T>()] + row * sizeof(T), &components, sizeof(T)), 0)... };
+        (void)expand;
+        return entity;
+    }
+
+    // Removes the entity, the last entity of its chunk takes its place
+    void Destroy(Entity entity)
+    {
+        if (!Alive(entity))
+            return;
+
+        Location& location = locations[entity.index];
+        Archetype& archetype = *archetypes[location.archetype];
+        RemoveRow(archetype, location.chunk, location.row);
+
+        location.archetype = NO_ARCHETYPE;
+        ++generations[entity.index];
+        freeIndices.push_back(entity.index);
+        --entityCount;
+    }
+
+    bool Alive(Entity entity) const
+    {
+        return entity.index < generations.size() && generations[entity.index] == entity.generation
+            && locations[entity.index].archetype != NO_ARCHETYPE;
+    }
+
+    // Component of a single entity, nullptr when it is dead or does not have the component
+    template <typename T>
+    T* Get(Entity entity)
+    {
+        if (!Alive(entity))
+            return nullptr;
+
+        const Location& location = locations[entity.index];
+        const Archetype& archetype = *archetypes[location.archetype];
+        const uint32_t offset = archetype.offsets[ComponentId<T>()];
+        if (offset == EntityChunk::NO_COMPONENT)
+            return nullptr;
+
+        return reinterpret_cast<T*>(archetype.chunks[location.chunk].data.get() + offset) + location.row;
+    }
+
+    // Every non-empty chunk whose archetype has at least the components T
+    template <typename... T>
+    std::vector<EntityChunk> Chunks()
+    {
+        const ComponentMask mask = ComponentMaskOf<T...>();
+        std::vector<EntityChunk> result;
+        for (const std::unique_ptr<Archetype>& archetype : archetypes)
+        {
+            if ((archetype->mask & mask) != mask)
+                continue;
+
+            for (Chunk& chunk : archetype->chunks)
+                if (chunk.count > 0)
+                    result.emplace_back(chunk.data.get(), archetype->offsets, chunk.entities.data(), chunk.count);
+        }
+        return result;
+    }
+
+    // Runs fn(EntityChunk&) on every chunk with the components T, one chunk per task across all worker threads
+    template <typename... T, typename Function>
+    void ParallelForEachChunk(Function fn)
+    {
+        std::vector<EntityChunk> chunks = Chunks<T...>();
+        ParallelFor(chunks.size(), 1, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                fn(chunks[i]);
+        });
+    }
+
+    size_t EntityCount() const { return entityCount; }
+    size_t ArchetypeCount() const { return archetypes.size(); }
+
+private:
+    static const uint32_t NO_ARCHETYPE = UINT32_MAX;
+
+    struct ChunkDelete
+    {
+        void operator()(uint8_t* data) const { ::operator delete(data, std::align_val_t(ARRAY_ALIGNMENT)); }
+    };
+
+    struct Chunk
+    {
+        std::unique_ptr<uint8_t[], ChunkDelete> data;   // ARRAY_ALIGNMENT aligned
+        std::vector<uint32_t> entities;     // Entity index of every row
+        uint32_t count = 0;
+    };
+
+    struct Archetype
+    {
+        ComponentMask mask;
+        uint32_t offsets[MAX_COMPONENT_TYPES];  // Start of each component array in a chunk, NO_COMPONENT if absent
+        std::vector<uint32_t> components;       // Ids of the components present
+        uint32_t capacity;                      // Entities per chunk
+        std::vector<Chunk> chunks;
+        uint32_t firstFree = 0;                 // Chunks before this one are full
+    };
+
+    struct Location
+    {
+        uint32_t archetype;
+        uint32_t chunk;
+        uint32_t row;
+    };
+
+    std::vector<std::unique_ptr<Archetype>> archetypes;
+    std::vector<Location> locations;
+    std::vector<uint32_t> generations;
+    std::vector<uint32_t> freeIndices;
+    size_t entityCount = 0;
+
+    uint32_t FindOrCreateArchetype(ComponentMask mask)
+    {
+        for (uint32_t i = 0; i < archetypes.size(); ++i)
+            if (archetypes[i]->mask == mask)
+                return i;
+
+        std::unique_ptr<Archetype> archetype(new Archetype());
+        archetype->mask = mask;
+        size_t rowSize = 0;
+        for (uint32_t id = 0; id < MAX_COMPONENT_TYPES; ++id)
+        {
+            archetype->offsets[id] = EntityChunk::NO_COMPONENT;
+            if (mask & (ComponentMask(1) << id))
+            {
+                archetype->components.push_back(id);
+                rowSize += ComponentSizes()[id];
+            }
+        }
+
+        // Arrays are ARRAY_ALIGNMENT aligned, leave room for the padding between them
+        const size_t padding = archetype->components.size() * ARRAY_ALIGNMENT;
+        archetype->capacity = uint32_t(rowSize > 0 && CHUNK_BYTES > padding + rowSize ? (CHUNK_BYTES - padding) / rowSize : 1);
+
+        uint32_t offset = 0;
+        for (uint32_t id : archetype->components)
+        {
+            archetype->offsets[id] = offset;
+            offset += uint32_t(ArrayBytes(id, archetype->capacity));
+        }
+
+        archetypes.push_back(std::move(archetype));
+        return uint32_t(archetypes.size() - 1);
+    }
+
+    Entity AllocateEntity()
+    {
+        uint32_t index;
+        if (!freeIndices.empty())
+        {
+            index = freeIndices.back();
+            freeIndices.pop_back();
+        }
+        else
+        {
+            index = uint32_t(generations.size());
+            generations.push_back(0);
+            locations.push_back(Location());
+        }
+
+        ++entityCount;
+        return { index, generations[index] };
+    }
+
+    // Bytes of one component array, rounded up so the next array stays aligned
+    static size_t ArrayBytes(uint32_t id, uint32_t capacity)
+    {
+        return (ComponentSizes()[id] * capacity + ARRAY_ALIGNMENT - 1) & ~(ARRAY_ALIGNMENT - 1);
+    }
+
+    size_t ChunkBytes(const Archetype& archetype) const
+    {
+        size_t bytes = 0;
+        for (uint32_t id : archetype.components)
+            bytes += ArrayBytes(id, archetype.capacity);
+        return bytes;
+    }
+
+    void AddRow(uint32_t archetypeIndex, uint32_t entityIndex, uint32_t& chunkIndex, uint32_t& row)
+    {
+        Archetype& archetype = *archetypes[archetypeIndex];
+        while (archetype.firstFree < archetype.chunks.size() && archetype.chunks[archetype.firstFree].count == archetype.capacity)
+            ++archetype.firstFree;
+
+        if (archetype.firstFree == archetype.chunks.size())
+        {
+            archetype.chunks.emplace_back();
+            Chunk& chunk = archetype.chunks.back();
+            chunk.data.reset(static_cast<uint8_t*>(::operator new(ChunkBytes(archetype), std::align_val_t(ARRAY_ALIGNMENT))));
+            chunk.entities.reserve(archetype.capacity);
+        }
+
+        chunkIndex = archetype.firstFree;
+        Chunk& chunk = archetype.chunks[chunkIndex];
+        row = chunk.count++;
+        chunk.entities.push_back(entityIndex);
+        locations[entityIndex] = { archetypeIndex, chunkIndex, row };
+    }
+
+    // Swap-removes a row, moving the chunk's last row into the gap
+    void RemoveRow(Archetype& archetype, uint32_t chunkIndex, uint32_t row)
+    {
+        Chunk& chunk = archetype.chunks[chunkIndex];
+        const uint32_t last = chunk.count - 1;
+        if (row != last)
+        {
+            for (uint32_t id : archetype.components)
+            {
+                const size_t size = ComponentSizes()[id];
+                uint8_t* array = chunk.data.get() + archetype.offsets[id];
+                std::memcpy(array + row * size, array + last * size, size);
+            }
+
+            chunk.entities[row] = chunk.entities[last];
+            locations[chunk.entities[row]].row = row;
+        }
+
+        chunk.entities.pop_back();
+        --chunk.count;
+        archetype.firstFree = std::min(archetype.firstFree, chunkIndex);
+    }
+};
+
+#endif
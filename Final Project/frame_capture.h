@@ -0,0 +1,259 @@
+#pragma once
+
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Frame capture output: frames read back from GL are handed to a writer thread, which encodes and
+// writes them while the render loop moves on. Either one binary PPM per frame, or a single raw Y4M
+// video (4:2:0, full range) when the path ends in .y4m.
+
+// Pixels of one frame as read back: RGBA rows, bottom row first
+struct CaptureFrame
+{
+    uint64_t index;
+    int width;
+    int height;
+    std::vector<uint8_t> pixels;
+};
+
+inline bool IsY4mPath(const std::string& path)
+{
+    return path.size() >= 4 && path.compare(path.size() - 4, 4, ".y4m") == 0;
+}
+
+// Binary PPM (P6): RGB rows, top row first
+inline bool WritePpm(const std::string& path, const CaptureFrame& frame, std::vector<uint8_t>& scratch)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    scratch.resize(size_t(frame.width) * frame.height * 3);
+    for (int y = 0; y < frame.height; ++y)
+    {
+        const uint8_t* source = frame.pixels.data() + size_t(frame.height - 1 - y) * frame.width * 4;
+        uint8_t* row = scratch.data() + size_t(y) * frame.width * 3;
+        for (int x = 0; x < frame.width; ++x)
+        {
+            row[x * 3] = source[x * 4];
+            row[x * 3 + 1] = source[x * 4 + 1];
+            row[x * 3 + 2] = source[x * 4 + 2];
+        }
+    }
+
+    fprintf(file, "P6\n%d %d\n255\n", frame.width, frame.height);
+    const bool written = fwrite(scratch.data(), 1, scratch.size(), file) == scratch.size();
+    return fclose(file) == 0 && written;
+}
+
+// Appends a Y4M frame: full resolution luma, then both chromas averaged over 2x2 pixels (BT.601,
+// full range). Odd widths and heights lose their last column or row.
+inline bool WriteY4mFrame(FILE* file, const CaptureFrame& frame, std::vector<uint8_t>& scratch)
+{
+    const int width = frame.width & ~1, height = frame.height & ~1;
+    const size_t lumaSize = size_t(width) * height, chromaSize = lumaSize / 4;
+    scratch.resize(lumaSize + 2 * chromaSize);
+    uint8_t* luma = scratch.data();
+    uint8_t* cb = luma + lumaSize;
+    uint8_t* cr = cb + chromaSize;
+
+    const auto pixel = [&](int x, int y) { return frame.pixels.data() + (size_t(frame.height - 1 - y) * frame.width + x) * 4; };
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+        {
+            const uint8_t* p = pixel(x, y);
+            luma[size_t(y) * width + x] = uint8_t(std::min(255.0f, 0.299f * p[0] + 0.587f * p[1] + 0.114f * p[2] + 0.5f));
+        }
+    for (int y = 0; y < height; y += 2)
+        for (int x = 0; x < width; x += 2)
+        {
+            float r = 0.0f, g = 0.0f, b = 0.0f;
+            for (int k = 0; k < 4; ++k)
+            {
+                const uint8_t* p = pixel(x + (k & 1), y + (k >> 1));
+                r += p[0];
+                g += p[1];
+                b += p[2];
+            }
+            r *= 0.25f;
+            g *= 0.25f;
+            b *= 0.25f;
+            const size_t c = size_t(y / 2) * (width / 2) + x / 2;
+            cb[c] = uint8_t(std::min(255.0f, std::max(0.0f, 128.0f - 0.168736f * r - 0.331264f * g + 0.5f * b + 0.5f)));
+            cr[c] = uint8_t(std::min(255.0f, std::max(0.0f, 128.0f + 0.5f * r - 0.418688f * g - 0.081312f * b + 0.5f)));
+        }
+
+    return fputs("FRAME\n", file) >= 0 && fwrite(scratch.data(), 1, scratch.size(), file) == scratch.size();
+}
+
+// Writer thread with a bounded queue. Submit never blocks: when the writer falls QUEUE_FRAMES behind,
+// frames are dropped rather than stalling the render loop. Pixel buffers go back to a pool once
+// written, so steady capture allocates nothing.
+class CaptureWriter
+{
+public:
+    static const size_t QUEUE_FRAMES = 8;
+
+    struct Stats
+    {
+        size_t written;             // Since the last ResetStats
+        size_t dropped;             // Queue full
+        size_t failed;              // Write errors
+        size_t queued;              // Now
+    };
+
+    CaptureWriter() = default;
+    CaptureWriter(const CaptureWriter&) = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+    ~CaptureWriter() { Close(); }
+
+    // path is a .y4m file, or the prefix of the numbered .ppm files. fps only goes in the Y4M header.
+    bool Open(const std::string& path, int fps)
+    {
+        Close();
+        this->path = path;
+        this->fps = std::max(fps, 1);
+        video = IsY4mPath(path);
+        stopping = false;
+        stats = Stats();
+        writer = std::thread([this]() { WriterThread(); });
+        return true;
+    }
+
+    // Writes out whatever is queued, then stops the writer
+    void Close()
+    {
+        if (!writer.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        writer.join();
+        if (file)
+        {
+            fclose(file);
+            file = nullptr;
+        }
+    }
+
+    bool IsOpen() const { return writer.joinable(); }
+
+    // A pixel buffer to fill and submit, from the pool when there is one
+    std::vector<uint8_t> TakeBuffer()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pool.empty())
+            return std::vector<uint8_t>();
+        std::vector<uint8_t> buffer = std::move(pool.back());
+        pool.pop_back();
+        return buffer;
+    }
+
+    // Queues the frame, returns false when it was dropped
+    bool Submit(CaptureFrame&& frame)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (queue.size() >= QUEUE_FRAMES)
+            {
+                ++stats.dropped;
+                pool.push_back(std::move(frame.pixels));
+                return false;
+            }
+            queue.push_back(std::move(frame));
+        }
+        wake.notify_one();
+        return true;
+    }
+
+    Stats GetStats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Stats result = stats;
+        result.queued = queue.size();
+        return result;
+    }
+
+    void ResetStats()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats = Stats();
+    }
+
+private:
+    void WriterThread()
+    {
+        std::vector<uint8_t> scratch;
+        for (;;)
+        {
+            CaptureFrame frame;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+                if (queue.empty())
+                    return;
+                frame = std::move(queue.front());
+                queue.pop_front();
+            }
+
+            const bool written = video ? WriteVideoFrame(frame, scratch) : WritePpm(FramePath(frame.index), frame, scratch);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            ++(written ? stats.written : stats.failed);
+            pool.push_back(std::move(frame.pixels));
+        }
+    }
+
+    // The video takes the size of its first frame, frames of another size are not written
+    bool WriteVideoFrame(const CaptureFrame& frame, std::vector<uint8_t>& scratch)
+    {
+        if (!file)
+        {
+            file = fopen(path.c_str(), "wb");
+            if (!file)
+                return false;
+            videoWidth = frame.width;
+            videoHeight = frame.height;
+            fprintf(file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n", videoWidth & ~1, videoHeight & ~1, fps);
+        }
+        if (frame.width != videoWidth || frame.height != videoHeight)
+            return false;
+        return WriteY4mFrame(file, frame, scratch);
+    }
+
+    std::string FramePath(uint64_t index) const
+    {
+        char number[32];
+        snprintf(number, sizeof(number), "_%06llu.ppm", (unsigned long long)index);
+        return path + number;
+    }
+
+    std::string path;
+    int fps = 60;
+    bool video = false;
+    FILE* file = nullptr;               // Only touched by the writer thread until it is joined
+    int videoWidth = 0;
+    int videoHeight = 0;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<CaptureFrame> queue;
+    std::vector<std::vector<uint8_t>> pool;
+    Stats stats = Stats();
+    bool stopping = false;
+    std::thread writer;
+};
+
+#endif
@@ -0,0 +1,102 @@
+#pragma once
+
+#ifndef FRAME_LIMITER_H
+#define FRAME_LIMITER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+// Holds the frame rate to a target without vsync. Sleeping alone wakes up late by the scheduler's
+// granularity (a millisecond or more, far more on some systems), spinning alone burns a core, so the
+// limiter sleeps in short slices while the time left exceeds what a slice has been seen to take and
+// spins, yielding, through the rest.
+class FrameLimiter
+{
+public:
+    struct Stats
+    {
+        double sleptMs;             // Since the last ResetStats
+        double spunMs;
+        double sleepEstimateMs;     // What a slice is expected to take at worst
+    };
+
+    // 0 turns the limiter off
+    void SetTargetFps(double fps)
+    {
+        period = fps > 0.0 ? 1.0 / fps : 0.0;
+        next = Clock::now();
+    }
+
+    bool Enabled() const { return period > 0.0; }
+    double TargetFps() const { return period > 0.0 ? 1.0 / period : 0.0; }
+
+    // Returns once the next frame is due
+    void Wait()
+    {
+        if (period <= 0.0)
+            return;
+
+        const Clock::time_point start = Clock::now();
+        next += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(period));
+
+        // More than a frame late: start over from now rather than rushing the next frames out
+        if (start > next)
+        {
+            next = start;
+            return;
+        }
+
+        while (Seconds(next - Clock::now()) > sleepEstimate)
+        {
+            const Clock::time_point before = Clock::now();
+            std::this_thread::sleep_for(SLEEP_SLICE);
+            UpdateEstimate(Seconds(Clock::now() - before));
+        }
+        const Clock::time_point spinStart = Clock::now();
+        while (Clock::now() < next)
+            std::this_thread::yield();
+
+        sleptSeconds += Seconds(spinStart - start);
+        spunSeconds += Seconds(Clock::now() - spinStart);
+    }
+
+    Stats GetStats() const { return { sleptSeconds * 1000.0, spunSeconds * 1000.0, sleepEstimate * 1000.0 }; }
+
+    void ResetStats()
+    {
+        sleptSeconds = 0.0;
+        spunSeconds = 0.0;
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    static double Seconds(Clock::duration duration) { return std::chrono::duration<double>(duration).count(); }
+
+    // Running mean and variance of the slices (Welford), the estimate is one deviation above the mean.
+    // Past MAX_SAMPLES new slices keep a fixed weight, so the estimate follows changes in system load.
+    void UpdateEstimate(double observed)
+    {
+        samples = std::min(samples + 1.0, MAX_SAMPLES);
+        const double delta = observed - mean;
+        mean += delta / samples;
+        variance += (delta * (observed - mean) - variance) / samples;
+        sleepEstimate = mean + std::sqrt(std::max(variance, 0.0));
+    }
+
+    const std::chrono::milliseconds SLEEP_SLICE{ 1 };
+    const double MAX_SAMPLES = 256.0;
+
+    double period = 0.0;
+    Clock::time_point next;
+    double sleepEstimate = 0.002;   // Seconds, until slices have been measured
+    double mean = 0.002;
+    double variance = 0.0;
+    double samples = 0.0;
+    double sleptSeconds = 0.0;
+    double spunSeconds = 0.0;
+};
+
+#endif
@@ -0,0 +1,251 @@
+#pragma once
+
+#ifndef FRUSTUM_CULL_H
+#define FRUSTUM_CULL_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRUSTUM_CULL_SSE
+#endif
+
+// Bounds are processed in groups of this many objects, the arrays are padded to a multiple of it
+const size_t CULL_WIDTH = 8;
+
+// Six planes as (normal, distance), normals pointing inwards: a point p is inside a plane
+// when dot(normal, p) + distance >= 0
+struct Frustum
+{
+    glm::vec4 planes[6];
+};
+
+// Extracts the left, right, bottom, top, near and far planes of a view-projection matrix
+// (Gribb & Hartmann: each plane is the fourth row plus or minus one of the other rows)
+inline Frustum ExtractFrustum(const glm::mat4& viewProjection)
+{
+    glm::vec4 rows[4];
+    for (int r = 0; r < 4; ++r)
+        rows[r] = glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+
+    Frustum frustum;
+    for (int i = 0; i < 3; ++i)
+    {
+        frustum.planes[i * 2 + 0] = rows[3] + rows[i];
+        frustum.planes[i * 2 + 1] = rows[3] - rows[i];
+    }
+
+    for (glm::vec4& plane : frustum.planes)
+        plane = plane / glm::length(glm::vec3(plane));
+    return frustum;
+}
+
+// Moves a model space box (center and half size) into world space. The box stays axis aligned,
+// grown to enclose the transformed box.
+inline void TransformBounds(const glm::mat4& model, const glm::vec3& center, const glm::vec3& extent, glm::vec3& worldCenter, glm::vec3& worldExtent)
+{
+    worldCenter = glm::vec3(model * glm::vec4(center, 1.0f));
+    worldExtent = glm::vec3(0.0f);
+    for (int axis = 0; axis < 3; ++axis)
+        worldExtent = worldExtent + glm::abs(glm::vec3(model[axis])) * extent[axis];
+}
+
+// World space bounding boxes and spheres of a set of objects, stored as struct of arrays so the
+// culling kernel loads one component of CULL_WIDTH objects at a time
+class CullBounds
+{
+public:
+    // Sets the number of objects, new objects start out never visible
+    void Resize(size_t newCount)
+    {
+        count = newCount;
+        const size_t padded = (count + CULL_WIDTH - 1) / CULL_WIDTH * CULL_WIDTH;
+        for (std::vector<float>* array : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ })
+            array->resize(padded, 0.0f);
+
+        // A sphere of negative radius fails every plane, so the padding is always culled. Shrinking
+        // within the same group leaves the removed objects' bounds in the padding, so it is reset
+        // every time: the kernels test whole groups.
+        radius.resize(padded);
+        std::fill(radius.begin() + count, radius.end(), -FLT_MAX);
+    }
+
+    // Sets object i from its model space bounds (center and half size) and its model matrix
+    void Set(size_t i, const glm::mat4& model, const glm::vec3& center, const glm::vec3& extent)
+    {
+        glm::vec3 worldCenter, worldExtent;
+        TransformBounds(model, center, extent, worldCenter, worldExtent);
+
+        centerX[i] = worldCenter.x;
+        centerY[i] = worldCenter.y;
+        centerZ[i] = worldCenter.z;
+        extentX[i] = worldExtent.x;
+        extentY[i] = worldExtent.y;
+        extentZ[i] = worldExtent.z;
+
+        // The sphere around the original box, tighter than the one around the grown box
+        const float scale = std::sqrt(std::max(glm::dot(glm::vec3(model[0]), glm::vec3(model[0])),
+            std::max(glm::dot(glm::vec3(model[1]), glm::vec3(model[1])), glm::dot(glm::vec3(model[2]), glm::vec3(model[2])))));
+        radius[i] = glm::length(extent) * scale;
+    }
+
+    size_t Count() const { return count; }
+
+    // Writes the index of every object intersecting the frustum to visible, in increasing order, and
+    // returns how many were written. visible must have room for Count() rounded up to CULL_WIDTH.
+    size_t Cull(const Frustum& frustum, uint32_t* visible) const
+    {
+#if defined(__AVX__)
+        return CullAvx(frustum, visible);
+#elif defined(FRUSTUM_CULL_SSE)
+        return CullSse(frustum, visible);
+#else
+        return CullScalar(frustum, visible);
+#endif
+    }
+
+    // Reference version of the kernel, one object at a time
+    size_t CullScalar(const Frustum& frustum, uint32_t* visible) const
+    {
+        size_t nVisible = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            bool inside = true;
+            for (const glm::vec4& plane : frustum.planes)
+            {
+                const float distance = plane.x * centerX[i] + plane.y * centerY[i] + plane.z * centerZ[i] + plane.w;
+                const float boxRadius = std::abs(plane.x) * extentX[i] + std::abs(plane.y) * extentY[i] + std::abs(plane.z) * extentZ[i];
+                inside = inside && distance + std::min(boxRadius, radius[i]) >= 0.0f;
+            }
+
+            visible[nVisible] = uint32_t(i);
+            nVisible += inside ? 1 : 0;
+        }
+        return nVisible;
+    }
+
+private:
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+    std::vector<float> radius;
+    size_t count = 0;
+
+    // Appends the lanes set in mask to visible without branching on them
+    static size_t Compact(unsigned mask, size_t first, size_t width, uint32_t* visible, size_t nVisible)
+    {
+        for (size_t lane = 0; lane < width; ++lane)
+        {
+            visible[nVisible] = uint32_t(first + lane);
+            nVisible += (mask >> lane) & 1;
+        }
+        return nVisible;
+    }
+
+    // An object is culled when its box or its sphere is completely outside one plane. Both bounds are
+    // conservative, so the test uses whichever reaches less far towards the plane.
+
+#if defined(__AVX__)
+    size_t CullAvx(const Frustum& frustum, uint32_t* visible) const
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        size_t nVisible = 0;
+        for (size_t i = 0; i < count; i += 8)
+        {
+            const __m256 cx = _mm256_loadu_ps(&centerX[i]), cy = _mm256_loadu_ps(&centerY[i]), cz = _mm256_loadu_ps(&centerZ[i]);
+            const __m256 ex = _mm256_loadu_ps(&extentX[i]), ey = _mm256_loadu_ps(&extentY[i]), ez = _mm256_loadu_ps(&extentZ[i]);
+            const __m256 r = _mm256_loadu_ps(&radius[i]);
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (const glm::vec4& plane : frustum.planes)
+            {
+                const __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, _mm256_set1_ps(plane.x)), _mm256_mul_ps(cy, _mm256_set1_ps(plane.y))),
+                    _mm256_add_ps(_mm256_mul_ps(cz, _mm256_set1_ps(plane.z)), _mm256_set1_ps(plane.w)));
+                const __m256 boxRadius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex, _mm256_set1_ps(std::abs(plane.x))), _mm256_mul_ps(ey, _mm256_set1_ps(std::abs(plane.y)))),
+                    _mm256_mul_ps(ez, _mm256_set1_ps(std::abs(plane.z))));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, _mm256_min_ps(boxRadius, r)), zero, _CMP_GE_OQ));
+            }
+
+            nVisible = Compact(unsigned(_mm256_movemask_ps(inside)), i, 8, visible, nVisible);
+        }
+        return nVisible;
+    }
+#elif defined(FRUSTUM_CULL_SSE)
+    size_t CullSse(const Frustum& frustum, uint32_t* visible) const
+    {
+        const __m128 zero = _mm_setzero_ps();
+        size_t nVisible = 0;
+        for (size_t i = 0; i < count; i += 4)
+        {
+            const __m128 cx = _mm_loadu_ps(&centerX[i]), cy = _mm_loadu_ps(&centerY[i]), cz = _mm_loadu_ps(&centerZ[i]);
+            const __m128 ex = _mm_loadu_ps(&extentX[i]), ey = _mm_loadu_ps(&extentY[i]), ez = _mm_loadu_ps(&extentZ[i]);
+            const __m128 r = _mm_loadu_ps(&radius[i]);
+
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (const glm::vec4& plane : frustum.planes)
+            {
+                const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_mul_ps(cy, _mm_set1_ps(plane.y))),
+                    _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+                const __m128 boxRadius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, _mm_set1_ps(std::abs(plane.x))), _mm_mul_ps(ey, _mm_set1_ps(std::abs(plane.y)))),
+                    _mm_mul_ps(ez, _mm_set1_ps(std::abs(plane.z))));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, _mm_min_ps(boxRadius, r)), zero));
+            }
+
+            nVisible = Compact(unsigned(_mm_movemask_ps(inside)), i, 4, visible, nVisible);
+        }
+        return nVisible;
+    }
+#endif
+};
+
+// Checks the kernel Cull runs against CullScalar on a grid of objects straddling the frustum, at
+// counts that are not a multiple of any group width and again after shrinking by a few objects,
+// which must never bring back indices past Count()
+inline bool CheckCullBounds()
+{
+    const glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), 1.5f, 0.1f, 50.0f);
+    const Frustum frustum = ExtractFrustum(viewProjection);
+
+    CullBounds bounds;
+    std::vector<uint32_t> simd, scalar;
+    bool passed = true;
+    for (size_t count : { size_t(61), size_t(58), size_t(57), size_t(3), size_t(0), size_t(64), size_t(63) })
+    {
+        // Once set, an object keeps its bounds: shrinking leaves them in the arrays' padding
+        bounds.Resize(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const glm::vec3 center(float(int(i % 8) - 4) * 4.0f, float(int(i / 8 % 8) - 4) * 2.0f, -float(i % 5) * 8.0f);
+            glm::mat4 model(1.0f);
+            model[3] = glm::vec4(center, 1.0f);
+            bounds.Set(i, model, glm::vec3(0.0f), glm::vec3(0.5f));
+        }
+        if (count == 58)
+            bounds.Resize(count = 57);      // Shrinks within a group, with the last object still set
+
+        simd.assign(count + CULL_WIDTH, UINT32_MAX);
+        scalar.assign(count + CULL_WIDTH, UINT32_MAX);
+        const size_t nSimd = bounds.Cull(frustum, simd.data());
+        const size_t nScalar = bounds.CullScalar(frustum, scalar.data());
+        const bool equal = nSimd == nScalar && std::equal(simd.begin(), simd.begin() + nSimd, scalar.begin());
+        const bool inRange = std::all_of(simd.begin(), simd.begin() + nSimd, [&](uint32_t index) { return index < count; });
+        if (!equal || !inRange)
+        {
+            std::cout << "ERROR::CULL::MISMATCH at " << count << " objects: " << nSimd << " visible, " << nScalar << " for the scalar kernel"
+                << (inRange ? "" : ", indices past the count") << std::endl;
+            passed = false;
+        }
+    }
+    return passed;
+}
+
+#endif
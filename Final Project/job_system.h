@@ -0,0 +1,316 @@
+#pragma once
+
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Job system: a pool of worker threads, each with its own deque of jobs. A worker runs the jobs it
+// queued itself newest first, and when it runs out steals the oldest ones of the other workers.
+// Threads outside the pool queue into a shared deque. A thread waiting for jobs to finish runs
+// queued jobs meanwhile instead of blocking, so jobs can fork more jobs and join them.
+//
+// GL calls must stay on the main thread: jobs hand that work back with RunOnMainThread, and the
+// main thread runs it from RunMainThreadJobs or while it waits.
+
+// Hardware threads, never less than one
+inline unsigned HardwareThreadCount()
+{
+    unsigned count = std::thread::hardware_concurrency();
+    return count == 0 ? 1 : count;
+}
+
+class JobCounter;
+
+struct Job
+{
+    std::function<void()> fn;
+    JobCounter* counter;            // Decremented once fn has run
+};
+
+// Jobs of a batch that have not finished yet. Jobs queued with RunAfter wait on a counter and are
+// only queued once it reaches zero. A counter must outlive the jobs it counts.
+class JobCounter
+{
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    // Once this is true the jobs are done with the counter too, and it can be destroyed
+    bool Done() const { return pending.load() == 0 && finishing.load() == 0; }
+
+private:
+    friend class JobSystem;
+
+    std::atomic<int> pending{ 0 };
+    std::atomic<int> finishing{ 0 };        // Jobs still queuing the continuations after their decrement
+    std::mutex mutex;                       // Guards continuations
+    std::vector<Job> continuations;         // Queued when pending reaches zero
+};
+
+class JobSystem
+{
+public:
+    // threadCount counts the thread waiting on the jobs, so one thread starts no workers at all
+    explicit JobSystem(unsigned threadCount = HardwareThreadCount())
+        : mainThread(std::this_thread::get_id())
+    {
+        Start(threadCount);
+    }
+
+    ~JobSystem() { Stop(); }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Replaces the workers, with no jobs in flight
+    void Restart(unsigned threadCount)
+    {
+        Stop();
+        Start(threadCount);
+    }
+
+    // Workers plus the thread waiting on the jobs
+    unsigned ThreadCount() const { return unsigned(workers.size()) + 1; }
+
+    // The thread that owns the GL context, the one creating the job system by default
+    void SetMainThread() { mainThread = std::this_thread::get_id(); }
+    bool IsMainThread() const { return std::this_thread::get_id() == mainThread; }
+
+    // Queues fn, counted by counter
+    void Run(JobCounter& counter, std::function<void()> fn)
+    {
+        counter.pending.fetch_add(1, std::memory_order_relaxed);
+        Push(Job{ std::move(fn), &counter });
+    }
+
+    // Queues fn, counted by counter, once every job counted by dependency has finished
+    void RunAfter(JobCounter& dependency, JobCounter& counter, std::function<void()> fn)
+    {
+        counter.pending.fetch_add(1, std::memory_order_relaxed);
+        Job job{ std::move(fn), &counter };
+        {
+            // Whoever finishes the last dependency takes this lock before queuing the continuations
+            std::lock_guard<std::mutex> lock(dependency.mutex);
+            if (dependency.pending.load() > 0)
+            {
+                dependency.continuations.push_back(std::move(job));
+                return;
+            }
+        }
+        Push(std::move(job));
+    }
+
+    // Queues fn, counted by counter, for the main thread only
+    void RunOnMainThread(JobCounter& counter, std::function<void()> fn)
+    {
+        counter.pending.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mainJobs.mutex);
+        mainJobs.jobs.push_back(Job{ std::move(fn), &counter });
+    }
+
+    // Main thread: runs the jobs handed to it so far
+    void RunMainThreadJobs()
+    {
+        Job job;
+        while (PopFront(mainJobs, job))
+            Execute(job);
+    }
+
+    // Runs queued jobs until every job counted by counter has finished
+    void Wait(JobCounter& counter)
+    {
+        const Slot& slot = CurrentSlot();
+        const bool worker = slot.system == this;
+        const bool main = IsMainThread();
+        while (!counter.Done())
+        {
+            Job job;
+            if ((main && PopFront(mainJobs, job)) || (worker ? TakeJob(slot.worker, job) : TakeJob(workers.size(), job)))
+                Execute(job);
+            else
+                std::this_thread::yield();
+        }
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    struct Worker
+    {
+        Queue queue;
+        std::thread thread;
+    };
+
+    // Which worker of which job system the calling thread is
+    struct Slot
+    {
+        const JobSystem* system;
+        size_t worker;
+    };
+
+    static Slot& CurrentSlot()
+    {
+        static thread_local Slot slot = { nullptr, 0 };
+        return slot;
+    }
+
+    void Start(unsigned threadCount)
+    {
+        stopping = false;
+        for (unsigned i = 1; i < std::max(threadCount, 1u); ++i)
+            workers.emplace_back(new Worker());
+        for (size_t i = 0; i < workers.size(); ++i)
+            workers[i]->thread = std::thread([this, i]() { WorkerThread(i); });
+    }
+
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::unique_ptr<Worker>& worker : workers)
+            worker->thread.join();
+        workers.clear();
+    }
+
+    void Push(Job job)
+    {
+        const Slot& slot = CurrentSlot();
+        Queue& queue = slot.system == this ? workers[slot.worker]->queue : shared;
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.jobs.push_back(std::move(job));
+        }
+
+        // Pairs with the sleeper count in WorkerThread: either the worker sees the job, or this sees
+        // the sleeper and wakes it
+        queued.fetch_add(1);
+        if (sleepers.load() > 0)
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            wake.notify_one();
+        }
+    }
+
+    bool PopFront(Queue& queue, Job& job)
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty())
+            return false;
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+        return true;
+    }
+
+    // Own jobs newest first, then the shared ones, then the oldest job of another worker. Workers
+    // past the end (index workers.size()) are threads outside the pool, with no deque of their own.
+    bool TakeJob(size_t self, Job& job)
+    {
+        if (self < workers.size())
+        {
+            Queue& own = workers[self]->queue;
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.jobs.empty())
+            {
+                job = std::move(own.jobs.back());
+                own.jobs.pop_back();
+                queued.fetch_sub(1);
+                return true;
+            }
+        }
+
+        bool found = PopFront(shared, job);
+        for (size_t i = 1; !found && i <= workers.size(); ++i)
+        {
+            const size_t victim = (self + i) % (workers.size() + 1);
+            if (victim < workers.size())
+                found = PopFront(workers[victim]->queue, job);
+        }
+        if (found)
+            queued.fetch_sub(1);
+        return found;
+    }
+
+    void Execute(Job& job)
+    {
+        job.fn();
+        Finish(*job.counter);
+    }
+
+    void Finish(JobCounter& counter)
+    {
+        // A waiter may destroy the counter as soon as it is done, so the last access to it is the
+        // decrement of finishing
+        counter.finishing.fetch_add(1);
+        if (counter.pending.fetch_sub(1) == 1)
+        {
+            std::vector<Job> ready;
+            {
+                std::lock_guard<std::mutex> lock(counter.mutex);
+                ready.swap(counter.continuations);
+            }
+            for (Job& job : ready)
+                Push(std::move(job));
+        }
+        counter.finishing.fetch_sub(1);
+    }
+
+    void WorkerThread(size_t index)
+    {
+        CurrentSlot() = { this, index };
+        for (;;)
+        {
+            Job job;
+            if (TakeJob(index, job))
+            {
+                Execute(job);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepers.fetch_add(1);
+            wake.wait(lock, [this]() { return stopping || queued.load() > 0; });
+            sleepers.fetch_sub(1);
+            if (stopping)
+                break;
+        }
+        CurrentSlot() = { nullptr, 0 };
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    Queue shared;                           // Queued by threads outside the pool
+    Queue mainJobs;                         // Only run by the main thread
+    std::thread::id mainThread;
+
+    std::atomic<int> queued{ 0 };           // Jobs in the worker and shared deques
+    std::atomic<int> sleepers{ 0 };
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping = false;                  // Guarded by sleepMutex
+};
+
+// Job system shared by the whole program, with a thread per hardware thread
+inline JobSystem& Jobs()
+{
+    static JobSystem system;
+    return system;
+}
+
+#endif
@@ -0,0 +1,355 @@
+#pragma once
+
+#ifndef LIGHTMAP_H
+#define LIGHTMAP_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "parallel_for.h"
+#include "triangle_bvh.h"
+
+// Static point light baked into the lightmaps
+struct LightmapLight
+{
+    glm::vec3 position;
+    glm::vec3 color;
+};
+
+// Controls the lightmap resolution and the shadow rays
+struct LightmapSettings
+{
+    float texelsPerUnit = 24.0f;    // Texel density requested for every chart
+    int maxSize = 1024;             // Largest lightmap edge, the density is lowered to fit
+    int padding = 2;                // Texels kept around every chart so bilinear filtering does not bleed
+    float shadowBias = 0.01f;       // Offset along the normal before shooting shadow rays
+};
+
+// One static object: world-space triangle soup in, lightmap UVs and baked texels out
+struct LightmapObject
+{
+    std::vector<glm::vec3> positions;   // Three vertices per triangle, world space
+    std::vector<glm::vec3> normals;     // One normal per vertex, world space
+
+    int size = 0;                       // Lightmap edge in texels (square)
+    std::vector<glm::vec2> uvs;         // One lightmap coordinate per vertex
+    std::vector<glm::vec3> texels;      // size * size baked diffuse values
+};
+
+
+// Unwraps every triangle into its own planar chart and shelf-packs the charts into a square atlas.
+// Returns false, with a zero size and every lightmap coordinate at the origin, when the charts do not
+// fit in settings.maxSize even at one texel each.
+inline bool UnwrapLightmap(LightmapObject& object, const LightmapSettings& settings)
+{
+    const size_t nTriangles = object.positions.size() / 3;
+
+    // Flatten each triangle onto its own plane, in world units
+    std::vector<glm::vec2> local(nTriangles * 3);
+    std::vector<glm::vec2> extent(nTriangles);
+    for (size_t t = 0; t < nTriangles; ++t)
+    {
+        const glm::vec3& p0 = object.positions[t * 3 + 0];
+        const glm::vec3 e1 = object.positions[t * 3 + 1] - p0;
+        const glm::vec3 e2 = object.positions[t * 3 + 2] - p0;
+        const glm::vec3 n = glm::cross(e1, e2);
+
+        if (glm::length(n) < 1e-8f || glm::length(e1) < 1e-8f)
+        {
+            // Degenerate triangle: give it an empty chart
+            local[t * 3 + 0] = local[t * 3 + 1] = local[t * 3 + 2] = glm::vec2(0.0f);
+            extent[t] = glm::vec2(0.0f);
+            continue;
+        }
+
+        const glm::vec3 axisX = glm::normalize(e1);
+        const glm::vec3 axisY = glm::normalize(glm::cross(glm::normalize(n), axisX));
+
+        glm::vec2 q[3] = { glm::vec2(0.0f), glm::vec2(glm::dot(e1, axisX), 0.0f), glm::vec2(glm::dot(e2, axisX), glm::dot(e2, axisY)) };
+        const glm::vec2 qMin = glm::min(q[0], glm::min(q[1], q[2]));
+        const glm::vec2 qMax = glm::max(q[0], glm::max(q[1], q[2]));
+        for (int i = 0; i < 3; ++i)
+            local[t * 3 + i] = q[i] - qMin;
+        extent[t] = qMax - qMin;
+    }
+
+    // Charts are packed tallest first
+    std::vector<size_t> order(nTriangles);
+    for (size_t t = 0; t < nTriangles; ++t)
+        order[t] = t;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return extent[a].y > extent[b].y; });
+
+    float largestExtent = 0.0f;
+    for (size_t t = 0; t < nTriangles; ++t)
+        largestExtent = std::max(largestExtent, std::max(extent[t].x, extent[t].y));
+
+    std::vector<glm::vec2> origin(nTriangles);
+    float density = settings.texelsPerUnit;
+
+    for (;;)
+    {
+        // Estimate the atlas size from the total chart area, then grow it until everything fits
+        float area = 0.0f;
+        for (size_t t = 0; t < nTriangles; ++t)
+            area += (std::ceil(extent[t].x * density) + 2 * settings.padding) * (std::ceil(extent[t].y * density) + 2 * settings.padding);
+
+        int size = 16;
+        while (size < settings.maxSize && float(size) * size < area * 1.2f)
+            size *= 2;
+
+        bool packed = false;
+        for (; size <= settings.maxSize && !packed; size *= 2)
+        {
+            int x = 0, y = 0, rowHeight = 0;
+            packed = true;
+            for (size_t t : order)
+            {
+                const int w = int(std::ceil(extent[t].x * density)) + 2 * settings.padding;
+                const int h = int(std::ceil(extent[t].y * density)) + 2 * settings.padding;
+                if (x + w > size)
+                {
+                    x = 0;
+                    y += rowHeight;
+                    rowHeight = 0;
+                }
+                if (w > size || y + h > size)
+                {
+                    packed = false;
+                    break;
+                }
+
+                origin[t] = glm::vec2(float(x + settings.padding), float(y + settings.padding));
+                x += w;
+                rowHeight = std::max(rowHeight, h);
+            }
+
+            if (packed)
+                object.size = size;
+        }
+
+        if (packed)
+            break;
+
+        // Once every chart is down to one texel plus padding, a lower density cannot shrink them
+        if (largestExtent * density <= 1.0f)
+        {
+            object.size = 0;
+            object.uvs.assign(nTriangles * 3, glm::vec2(0.0f));
+            return false;
+        }
+
+        density *= 0.75f; // Too many charts for the largest lightmap, lower the resolution
+    }
+
+    object.uvs.resize(nTriangles * 3);
+    for (size_t t = 0; t < nTriangles; ++t)
+        for (int i = 0; i < 3; ++i)
+            object.uvs[t * 3 + i] = (origin[t] + local[t * 3 + i] * density) / float(object.size);
+    return true;
+}
+
+
+// Barycentric coordinates of the point of a 2D triangle closest to p
+inline glm::vec3 ClosestBarycentric(const glm::vec2& p, const glm::vec2& a, const glm::vec2& b, const glm::vec2& c)
+{
+    const glm::vec2 v0 = b - a, v1 = c - a, v2 = p - a;
+    const float d00 = glm::dot(v0, v0), d01 = glm::dot(v0, v1), d11 = glm::dot(v1, v1);
+    const float denominator = d00 * d11 - d01 * d01;
+    if (std::abs(denominator) < 1e-12f)
+        return glm::vec3(1.0f, 0.0f, 0.0f);
+
+    const float d20 = glm::dot(v2, v0), d21 = glm::dot(v2, v1);
+    const float v = (d11 * d20 - d01 * d21) / denominator;
+    const float w = (d00 * d21 - d01 * d20) / denominator;
+    if (v >= 0.0f && w >= 0.0f && v + w <= 1.0f)
+        return glm::vec3(1.0f - v - w, v, w);
+
+    // Outside: clamp onto the nearest edge
+    glm::vec3 best(1.0f, 0.0f, 0.0f);
+    float bestDistance = glm::dot(p - a, p - a);
+    const glm::vec2 corners[3] = { a, b, c };
+    for (int i = 0; i < 3; ++i)
+    {
+        const glm::vec2& from = corners[i];
+        const glm::vec2& to = corners[(i + 1) % 3];
+        const glm::vec2 edge = to - from;
+        const float length2 = glm::dot(edge, edge);
+        const float s = length2 > 0.0f ? glm::clamp(glm::dot(p - from, edge) / length2, 0.0f, 1.0f) : 0.0f;
+        const glm::vec2 closest = from + edge * s;
+        const float distance = glm::dot(p - closest, p - closest);
+        if (distance < bestDistance)
+        {
+            bestDistance = distance;
+            best = glm::vec3(0.0f);
+            best[i] = 1.0f - s;
+            best[(i + 1) % 3] = s;
+        }
+    }
+    return best;
+}
+
+
+// Bakes diffuse lighting with shadows from the lights into every object's lightmap.
+// Charts never overlap, so triangles are baked in parallel on all cores. Returns false when an
+// object could not be unwrapped; that object is left without texels and the others are still baked.
+inline bool BakeLightmaps(std::vector<LightmapObject>& objects, const std::vector<LightmapLight>& lights, const LightmapSettings& settings)
+{
+    // Every object casts shadows on every other object
+    std::vector<glm::vec3> scene;
+    for (const LightmapObject& object : objects)
+        scene.insert(scene.end(), object.positions.begin(), object.positions.end());
+
+    TriangleBvh bvh;
+    bvh.Build(scene);
+
+    struct Task { LightmapObject* object; size_t triangle; };
+    std::vector<Task> tasks;
+    bool unwrapped = true;
+    for (LightmapObject& object : objects)
+    {
+        if (!UnwrapLightmap(object, settings))
+        {
+            unwrapped = false;
+            object.texels.clear();
+            continue;
+        }
+        object.texels.assign(size_t(object.size) * object.size, glm::vec3(0.0f));
+        for (size_t t = 0; t < object.positions.size() / 3; ++t)
+            tasks.push_back({ &object, t });
+    }
+
+    ParallelFor(tasks.size(), 16, [&](size_t begin, size_t end)
+    {
+        for (size_t taskIndex = begin; taskIndex < end; ++taskIndex)
+        {
+            LightmapObject& object = *tasks[taskIndex].object;
+            const size_t base = tasks[taskIndex].triangle * 3;
+
+            const glm::vec2 a = object.uvs[base + 0] * float(object.size);
+            const glm::vec2 b = object.uvs[base + 1] * float(object.size);
+            const glm::vec2 c = object.uvs[base + 2] * float(object.size);
+            const glm::vec2 chartMin = glm::min(a, glm::min(b, c));
+            const glm::vec2 chartMax = glm::max(a, glm::max(b, c));
+
+            // Visit the chart plus its padding ring; padding texels take the value of the closest edge point
+            const int x0 = std::max(0, int(std::floor(chartMin.x)) - settings.padding);
+            const int y0 = std::max(0, int(std::floor(chartMin.y)) - settings.padding);
+            const int x1 = std::min(object.size - 1, int(std::ceil(chartMax.x)) + settings.padding - 1);
+            const int y1 = std::min(object.size - 1, int(std::ceil(chartMax.y)) + settings.padding - 1);
+
+            for (int y = y0; y <= y1; ++y)
+            {
+                for (int x = x0; x <= x1; ++x)
+                {
+                    const glm::vec3 weights = ClosestBarycentric(glm::vec2(x + 0.5f, y + 0.5f), a, b, c);
+
+                    const glm::vec3 position = object.positions[base] * weights.x + object.positions[base + 1] * weights.y + object.positions[base + 2] * weights.z;
+                    const glm::vec3 normal = glm::normalize(object.normals[base] * weights.x + object.normals[base + 1] * weights.y + object.normals[base + 2] * weights.z);
+                    const glm::vec3 rayOrigin = position + normal * settings.shadowBias;
+
+                    glm::vec3 diffuse(0.0f);
+                    for (const LightmapLight& light : lights)
+                    {
+                        const glm::vec3 toLight = light.position - rayOrigin;
+                        const float distance = glm::length(toLight);
+                        const glm::vec3 lightDirection = toLight / distance;
+                        const float impact = std::max(glm::dot(normal, lightDirection), 0.0f);
+                        if (impact > 0.0f && !bvh.Occluded(rayOrigin, lightDirection, distance))
+                            diffuse += impact * light.color;
+                    }
+
+                    object.texels[size_t(y) * object.size + x] = diffuse;
+                }
+            }
+        }
+    });
+
+    return unwrapped;
+}
+
+
+// FNV-1a hash of everything the bake depends on, used to validate the cache file
+inline uint64_t HashLightmapInputs(const std::vector<LightmapObject>& objects, const std::vector<LightmapLight>& lights, const LightmapSettings& settings)
+{
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const void* data, size_t bytes)
+    {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < bytes; ++i)
+            hash = (hash ^ p[i]) * 1099511628211ull;
+    };
+
+    for (const LightmapObject& object : objects)
+    {
+        mix(object.positions.data(), object.positions.size() * sizeof(glm::vec3));
+        mix(object.normals.data(), object.normals.size() * sizeof(glm::vec3));
+    }
+    mix(lights.data(), lights.size() * sizeof(LightmapLight));
+    mix(&settings, sizeof(settings));
+    return hash;
+}
+
+
+const uint32_t LIGHTMAP_CACHE_MAGIC = 0x50414d4c; // "LMAP"
+const uint32_t LIGHTMAP_CACHE_VERSION = 1;
+
+// Writes the baked lightmaps so later runs can skip the bake
+inline bool SaveLightmapCache(const char* path, uint64_t key, const std::vector<LightmapObject>& objects)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    const uint32_t header[3] = { LIGHTMAP_CACHE_MAGIC, LIGHTMAP_CACHE_VERSION, uint32_t(objects.size()) };
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+
+    for (const LightmapObject& object : objects)
+    {
+        const uint32_t counts[2] = { uint32_t(object.size), uint32_t(object.uvs.size()) };
+        file.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+        file.write(reinterpret_cast<const char*>(object.uvs.data()), object.uvs.size() * sizeof(glm::vec2));
+        file.write(reinterpret_cast<const char*>(object.texels.data()), object.texels.size() * sizeof(glm::vec3));
+    }
+
+    return bool(file);
+}
+
+// Reads lightmaps written by SaveLightmapCache, fails if they were baked from different inputs
+inline bool LoadLightmapCache(const char* path, uint64_t key, std::vector<LightmapObject>& objects)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    uint32_t header[3] = {};
+    uint64_t storedKey = 0;
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    file.read(reinterpret_cast<char*>(&storedKey), sizeof(storedKey));
+    if (!file || header[0] != LIGHTMAP_CACHE_MAGIC || header[1] != LIGHTMAP_CACHE_VERSION || header[2] != objects.size() || storedKey != key)
+        return false;
+
+    for (LightmapObject& object : objects)
+    {
+        uint32_t counts[2] = {};
+        file.read(reinterpret_cast<char*>(counts), sizeof(counts));
+        if (!file || counts[1] != object.positions.size() || counts[0] > 16384)
+            return false;
+
+        object.size = int(counts[0]);
+        object.uvs.resize(counts[1]);
+        object.texels.resize(size_t(object.size) * object.size);
+        file.read(reinterpret_cast<char*>(object.uvs.data()), object.uvs.size() * sizeof(glm::vec2));
+        file.read(reinterpret_cast<char*>(object.texels.data()), object.texels.size() * sizeof(glm::vec3));
+    }
+
+    return bool(file);
+}
+
+#endif
@@ -0,0 +1,235 @@
+#pragma once
+
+#ifndef MESH_PICKING_H
+#define MESH_PICKING_H
+
+#include "benchmark_clock.h"
+#include "object_bvh.h"
+#include "primitives.h"
+#include "triangle_bvh.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Ray from the near plane through a point of the screen given in normalized device coordinates
+// ([-1, 1] on both axes, y up), by unprojecting it onto the near and far planes
+inline void ScreenRay(const glm::mat4& inverseViewProjection, float x, float y, glm::vec3& origin, glm::vec3& direction)
+{
+    const glm::vec4 nearPoint = inverseViewProjection * glm::vec4(x, y, -1.0f, 1.0f);
+    const glm::vec4 farPoint = inverseViewProjection * glm::vec4(x, y, 1.0f, 1.0f);
+    origin = glm::vec3(nearPoint) / nearPoint.w;
+    direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+}
+
+// Ray queries against the triangles of placed meshes, in two levels: an ObjectBvh over the world
+// bounds of the objects finds the candidates along the ray, and every candidate is traced in model
+// space through the TriangleBvh of its mesh. Meshes are built once and shared by all the objects
+// placing them, so moving objects only refits the object level.
+class PickScene
+{
+public:
+    struct Hit
+    {
+        uint32_t object;    // Index returned by AddObject
+        uint32_t triangle;  // Triangle of the object's mesh
+        float distance;     // Along the ray direction
+        glm::vec3 point;    // World space
+    };
+
+    // Adds a mesh from a triangle soup (three positions per triangle), returns its index
+    uint32_t AddMesh(const std::vector<glm::vec3>& positions)
+    {
+        meshes.emplace_back();
+        meshes.back().Build(positions);
+
+        ObjectBvh::Bounds bounds = { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+        for (const glm::vec3& position : positions)
+        {
+            bounds.boundsMin = glm::min(bounds.boundsMin, position);
+            bounds.boundsMax = glm::max(bounds.boundsMax, position);
+        }
+        meshBounds.push_back(bounds);
+        return uint32_t(meshes.size() - 1);
+    }
+
+    // Places a mesh, returns the index of the new object. Takes effect at the next Update.
+    uint32_t AddObject(uint32_t mesh, const glm::mat4& model)
+    {
+        objects.push_back({ mesh, model, glm::inverse(model) });
+        worldBounds.emplace_back();
+        SetTransform(uint32_t(objects.size() - 1), model);
+        return uint32_t(objects.size() - 1);
+    }
+
+    // Moves an object, takes effect at the next Update
+    void SetTransform(uint32_t object, const glm::mat4& model)
+    {
+        Object& target = objects[object];
+        target.model = model;
+        target.inverseModel = glm::inverse(model);
+
+        const ObjectBvh::Bounds& bounds = meshBounds[target.mesh];
+        glm::vec3 center, extent;
+        TransformBounds(model, (bounds.boundsMin + bounds.boundsMax) * 0.5f, (bounds.boundsMax - bounds.boundsMin) * 0.5f, center, extent);
+        worldBounds[object] = { center - extent, center + extent };
+    }
+
+    // Builds the object level, or refits it when only transforms changed
+    void Update()
+    {
+        bvh.Update(worldBounds);
+    }
+
+    // Finds the closest triangle hit by the ray, returns false when nothing is hit before maxDistance
+    bool Pick(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Hit& hit) const
+    {
+        // The ray is moved into model space without normalizing its direction, so distances along it
+        // stay the same in both spaces. Meshes only report hits nearer than the closest one so far,
+        // so every hit replaces it.
+        uint32_t triangle = 0;
+        const auto hitObject = [&](uint32_t object, float closest)
+        {
+            const Object& candidate = objects[object];
+            const glm::vec3 modelOrigin = glm::vec3(candidate.inverseModel * glm::vec4(origin, 1.0f));
+            const glm::vec3 modelDirection = glm::vec3(candidate.inverseModel * glm::vec4(direction, 0.0f));
+
+            TriangleBvh::Hit meshHit;
+            if (!meshes[candidate.mesh].Intersect(modelOrigin, modelDirection, closest, meshHit))
+                return FLT_MAX;
+            triangle = meshHit.triangle;
+            return meshHit.t;
+        };
+
+        uint32_t object;
+        float distance;
+        if (!bvh.Raycast(origin, direction, maxDistance, hitObject, object, distance))
+            return false;
+
+        hit.object = object;
+        hit.triangle = triangle;
+        hit.distance = distance;
+        hit.point = origin + direction * distance;
+        return true;
+    }
+
+    // Triangles of all the placed objects
+    size_t TriangleCount() const
+    {
+        size_t count = 0;
+        for (const Object& object : objects)
+            count += meshes[object.mesh].TriangleCount();
+        return count;
+    }
+
+    size_t ObjectCount() const { return objects.size(); }
+
+private:
+    struct Object
+    {
+        uint32_t mesh;
+        glm::mat4 model;
+        glm::mat4 inverseModel;
+    };
+
+    std::vector<TriangleBvh> meshes;
+    std::vector<ObjectBvh::Bounds> meshBounds;      // Model space
+    std::vector<Object> objects;
+    std::vector<ObjectBvh::Bounds> worldBounds;     // One per object, what the object level is built over
+    ObjectBvh bvh;
+};
+
+// Positions of a generated primitive as a triangle soup
+inline std::vector<glm::vec3> PrimitivePositions(PrimitiveType type, int segments)
+{
+    PrimitiveMesh mesh;
+    AppendPrimitive(mesh, { type, glm::vec3(0.0f), glm::vec3(1.0f) }, segments);
+    if (type == PRIMITIVE_BOX)
+    {
+        // AppendPrimitive keeps boxes flat, a finely tessellated one makes a denser benchmark mesh
+        mesh = PrimitiveMesh();
+        AppendBox(mesh, segments);
+    }
+
+    std::vector<glm::vec3> positions;
+    positions.reserve(mesh.indices.size());
+    for (uint32_t index : mesh.indices)
+        positions.push_back(glm::vec3(mesh.vertices[index * PRIMITIVE_FLOATS_PER_VERTEX], mesh.vertices[index * PRIMITIVE_FLOATS_PER_VERTEX + 1],
+            mesh.vertices[index * PRIMITIVE_FLOATS_PER_VERTEX + 2]));
+    return positions;
+}
+
+// Times picks through random screen points of a camera looking over a grid of dense meshes, at about
+// 1M, 4M and 16M triangles. Every pick has to stay under a millisecond.
+inline void RunPickBenchmark()
+{
+    const int objectCounts[] = { 16, 64, 256 };
+    const int PICKS = 10000;
+    const double BUDGET_MS = 1.0;
+
+#if defined(TRIANGLE_BVH_SSE)
+    std::cout << "Pick benchmark, SSE ray tests" << std::endl;
+#else
+    std::cout << "Pick benchmark, scalar ray tests" << std::endl;
+#endif
+
+    // A few meshes of around 65k triangles each, shared by the objects
+    PickScene scene;
+    BenchmarkClock::time_point start = BenchmarkClock::now();
+    const uint32_t meshes[] = {
+        scene.AddMesh(PrimitivePositions(PRIMITIVE_SPHERE, 256)),
+        scene.AddMesh(PrimitivePositions(PRIMITIVE_CAPSULE, 256)),
+        scene.AddMesh(PrimitivePositions(PRIMITIVE_CYLINDER, 16384)),
+        scene.AddMesh(PrimitivePositions(PRIMITIVE_BOX, 74)) };
+    std::cout << "Mesh build: " << ElapsedMs(start) << " ms" << std::endl;
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (int count : objectCounts)
+    {
+        // Square grid of objects with random sizes and rotations, two units apart
+        const int side = int(std::ceil(std::sqrt(float(count))));
+        while (int(scene.ObjectCount()) < count)
+        {
+            const int i = int(scene.ObjectCount());
+            const glm::vec3 position(float(i % side) * 2.0f - side, 0.0f, float(i / side) * 2.0f - side);
+            const glm::mat4 model = glm::scale(glm::rotate(glm::translate(glm::mat4(1.0f), position), unit(random) * 6.28f,
+                glm::normalize(glm::vec3(unit(random), 1.0f, unit(random)))), glm::vec3(0.5f + unit(random)));
+            scene.AddObject(meshes[i % 4], model);
+        }
+        start = BenchmarkClock::now();
+        scene.Update();
+        const double buildMs = ElapsedMs(start);
+
+        // Camera above one corner of the grid, looking at its center
+        const glm::mat4 view = glm::lookAt(glm::vec3(-side * 1.2f, side * 0.8f, -side * 1.2f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        const glm::mat4 inverseViewProjection = glm::inverse(glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 1000.0f) * view);
+
+        int hits = 0;
+        double totalMs = 0.0, worstMs = 0.0;
+        for (int i = 0; i < PICKS; ++i)
+        {
+            glm::vec3 origin, direction;
+            ScreenRay(inverseViewProjection, unit(random) * 2.0f - 1.0f, unit(random) * 2.0f - 1.0f, origin, direction);
+
+            PickScene::Hit hit;
+            start = BenchmarkClock::now();
+            hits += scene.Pick(origin, direction, FLT_MAX, hit) ? 1 : 0;
+            const double pickMs = ElapsedMs(start);
+            totalMs += pickMs;
+            worstMs = std::max(worstMs, pickMs);
+        }
+
+        std::cout << scene.TriangleCount() << " triangles in " << count << " objects: object level build " << buildMs << " ms"
+            << " | pick average " << totalMs / PICKS * 1000.0 << " us, worst " << worstMs * 1000.0 << " us (" << hits << " of " << PICKS << " hit)"
+            << (worstMs < BUDGET_MS ? "" : " OVER BUDGET") << std::endl;
+    }
+}
+
+#endif
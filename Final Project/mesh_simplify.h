@@ -0,0 +1,398 @@
+#pragma once
+
+#ifndef MESH_SIMPLIFY_H
+#define MESH_SIMPLIFY_H
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+// Levels of detail kept per object, the full mesh included
+const int MAX_LOD_COUNT = 4;
+
+// Range of the shared mesh drawn at one level of detail
+struct LodLevel
+{
+    uint32_t firstVertex;
+    uint32_t nVertices;
+    float error;                // Largest distance from the full mesh, in model space units
+};
+
+// Simplified triangle soup, same vertex layout as the input
+struct MeshLod
+{
+    std::vector<float> vertices;
+    float error;
+};
+
+// Sum of squared distances to a set of planes, as the symmetric matrix of the quadric form
+struct Quadric
+{
+    double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+    double planes;              // Number of planes summed
+
+    static Quadric Plane(double a, double b, double c, double d)
+    {
+        return { a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d, 1.0 };
+    }
+
+    void Add(const Quadric& q)
+    {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad; b2 += q.b2;
+        bc += q.bc; bd += q.bd; c2 += q.c2; cd += q.cd; d2 += q.d2; planes += q.planes;
+    }
+
+    double Error(const float* p) const
+    {
+        const double x = p[0], y = p[1], z = p[2];
+        return x * x * a2 + 2.0 * x * y * ab + 2.0 * x * z * ac + 2.0 * x * ad + y * y * b2
+            + 2.0 * y * z * bc + 2.0 * y * bd + z * z * c2 + 2.0 * z * cd + d2;
+    }
+};
+
+// Quadric edge collapse simplification of a triangle soup (Garland & Heckbert) down to about
+// targetTriangles triangles. The first three floats of a vertex are its position, the rest are
+// attributes (normal, texture coordinates).
+//
+// Corners with identical vertices are welded into wedges, and wedges sharing a position into
+// vertices, so the quadrics see the connected surface. Collapses move a vertex onto one of its
+// neighbours (half edge collapse), so every output vertex is an input vertex. Where a position
+// carries several wedges (a normal or UV seam), a collapse is only taken when every wedge finds
+// a partner on the other end of the edge, which keeps seams where they are. Open borders are
+// locked and collapses that fold a triangle over are rejected. error receives the largest root mean
+// square distance of a moved vertex to the planes it stood for, about how far the surface moved.
+inline std::vector<float> SimplifyMesh(const float* vertices, size_t nVertices, size_t floatsPerVertex, size_t targetTriangles, float& error)
+{
+    const size_t nTriangles = nVertices / 3;
+    error = 0.0f;
+
+    // Weld identical corners into wedges, then wedges at the same position into vertices
+    auto weld = [&](size_t nFloats, std::vector<uint32_t>& id) -> uint32_t
+    {
+        std::vector<uint32_t> order(nVertices);
+        std::iota(order.begin(), order.end(), 0u);
+        auto less = [&](uint32_t a, uint32_t b)
+        {
+            return std::lexicographical_compare(vertices + a * floatsPerVertex, vertices + a * floatsPerVertex + nFloats,
+                vertices + b * floatsPerVertex, vertices + b * floatsPerVertex + nFloats);
+        };
+        std::sort(order.begin(), order.end(), less);
+
+        id.resize(nVertices);
+        uint32_t count = 0;
+        for (size_t i = 0; i < nVertices; ++i)
+        {
+            if (i > 0 && less(order[i - 1], order[i]))
+                ++count;
+            id[order[i]] = count;
+        }
+        return nVertices > 0 ? count + 1 : 0;
+    };
+
+    std::vector<uint32_t> cornerWedge, cornerPosition;
+    const uint32_t nWedges = weld(floatsPerVertex, cornerWedge);
+    const uint32_t nPositions = weld(3, cornerPosition);
+
+    std::vector<uint32_t> wedgeCorner(nWedges), wedgePosition(nWedges);
+    for (size_t v = 0; v < nVertices; ++v)
+    {
+        wedgeCorner[cornerWedge[v]] = uint32_t(v);
+        wedgePosition[cornerWedge[v]] = cornerPosition[v];
+    }
+    auto position = [&](uint32_t wedge) { return vertices + wedgeCorner[wedge] * floatsPerVertex; };
+
+    // Triangles as wedges, degenerate ones dropped
+    std::vector<uint32_t> triangles;
+    for (size_t t = 0; t < nTriangles; ++t)
+    {
+        const uint32_t a = cornerWedge[t * 3], b = cornerWedge[t * 3 + 1], c = cornerWedge[t * 3 + 2];
+        if (wedgePosition[a] != wedgePosition[b] && wedgePosition[b] != wedgePosition[c] && wedgePosition[c] != wedgePosition[a])
+            triangles.insert(triangles.end(), { a, b, c });
+    }
+    std::vector<bool> alive(triangles.size() / 3, true);
+    size_t nAlive = alive.size();
+
+    // Plane quadric of every triangle, accumulated on its vertices, and the edges each triangle uses
+    std::vector<Quadric> quadrics(nPositions, Quadric());
+    std::vector<uint64_t> edges;
+    auto edgeKey = [](uint32_t a, uint32_t b) { return (uint64_t(std::min(a, b)) << 32) | std::max(a, b); };
+    for (size_t t = 0; t < alive.size(); ++t)
+    {
+        const float* p0 = position(triangles[t * 3]);
+        const float* p1 = position(triangles[t * 3 + 1]);
+        const float* p2 = position(triangles[t * 3 + 2]);
+        const double e1[3] = { double(p1[0]) - p0[0], double(p1[1]) - p0[1], double(p1[2]) - p0[2] };
+        const double e2[3] = { double(p2[0]) - p0[0], double(p2[1]) - p0[1], double(p2[2]) - p0[2] };
+        double n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+        const double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length > 0.0)
+        {
+            for (double& c : n)
+                c /= length;
+            const Quadric plane = Quadric::Plane(n[0], n[1], n[2], -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]));
+            for (int k = 0; k < 3; ++k)
+                quadrics[wedgePosition[triangles[t * 3 + k]]].Add(plane);
+        }
+
+        for (int k = 0; k < 3; ++k)
+            edges.push_back(edgeKey(wedgePosition[triangles[t * 3 + k]], wedgePosition[triangles[t * 3 + (k + 1) % 3]]));
+    }
+
+    // Vertices on an edge used by anything but two triangles (open border, non manifold) never move
+    std::vector<bool> locked(nPositions, false);
+    std::sort(edges.begin(), edges.end());
+    for (size_t i = 0; i < edges.size();)
+    {
+        size_t j = i;
+        while (j < edges.size() && edges[j] == edges[i])
+            ++j;
+        if (j - i != 2)
+            locked[uint32_t(edges[i] >> 32)] = locked[uint32_t(edges[i])] = true;
+        i = j;
+    }
+
+    // Whether triangle t keeps facing the same way when position from moves onto the corner toCorner
+    auto keepsFacing = [&](size_t t, uint32_t from, uint32_t toCorner) -> bool
+    {
+        float p[3][3], q[3][3];
+        for (int k = 0; k < 3; ++k)
+        {
+            const uint32_t wedge = triangles[t * 3 + k];
+            std::memcpy(p[k], position(wedge), sizeof(p[k]));
+            std::memcpy(q[k], wedgePosition[wedge] == from ? vertices + toCorner * floatsPerVertex : p[k], sizeof(q[k]));
+        }
+        auto normal = [](const float (&v)[3][3], double* n)
+        {
+            const double e1[3] = { double(v[1][0]) - v[0][0], double(v[1][1]) - v[0][1], double(v[1][2]) - v[0][2] };
+            const double e2[3] = { double(v[2][0]) - v[0][0], double(v[2][1]) - v[0][1], double(v[2][2]) - v[0][2] };
+            n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+            n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+            n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+        };
+        double before[3], after[3];
+        normal(p, before);
+        normal(q, after);
+        const double dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+        const double lengths = std::sqrt((before[0] * before[0] + before[1] * before[1] + before[2] * before[2])
+            * (after[0] * after[0] + after[1] * after[1] + after[2] * after[2]));
+        return lengths > 0.0 && dot >= 0.25 * lengths;
+    };
+
+    struct Collapse
+    {
+        uint32_t from, to;      // Positions
+        uint32_t toCorner;      // Any corner at the target position
+        double cost;
+        double distance;        // Root mean square distance to the planes of both ends
+    };
+
+    std::vector<std::vector<uint32_t>> positionTriangles(nPositions);
+    std::vector<std::pair<uint32_t, uint32_t>> wedgeMap;
+    std::vector<bool> touched(nPositions);
+    std::vector<uint32_t> neighbours;
+    while (nAlive > targetTriangles)
+    {
+        // Triangles around every vertex and the collapse candidates, both directions of every edge
+        for (std::vector<uint32_t>& list : positionTriangles)
+            list.clear();
+        std::vector<Collapse> collapses;
+        for (size_t t = 0; t < alive.size(); ++t)
+        {
+            if (!alive[t])
+                continue;
+            for (int k = 0; k < 3; ++k)
+            {
+                const uint32_t a = triangles[t * 3 + k], b = triangles[t * 3 + (k + 1) % 3];
+                positionTriangles[wedgePosition[a]].push_back(uint32_t(t));
+                for (int direction = 0; direction < 2; ++direction)
+                {
+                    const uint32_t from = wedgePosition[direction ? b : a], to = wedgePosition[direction ? a : b];
+                    if (locked[from])
+                        continue;
+                    Quadric q = quadrics[from];
+                    q.Add(quadrics[to]);
+                    const uint32_t toCorner = wedgeCorner[direction ? a : b];
+                    const double cost = std::max(0.0, q.Error(vertices + toCorner * floatsPerVertex));
+                    collapses.push_back({ from, to, toCorner, cost, q.planes > 0.0 ? std::sqrt(cost / q.planes) : 0.0 });
+                }
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        // Cheapest first. Vertices next to a collapse wait for the next pass, their costs are stale.
+        std::fill(touched.begin(), touched.end(), false);
+        size_t nCollapsed = 0;
+        for (const Collapse& collapse : collapses)
+        {
+            if (nAlive <= targetTriangles)
+                break;
+            if (touched[collapse.from] || touched[collapse.to])
+                continue;
+
+            // Every wedge of the moved vertex must pair up with a wedge of the target in a shared
+            // triangle, the triangles that survive take over the partner's attributes
+            wedgeMap.clear();
+            bool valid = true;
+            for (uint32_t t : positionTriangles[collapse.from])
+            {
+                uint32_t fromWedge = 0, toWedge = UINT32_MAX;
+                for (int k = 0; k < 3; ++k)
+                {
+                    const uint32_t wedge = triangles[t * 3 + k];
+                    if (wedgePosition[wedge] == collapse.from)
+                        fromWedge = wedge;
+                    else if (wedgePosition[wedge] == collapse.to)
+                        toWedge = wedge;
+                }
+                if (toWedge == UINT32_MAX)
+                    continue;
+
+                for (const std::pair<uint32_t, uint32_t>& pair : wedgeMap)
+                    valid = valid && (pair.first != fromWedge || pair.second == toWedge);
+                wedgeMap.push_back({ fromWedge, toWedge });
+            }
+
+            for (uint32_t t : positionTriangles[collapse.from])
+            {
+                bool shared = false, mapped = false;
+                for (int k = 0; k < 3; ++k)
+                {
+                    const uint32_t wedge = triangles[t * 3 + k];
+                    shared = shared || wedgePosition[wedge] == collapse.to;
+                    if (wedgePosition[wedge] == collapse.from)
+                        for (const std::pair<uint32_t, uint32_t>& pair : wedgeMap)
+                            mapped = mapped || pair.first == wedge;
+                }
+                valid = valid && (shared || (mapped && keepsFacing(t, collapse.from, collapse.toCorner)));
+            }
+            // The ends may only share the neighbours opposite the edge, or the surface pinches
+            neighbours.clear();
+            size_t nShared = 0;
+            for (uint32_t t : positionTriangles[collapse.from])
+            {
+                bool shared = false;
+                for (int k = 0; k < 3; ++k)
+                    shared = shared || wedgePosition[triangles[t * 3 + k]] == collapse.to;
+                nShared += shared ? 1 : 0;
+                for (int k = 0; k < 3; ++k)
+                    neighbours.push_back(wedgePosition[triangles[t * 3 + k]]);
+            }
+            std::sort(neighbours.begin(), neighbours.end());
+            neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+            size_t nCommon = 0;
+            for (uint32_t t : positionTriangles[collapse.to])
+                for (int k = 0; k < 3; ++k)
+                {
+                    const uint32_t p = wedgePosition[triangles[t * 3 + k]];
+                    std::vector<uint32_t>::iterator found = std::lower_bound(neighbours.begin(), neighbours.end(), p);
+                    if (p != collapse.from && p != collapse.to && found != neighbours.end() && *found == p)
+                    {
+                        neighbours.erase(found);
+                        ++nCommon;
+                    }
+                }
+            if (!valid || nCommon > nShared)
+                continue;
+
+            for (uint32_t t : positionTriangles[collapse.from])
+            {
+                for (int k = 0; k < 3; ++k)
+                    touched[wedgePosition[triangles[t * 3 + k]]] = true;
+
+                bool shared = false;
+                for (int k = 0; k < 3; ++k)
+                    shared = shared || wedgePosition[triangles[t * 3 + k]] == collapse.to;
+                if (shared)
+                {
+                    alive[t] = false;
+                    --nAlive;
+                    continue;
+                }
+
+                for (int k = 0; k < 3; ++k)
+                    for (const std::pair<uint32_t, uint32_t>& pair : wedgeMap)
+                        if (triangles[t * 3 + k] == pair.first)
+                        {
+                            triangles[t * 3 + k] = pair.second;
+                            break;
+                        }
+            }
+            for (uint32_t t : positionTriangles[collapse.to])
+                for (int k = 0; k < 3; ++k)
+                    touched[wedgePosition[triangles[t * 3 + k]]] = true;
+
+            quadrics[collapse.to].Add(quadrics[collapse.from]);
+            error = std::max(error, float(collapse.distance));
+            ++nCollapsed;
+        }
+
+        if (nCollapsed == 0)
+            break;
+    }
+
+    std::vector<float> result;
+    result.reserve(nAlive * 3 * floatsPerVertex);
+    for (size_t t = 0; t < alive.size(); ++t)
+        if (alive[t])
+            for (int k = 0; k < 3; ++k)
+            {
+                const float* vertex = vertices + wedgeCorner[triangles[t * 3 + k]] * floatsPerVertex;
+                result.insert(result.end(), vertex, vertex + floatsPerVertex);
+            }
+    return result;
+}
+
+// Builds up to maxLods coarser versions of a triangle soup, each aiming at half the triangles of the
+// previous one. Stops early when a level would save less than a quarter of the triangles.
+inline std::vector<MeshLod> GenerateLods(const float* vertices, size_t nVertices, size_t floatsPerVertex, int maxLods)
+{
+    std::vector<MeshLod> lods;
+    const float* source = vertices;
+    size_t nSource = nVertices;
+    float previousError = 0.0f;
+    while (int(lods.size()) < maxLods)
+    {
+        const size_t nTriangles = nSource / 3;
+        MeshLod lod;
+        lod.vertices = SimplifyMesh(source, nSource, floatsPerVertex, nTriangles / 2, lod.error);
+        if (lod.vertices.size() / floatsPerVertex / 3 * 4 > nTriangles * 3 || lod.vertices.empty())
+            break;
+
+        // Each level is simplified from the previous one, so the errors add up
+        lod.error += previousError;
+        previousError = lod.error;
+        lods.push_back(std::move(lod));
+        source = lods.back().vertices.data();
+        nSource = lods.back().vertices.size() / floatsPerVertex;
+    }
+    return lods;
+}
+
+// Chooses the level of detail to draw: the coarsest whose error covers at most maxPixels on screen.
+// pixelsPerUnit is the size on screen of one model space unit at the object's distance. A coarser level
+// is only taken once its error fits in (1 - hysteresis) of the budget, so an object sitting at the
+// switching distance does not pop back and forth every frame.
+inline int SelectLod(const LodLevel* levels, int count, int current, float pixelsPerUnit, float maxPixels, float hysteresis)
+{
+    current = std::min(std::max(current, 0), count - 1);
+    if (levels[current].error * pixelsPerUnit > maxPixels)
+    {
+        // Too coarse, refine to the coarsest level that fits the budget
+        int lod = current;
+        while (lod > 0 && levels[lod].error * pixelsPerUnit > maxPixels)
+            --lod;
+        return lod;
+    }
+
+    int lod = current;
+    while (lod + 1 < count && levels[lod + 1].error * pixelsPerUnit <= maxPixels * (1.0f - hysteresis))
+        ++lod;
+    return lod;
+}
+
+#endif
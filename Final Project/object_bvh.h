@@ -0,0 +1,621 @@
+#pragma once
+
+#ifndef OBJECT_BVH_H
+#define OBJECT_BVH_H
+
+#include "benchmark_clock.h"
+#include "frustum_cull.h"
+#include "parallel_for.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Bounding volume hierarchy over the bounds of scene objects, for logarithmic time frustum, ray and
+// sphere queries. Built top-down with binned SAH splits, the upper levels serially and the subtrees
+// below them in parallel. Moving objects are handled by refitting the existing tree, which is rebuilt
+// once refitting has made it too much more expensive to traverse than a fresh build.
+class ObjectBvh
+{
+public:
+    struct Bounds
+    {
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+    };
+
+    // Builds the tree over bounds, object i being bounds[i]
+    void Build(const std::vector<Bounds>& bounds)
+    {
+        objectBounds = bounds;
+        const uint32_t nObjects = uint32_t(bounds.size());
+
+        indices.resize(nObjects);
+        centroids.resize(nObjects);
+        ParallelFor(nObjects, 4096, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                indices[i] = uint32_t(i);
+                centroids[i] = (bounds[i].boundsMin + bounds[i].boundsMax) * 0.5f;
+            }
+        });
+
+        nodes.clear();
+        if (nObjects > 0)
+        {
+            // Serial phase: keep splitting the largest range until there are enough to keep every thread busy
+            std::vector<Subtree> subtrees;
+            subtrees.push_back({ 0, 0, nObjects, 0 });
+            nodes.push_back(Node());
+            const size_t minSubtrees = WorkerThreadCount() * 4;
+            while (!subtrees.empty() && subtrees.size() < minSubtrees)
+            {
+                auto largest = std::max_element(subtrees.begin(), subtrees.end(), [](const Subtree& a, const Subtree& b) { return a.count < b.count; });
+                if (largest->count < SERIAL_SPLIT_SIZE)
+                    break;
+
+                const Subtree range = *largest;
+                subtrees.erase(largest);
+                uint32_t leftCount;
+                if (!Split(nodes, range.node, range.first, range.count, range.depth, leftCount))
+                    continue; // Became a leaf
+
+                const uint32_t left = nodes[range.node].leftOrFirst;
+                subtrees.push_back({ left, range.first, leftCount, range.depth + 1 });
+                subtrees.push_back({ left + 1, range.first + leftCount, range.count - leftCount, range.depth + 1 });
+            }
+
+            // Parallel phase: every remaining range is built into its own node array. There is none
+            // left when the root could not be split and is a leaf already.
+            if (!subtrees.empty())
+            {
+                std::vector<std::vector<Node>> subtreeNodes(subtrees.size());
+                ParallelFor(subtrees.size(), 1, [&](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        subtreeNodes[i].push_back(Node());
+                        Subdivide(subtreeNodes[i], 0, subtrees[i].first, subtrees[i].count, subtrees[i].depth);
+                    }
+                });
+
+                // Stitch the subtrees in: their root replaces the placeholder, the rest is appended
+                for (size_t i = 0; i < subtrees.size(); ++i)
+                {
+                    const uint32_t offset = uint32_t(nodes.size()) - 1;
+                    std::vector<Node>& local = subtreeNodes[i];
+                    for (Node& node : local)
+                        if (node.count == 0)
+                            node.leftOrFirst += offset;
+
+                    nodes[subtrees[i].node] = local[0];
+                    nodes.insert(nodes.end(), local.begin() + 1, local.end());
+                }
+            }
+        }
+
+        centroids.clear();
+        centroids.shrink_to_fit();
+        builtCost = cost = ComputeCost();
+        ++rebuildCount;
+    }
+
+    // Moves the tree to new bounds for the same objects by refitting it bottom up.
+    // Rebuilds it instead once the refitted tree costs REBUILD_RATIO times more than when it was built.
+    // Returns true when it rebuilt.
+    bool Update(const std::vector<Bounds>& bounds)
+    {
+        if (bounds.size() != objectBounds.size() || nodes.empty())
+        {
+            Build(bounds);
+            return true;
+        }
+
+        objectBounds = bounds;
+
+        // Children are always stored after their parent, so a reverse pass sees them first
+        for (size_t n = nodes.size(); n-- > 0;)
+        {
+            Node& node = nodes[n];
+            glm::vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+            if (node.count > 0)
+            {
+                for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i)
+                {
+                    boundsMin = glm::min(boundsMin, objectBounds[indices[i]].boundsMin);
+                    boundsMax = glm::max(boundsMax, objectBounds[indices[i]].boundsMax);
+                }
+            }
+            else
+            {
+                const Node& left = nodes[node.leftOrFirst];
+                const Node& right = nodes[node.leftOrFirst + 1];
+                boundsMin = glm::min(left.boundsMin, right.boundsMin);
+                boundsMax = glm::max(left.boundsMax, right.boundsMax);
+            }
+            node.boundsMin = boundsMin;
+            node.boundsMax = boundsMax;
+        }
+
+        cost = ComputeCost();
+        if (cost > builtCost * REBUILD_RATIO)
+        {
+            Build(bounds);
+            return true;
+        }
+        return false;
+    }
+
+    // Shared traversal: visits the nodes for which nodeTest(boundsMin, boundsMax) is true and calls
+    // visit(object) for every object in the leaves reached. visit returns false to stop the query.
+    template <typename NodeTest, typename Visitor>
+    void Traverse(NodeTest nodeTest, Visitor visit) const
+    {
+        if (nodes.empty())
+            return;
+
+        // The tree is never deeper than MAX_DEPTH, so the stack cannot overflow
+        uint32_t stack[MAX_DEPTH + 2];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0)
+        {
+            const Node& node = nodes[stack[--stackSize]];
+            if (!nodeTest(node.boundsMin, node.boundsMax))
+                continue;
+
+            if (node.count > 0)
+            {
+                for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i)
+                    if (!visit(indices[i]))
+                        return;
+            }
+            else
+            {
+                stack[stackSize++] = node.leftOrFirst + 1;
+                stack[stackSize++] = node.leftOrFirst;
+            }
+        }
+    }
+
+    // Appends the objects whose bounds intersect the frustum
+    void QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& result) const
+    {
+        auto test = [&frustum](const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+        {
+            return IntersectsFrustum(frustum, boundsMin, boundsMax);
+        };
+        Traverse(test, [&](uint32_t object)
+        {
+            if (test(objectBounds[object].boundsMin, objectBounds[object].boundsMax))
+                result.push_back(object);
+            return true;
+        });
+    }
+
+    // Appends the objects whose bounds intersect the sphere
+    void QuerySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& result) const
+    {
+        auto test = [&center, radius](const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+        {
+            const glm::vec3 closest = glm::clamp(center, boundsMin, boundsMax);
+            return glm::dot(closest - center, closest - center) <= radius * radius;
+        };
+        Traverse(test, [&](uint32_t object)
+        {
+            if (test(objectBounds[object].boundsMin, objectBounds[object].boundsMax))
+                result.push_back(object);
+            return true;
+        });
+    }
+
+    // Finds the closest object hit by the ray. hitTest(object, maxDistance) returns the distance at which
+    // the object itself is hit, or FLT_MAX, so callers can test the actual geometry inside the bounds.
+    // Returns false when nothing is hit before maxDistance.
+    template <typename HitTest>
+    bool Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, HitTest hitTest, uint32_t& object, float& distance) const
+    {
+        const glm::vec3 inverseDirection(
+            1.0f / (direction.x != 0.0f ? direction.x : 1e-30f),
+            1.0f / (direction.y != 0.0f ? direction.y : 1e-30f),
+            1.0f / (direction.z != 0.0f ? direction.z : 1e-30f));
+
+        float closest = maxDistance;
+        bool found = false;
+        auto test = [&](const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+        {
+            return RayEntry(boundsMin, boundsMax, origin, inverseDirection, closest) != FLT_MAX;
+        };
+        Traverse(test, [&](uint32_t candidate)
+        {
+            if (test(objectBounds[candidate].boundsMin, objectBounds[candidate].boundsMax))
+            {
+                const float t = hitTest(candidate, closest);
+                if (t < closest)
+                {
+                    closest = t;
+                    object = candidate;
+                    found = true;
+                }
+            }
+            return true;
+        });
+
+        distance = closest;
+        return found;
+    }
+
+    static bool IntersectsFrustum(const Frustum& frustum, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+    {
+        const glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+        const glm::vec3 extent = (boundsMax - boundsMin) * 0.5f;
+        for (const glm::vec4& plane : frustum.planes)
+        {
+            const glm::vec3 normal(plane);
+            if (glm::dot(normal, center) + plane.w + glm::dot(glm::abs(normal), extent) < 0.0f)
+                return false;
+        }
+        return true;
+    }
+
+    // Slab test of the segment [0, maxDistance] of the ray against a box, returns the entry distance
+    // or FLT_MAX when the box is missed
+    static float RayEntry(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance)
+    {
+        const glm::vec3 t0 = (boundsMin - origin) * inverseDirection;
+        const glm::vec3 t1 = (boundsMax - origin) * inverseDirection;
+        const glm::vec3 tNear = glm::min(t0, t1);
+        const glm::vec3 tFar = glm::max(t0, t1);
+        const float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        const float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+        return entry <= exit ? entry : FLT_MAX;
+    }
+
+    size_t NodeCount() const { return nodes.size(); }
+    size_t ObjectCount() const { return objectBounds.size(); }
+    size_t RebuildCount() const { return rebuildCount; }
+
+    // SAH cost of the current tree relative to the root surface area, and of the tree when last built
+    float Cost() const { return cost; }
+    float BuiltCost() const { return builtCost; }
+
+    static constexpr float REBUILD_RATIO = 1.5f;
+
+private:
+    // 32 byte node: interior nodes store the index of their left child (the right child
+    // immediately follows it), leaves store the first index into indices and a count
+    struct Node
+    {
+        glm::vec3 boundsMin;
+        uint32_t leftOrFirst;
+        glm::vec3 boundsMax;
+        uint32_t count;
+    };
+
+    // Object range left for the parallel phase of a build, its root goes to node
+    struct Subtree
+    {
+        uint32_t node;
+        uint32_t first;
+        uint32_t count;
+        uint32_t depth;
+    };
+
+    struct Bin
+    {
+        glm::vec3 boundsMin = glm::vec3(FLT_MAX);
+        glm::vec3 boundsMax = glm::vec3(-FLT_MAX);
+        uint32_t count = 0;
+    };
+
+    static const int BIN_COUNT = 16;
+    static const uint32_t MAX_LEAF_SIZE = 4;
+    static const uint32_t MAX_DEPTH = 128;                   // Deeper nodes are left as leaves
+    static const uint32_t SERIAL_SPLIT_SIZE = 4096;          // Smaller ranges are not worth splitting before the parallel phase
+    static const uint32_t PARALLEL_BINNING_SIZE = 1 << 16;   // Ranges at least this large are binned in parallel
+    static constexpr float TRAVERSAL_COST = 1.0f;            // Cost of visiting a node relative to testing an object
+
+    std::vector<Node> nodes;
+    std::vector<Bounds> objectBounds;
+    std::vector<uint32_t> indices;
+    std::vector<glm::vec3> centroids;   // Only kept during builds
+    float cost = 0.0f;
+    float builtCost = 0.0f;
+    size_t rebuildCount = 0;
+
+    static float SurfaceArea(const glm::vec3& extent)
+    {
+        return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+    }
+
+    // Accumulates the objects in [first, first + count) into bins along all three axes
+    void FillBins(uint32_t first, uint32_t count, const glm::vec3& centroidMin, const glm::vec3& scale, Bin (&bins)[3][BIN_COUNT]) const
+    {
+        for (uint32_t i = first; i < first + count; ++i)
+        {
+            const uint32_t object = indices[i];
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const int bin = std::min(BIN_COUNT - 1, int((centroids[object][axis] - centroidMin[axis]) * scale[axis]));
+                bins[axis][bin].boundsMin = glm::min(bins[axis][bin].boundsMin, objectBounds[object].boundsMin);
+                bins[axis][bin].boundsMax = glm::max(bins[axis][bin].boundsMax, objectBounds[object].boundsMax);
+                bins[axis][bin].count++;
+            }
+        }
+    }
+
+    // Builds the subtree of [first, first + count) rooted at nodeIndex of target
+    void Subdivide(std::vector<Node>& target, uint32_t nodeIndex, uint32_t first, uint32_t count, uint32_t depth)
+    {
+        uint32_t leftCount;
+        if (!Split(target, nodeIndex, first, count, depth, leftCount))
+            return;
+
+        const uint32_t left = target[nodeIndex].leftOrFirst;
+        Subdivide(target, left, first, leftCount, depth + 1);
+        Subdivide(target, left + 1, first + leftCount, count - leftCount, depth + 1);
+    }
+
+    // Computes the bounds of node nodeIndex over [first, first + count) and splits it at the cheapest
+    // binned SAH plane, adding its two children to target. Returns false when it stays a leaf.
+    bool Split(std::vector<Node>& target, uint32_t nodeIndex, uint32_t first, uint32_t count, uint32_t depth, uint32_t& leftCount)
+    {
+        // Node bounds and centroid bounds
+        glm::vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+        glm::vec3 centroidMin(FLT_MAX), centroidMax(-FLT_MAX);
+        for (uint32_t i = first; i < first + count; ++i)
+        {
+            const uint32_t object = indices[i];
+            boundsMin = glm::min(boundsMin, objectBounds[object].boundsMin);
+            boundsMax = glm::max(boundsMax, objectBounds[object].boundsMax);
+            centroidMin = glm::min(centroidMin, centroids[object]);
+            centroidMax = glm::max(centroidMax, centroids[object]);
+        }
+
+        target[nodeIndex].boundsMin = boundsMin;
+        target[nodeIndex].boundsMax = boundsMax;
+        target[nodeIndex].leftOrFirst = first;
+        target[nodeIndex].count = count;
+
+        if (count <= MAX_LEAF_SIZE || depth >= MAX_DEPTH)
+            return false;
+
+        const glm::vec3 extent = centroidMax - centroidMin;
+        glm::vec3 scale(0.0f);
+        for (int axis = 0; axis < 3; ++axis)
+            scale[axis] = extent[axis] > 0.0f ? BIN_COUNT / extent[axis] : 0.0f;
+
+        Bin bins[3][BIN_COUNT];
+        if (count >= PARALLEL_BINNING_SIZE)
+        {
+            // Every chunk bins its own part, the partial bins are merged afterwards
+            const uint32_t grain = PARALLEL_BINNING_SIZE / 4;
+            const size_t nChunks = (count + grain - 1) / grain;
+            std::vector<Bin> partial(nChunks * 3 * BIN_COUNT);
+            ParallelFor(nChunks, 1, [&](size_t begin, size_t end)
+            {
+                for (size_t c = begin; c < end; ++c)
+                {
+                    Bin local[3][BIN_COUNT];
+                    const uint32_t chunkFirst = first + uint32_t(c) * grain;
+                    FillBins(chunkFirst, std::min(grain, first + count - chunkFirst), centroidMin, scale, local);
+                    std::copy(&local[0][0], &local[0][0] + 3 * BIN_COUNT, partial.begin() + c * 3 * BIN_COUNT);
+                }
+            });
+
+            for (size_t c = 0; c < nChunks; ++c)
+            {
+                for (int b = 0; b < 3 * BIN_COUNT; ++b)
+                {
+                    const Bin& source = partial[c * 3 * BIN_COUNT + b];
+                    Bin& bin = bins[b / BIN_COUNT][b % BIN_COUNT];
+                    bin.boundsMin = glm::min(bin.boundsMin, source.boundsMin);
+                    bin.boundsMax = glm::max(bin.boundsMax, source.boundsMax);
+                    bin.count += source.count;
+                }
+            }
+        }
+        else
+        {
+            FillBins(first, count, centroidMin, scale, bins);
+        }
+
+        // Find the cheapest split plane over all three axes
+        int bestAxis = -1;
+        int bestSplit = 0;
+        float bestCost = SurfaceArea(boundsMax - boundsMin) * count;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (extent[axis] <= 0.0f)
+                continue;
+
+            // Sweep from both sides to get the area and count on each side of every split plane
+            float leftArea[BIN_COUNT - 1], rightArea[BIN_COUNT - 1];
+            uint32_t leftCount[BIN_COUNT - 1], rightCount[BIN_COUNT - 1];
+            glm::vec3 leftMin(FLT_MAX), leftMax(-FLT_MAX), rightMin(FLT_MAX), rightMax(-FLT_MAX);
+            uint32_t leftSum = 0, rightSum = 0;
+            for (int i = 0; i < BIN_COUNT - 1; ++i)
+            {
+                const Bin& left = bins[axis][i];
+                leftSum += left.count;
+                leftCount[i] = leftSum;
+                leftMin = glm::min(leftMin, left.boundsMin);
+                leftMax = glm::max(leftMax, left.boundsMax);
+                leftArea[i] = leftSum ? SurfaceArea(leftMax - leftMin) : 0.0f;
+
+                const Bin& right = bins[axis][BIN_COUNT - 1 - i];
+                rightSum += right.count;
+                rightCount[BIN_COUNT - 2 - i] = rightSum;
+                rightMin = glm::min(rightMin, right.boundsMin);
+                rightMax = glm::max(rightMax, right.boundsMax);
+                rightArea[BIN_COUNT - 2 - i] = rightSum ? SurfaceArea(rightMax - rightMin) : 0.0f;
+            }
+
+            for (int i = 0; i < BIN_COUNT - 1; ++i)
+            {
+                const float splitCost = leftArea[i] * leftCount[i] + rightArea[i] * rightCount[i];
+                if (leftCount[i] > 0 && rightCount[i] > 0 && splitCost < bestCost)
+                {
+                    bestCost = splitCost;
+                    bestAxis = axis;
+                    bestSplit = i;
+                }
+            }
+        }
+
+        if (bestAxis < 0)
+            return false; // Splitting would not pay off, keep this node a leaf
+
+        // Partition the indices around the chosen bin boundary
+        uint32_t* begin = indices.data() + first;
+        uint32_t* middle = std::partition(begin, begin + count, [&](uint32_t object)
+        {
+            const int bin = std::min(BIN_COUNT - 1, int((centroids[object][bestAxis] - centroidMin[bestAxis]) * scale[bestAxis]));
+            return bin <= bestSplit;
+        });
+        leftCount = uint32_t(middle - begin);
+
+        const uint32_t leftIndex = uint32_t(target.size());
+        target.push_back(Node());
+        target.push_back(Node());
+        target[nodeIndex].leftOrFirst = leftIndex;
+        target[nodeIndex].count = 0;
+        return true;
+    }
+
+    float ComputeCost() const
+    {
+        if (nodes.empty())
+            return 0.0f;
+
+        float total = 0.0f;
+        for (const Node& node : nodes)
+            total += SurfaceArea(node.boundsMax - node.boundsMin) * (node.count > 0 ? float(node.count) : TRAVERSAL_COST);
+
+        const float rootArea = SurfaceArea(nodes[0].boundsMax - nodes[0].boundsMin);
+        return rootArea > 0.0f ? total / rootArea : 0.0f;
+    }
+};
+
+// Random boxes in a cube, about 1 unit in size
+inline std::vector<ObjectBvh::Bounds> RandomBenchmarkBounds(size_t count, float worldSize, std::mt19937& random)
+{
+    std::uniform_real_distribution<float> position(-worldSize, worldSize);
+    std::uniform_real_distribution<float> size(0.25f, 1.0f);
+
+    std::vector<ObjectBvh::Bounds> bounds(count);
+    for (ObjectBvh::Bounds& box : bounds)
+    {
+        const glm::vec3 center(position(random), position(random), position(random));
+        const glm::vec3 extent(size(random), size(random), size(random));
+        box = { center - extent, center + extent };
+    }
+    return bounds;
+}
+
+// Times builds, refits and queries at 10k, 100k and 1M objects, with the linear SIMD frustum culling as baseline
+inline void RunBvhBenchmark()
+{
+    const size_t counts[] = { 10000, 100000, 1000000 };
+    const int QUERIES = 1000;
+
+    std::cout << "BVH benchmark, " << WorkerThreadCount() << " threads" << std::endl;
+    for (size_t count : counts)
+    {
+        std::mt19937 random(1234);
+        const float worldSize = 2.0f * std::cbrt(float(count));     // Keeps the density constant
+        std::vector<ObjectBvh::Bounds> bounds = RandomBenchmarkBounds(count, worldSize, random);
+
+        ObjectBvh bvh;
+        BenchmarkClock::time_point start = BenchmarkClock::now();
+        bvh.Build(bounds);
+        const double buildMs = ElapsedMs(start);
+
+        // Small moves are refitted, the tree should not need a rebuild
+        std::uniform_real_distribution<float> jitter(-0.5f, 0.5f);
+        for (ObjectBvh::Bounds& box : bounds)
+        {
+            const glm::vec3 offset(jitter(random), jitter(random), jitter(random));
+            box = { box.boundsMin + offset, box.boundsMax + offset };
+        }
+        start = BenchmarkClock::now();
+        const bool rebuilt = bvh.Update(bounds);
+        const double refitMs = ElapsedMs(start);
+
+        // Queries from random points looking at random points
+        std::uniform_real_distribution<float> position(-worldSize, worldSize);
+        std::vector<Frustum> frustums(QUERIES);
+        std::vector<glm::vec3> origins(QUERIES), targets(QUERIES);
+        for (int i = 0; i < QUERIES; ++i)
+        {
+            origins[i] = glm::vec3(position(random), position(random), position(random));
+            targets[i] = glm::vec3(position(random), position(random), position(random));
+            const glm::mat4 view = glm::lookAt(origins[i], targets[i], glm::vec3(0.0f, 1.0f, 0.0f));
+            frustums[i] = ExtractFrustum(glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f) * view);
+        }
+
+        std::vector<uint32_t> result;
+        size_t frustumHits = 0, sphereHits = 0, rayHits = 0;
+        start = BenchmarkClock::now();
+        for (int i = 0; i < QUERIES; ++i)
+        {
+            result.clear();
+            bvh.QueryFrustum(frustums[i], result);
+            frustumHits += result.size();
+        }
+        const double frustumMs = ElapsedMs(start);
+
+        start = BenchmarkClock::now();
+        for (int i = 0; i < QUERIES; ++i)
+        {
+            result.clear();
+            bvh.QuerySphere(origins[i], 10.0f, result);
+            sphereHits += result.size();
+        }
+        const double sphereMs = ElapsedMs(start);
+
+        start = BenchmarkClock::now();
+        for (int i = 0; i < QUERIES; ++i)
+        {
+            uint32_t object;
+            float distance;
+            // Closest box along the segment between the two points
+            const glm::vec3 direction = targets[i] - origins[i];
+            const glm::vec3 inverseDirection = 1.0f / direction;
+            const auto hitBox = [&](uint32_t candidate, float maxDistance)
+            {
+                return ObjectBvh::RayEntry(bounds[candidate].boundsMin, bounds[candidate].boundsMax, origins[i], inverseDirection, maxDistance);
+            };
+            rayHits += bvh.Raycast(origins[i], direction, 1.0f, hitBox, object, distance) ? 1 : 0;
+        }
+        const double rayMs = ElapsedMs(start);
+
+        // Baseline: every object against the frustum with the SIMD kernel
+        CullBounds linear;
+        linear.Resize(count);
+        for (size_t i = 0; i < count; ++i)
+            linear.Set(i, glm::mat4(1.0f), (bounds[i].boundsMin + bounds[i].boundsMax) * 0.5f, (bounds[i].boundsMax - bounds[i].boundsMin) * 0.5f);
+        std::vector<uint32_t> visible(count + CULL_WIDTH);
+        size_t linearHits = 0;
+        start = BenchmarkClock::now();
+        for (int i = 0; i < QUERIES; ++i)
+            linearHits += linear.Cull(frustums[i], visible.data());
+        const double linearMs = ElapsedMs(start);
+
+        std::cout << count << " objects: build " << buildMs << " ms (" << bvh.NodeCount() << " nodes, cost " << bvh.BuiltCost() << ")"
+            << " | refit " << refitMs << " ms (cost " << bvh.Cost() << (rebuilt ? ", rebuilt" : "") << ")" << std::endl;
+        std::cout << "    queries per second: frustum " << QUERIES / frustumMs * 1000.0 << " (" << frustumHits / QUERIES << " hits, linear SIMD "
+            << QUERIES / linearMs * 1000.0 << " with " << linearHits / QUERIES << " hits)"
+            << ", sphere " << QUERIES / sphereMs * 1000.0 << " (" << sphereHits / QUERIES << " hits)"
+            << ", ray " << QUERIES / rayMs * 1000.0 << " (" << rayHits << " of " << QUERIES << " hit)" << std::endl;
+    }
+}
+
+#endif
@@ -0,0 +1,500 @@
+#pragma once
+
+#ifndef OCCLUSION_RASTER_H
+#define OCCLUSION_RASTER_H
+
+#include "benchmark_clock.h"
+#include "parallel_for.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// The AVX2 rows are compiled on every x64 build, without building the rest of the program for AVX2,
+// and only run when the CPU and the OS support them
+#if defined(_M_X64) || defined(__x86_64__)
+#define OCCLUSION_AVX2_ROWS
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define OCCLUSION_AVX2_TARGET               // MSVC takes AVX2 intrinsics at the default arch
+#else
+#define OCCLUSION_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+// Whether AVX2 instructions can run: the CPU has them and the OS saves the YMM registers
+inline bool CpuSupportsAvx2()
+{
+#if defined(OCCLUSION_AVX2_ROWS) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(OCCLUSION_AVX2_ROWS)
+    return __builtin_cpu_supports("avx2");  // Checks the OS support too
+#else
+    return false;
+#endif
+}
+
+// Software depth rasterizer for occlusion culling on the CPU, in the spirit of masked occlusion
+// culling: a few large occluder meshes are rendered into a small depth buffer, then object bounds
+// are tested against it. The buffer is split into tiles of TILE_WIDTH x TILE_HEIGHT pixels, the
+// triangles are binned into the tiles they overlap and the tiles are rasterized in parallel, one
+// row of a tile at a time. Every tile keeps its farthest depth so most tests never look at pixels.
+// Depth is window depth in [0, 1] (0 nearest) and rows go bottom to top, as in GL, but no GL is involved.
+class OcclusionRasterizer
+{
+public:
+    static const int TILE_WIDTH = 8;    // One AVX register of depths
+    static const int TILE_HEIGHT = 8;
+
+    // Sets the resolution, rounded up to whole tiles
+    void Resize(int newWidth, int newHeight)
+    {
+        tilesX = std::max(1, (newWidth + TILE_WIDTH - 1) / TILE_WIDTH);
+        tilesY = std::max(1, (newHeight + TILE_HEIGHT - 1) / TILE_HEIGHT);
+        width = tilesX * TILE_WIDTH;
+        height = tilesY * TILE_HEIGHT;
+        depth.assign(size_t(width) * height, 1.0f);
+        tileMaxDepth.assign(size_t(tilesX) * tilesY, 1.0f);
+        bins.assign(size_t(tilesX) * tilesY, std::vector<uint32_t>());
+        triangles.clear();
+    }
+
+    // Starts a new frame seen through viewProjection: drops the occluders and clears the depth
+    void BeginFrame(const glm::mat4& newViewProjection)
+    {
+        viewProjection = newViewProjection;
+        triangles.clear();
+        for (std::vector<uint32_t>& bin : bins)
+            bin.clear();
+        std::fill(depth.begin(), depth.end(), 1.0f);
+        std::fill(tileMaxDepth.begin(), tileMaxDepth.end(), 1.0f);
+    }
+
+    // Adds the triangles of an occluder: nVertices positions (three floats, stride floats apart)
+    // forming a triangle list in model space. Triangles are clipped against the near plane,
+    // projected and binned; both windings are kept.
+    void AddOccluder(const float* positions, size_t nVertices, size_t stride, const glm::mat4& model)
+    {
+        const glm::mat4 modelViewProjection = viewProjection * model;
+        for (size_t v = 0; v + 2 < nVertices; v += 3)
+        {
+            glm::vec4 clip[3];
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                const float* p = positions + (v + corner) * stride;
+                clip[corner] = modelViewProjection * glm::vec4(p[0], p[1], p[2], 1.0f);
+            }
+
+            // Near plane clipping (z >= -w) leaves a convex polygon of up to four vertices
+            glm::vec4 polygon[4];
+            int nPolygon = 0;
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                const glm::vec4& a = clip[corner];
+                const glm::vec4& b = clip[(corner + 1) % 3];
+                const float da = a.z + a.w, db = b.z + b.w;
+                if (da >= 0.0f)
+                    polygon[nPolygon++] = a;
+                if ((da >= 0.0f) != (db >= 0.0f))
+                    polygon[nPolygon++] = a + (b - a) * (da / (da - db));
+            }
+
+            for (int i = 1; i + 1 < nPolygon; ++i)
+                AddTriangle(polygon[0], polygon[i], polygon[i + 1]);
+        }
+    }
+
+    // Renders the binned occluders, the tiles spread across all threads
+    void Rasterize()
+    {
+        ParallelFor(bins.size(), 1, [this](size_t begin, size_t end)
+        {
+            for (size_t tile = begin; tile < end; ++tile)
+                RasterizeTile(int(tile % tilesX), int(tile / tilesX));
+        });
+    }
+
+    // Whether any part of the box (world space center and half size) may be visible. Boxes reaching
+    // behind the camera or outside the view are always reported visible.
+    bool TestBox(const glm::vec3& center, const glm::vec3& extent) const
+    {
+        glm::vec2 screenMin(FLT_MAX), screenMax(-FLT_MAX);
+        float nearestDepth = 1.0f;
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            const glm::vec3 offset(corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f);
+            const glm::vec4 clip = viewProjection * glm::vec4(center + extent * offset, 1.0f);
+            if (clip.z < -clip.w)
+                return true;
+
+            const glm::vec3 screen = ToScreen(clip);
+            screenMin = glm::min(screenMin, glm::vec2(screen.x, screen.y));
+            screenMax = glm::max(screenMax, glm::vec2(screen.x, screen.y));
+            nearestDepth = std::min(nearestDepth, screen.z);
+        }
+
+        if (screenMax.x < 0.0f || screenMax.y < 0.0f || screenMin.x >= float(width) || screenMin.y >= float(height))
+            return true;
+
+        // Every pixel the footprint touches, not just the pixel centers inside it
+        const int x0 = std::max(0, int(std::floor(screenMin.x))), x1 = std::min(width - 1, int(std::floor(screenMax.x)));
+        const int y0 = std::max(0, int(std::floor(screenMin.y))), y1 = std::min(height - 1, int(std::floor(screenMax.y)));
+        for (int tileY = y0 / TILE_HEIGHT; tileY <= y1 / TILE_HEIGHT; ++tileY)
+        {
+            for (int tileX = x0 / TILE_WIDTH; tileX <= x1 / TILE_WIDTH; ++tileX)
+            {
+                // The whole tile is nearer than the box
+                if (tileMaxDepth[tileY * tilesX + tileX] < nearestDepth)
+                    continue;
+
+                const int left = tileX * TILE_WIDTH;
+                const int first = std::max(x0, left) - left, last = std::min(x1, left + TILE_WIDTH - 1) - left;
+                for (int y = std::max(y0, tileY * TILE_HEIGHT); y <= std::min(y1, tileY * TILE_HEIGHT + TILE_HEIGHT - 1); ++y)
+                    if (RowReaches(&depth[size_t(y) * width + left], first, last, nearestDepth, avx2Rows))
+                        return true;
+            }
+        }
+        return false;
+    }
+
+    // Tests count boxes in parallel, visible[i] is set to 1 when box i may be visible
+    void TestBoxes(const glm::vec3* centers, const glm::vec3* extents, size_t count, uint8_t* visible) const
+    {
+        ParallelFor(count, 64, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                visible[i] = TestBox(centers[i], extents[i]) ? 1 : 0;
+        });
+    }
+
+    int Width() const { return width; }
+    int Height() const { return height; }
+    float Depth(int x, int y) const { return depth[size_t(y) * width + x]; }
+    size_t TriangleCount() const { return triangles.size(); }
+
+    // Rasterizes and tests with the scalar rows even when the AVX2 ones can run, to check one
+    // against the other
+    void SetScalarRows(bool scalar) { avx2Rows = !scalar && CpuSupportsAvx2(); }
+    bool UsesAvx2Rows() const { return avx2Rows; }
+
+private:
+    // Screen space triangle ready for rasterization: edge functions that are positive inside,
+    // the depth plane, and the pixel bounds
+    struct Triangle
+    {
+        float edgeA[3], edgeB[3], edgeC[3];     // edge(x, y) = A * x + B * y + C
+        float depthA, depthB, depthC;           // depth(x, y) = A * x + B * y + C
+        int x0, y0, x1, y1;
+    };
+
+    int width = 0, height = 0;
+    int tilesX = 0, tilesY = 0;
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    std::vector<float> depth;                   // Row major, bottom row first
+    std::vector<float> tileMaxDepth;            // Farthest depth of every tile
+    std::vector<Triangle> triangles;
+    std::vector<std::vector<uint32_t>> bins;    // Triangles overlapping every tile
+    bool avx2Rows = CpuSupportsAvx2();         // Picked once per rasterizer, not per row
+
+    // Pixel coordinates and window depth of a clip space position
+    glm::vec3 ToScreen(const glm::vec4& clip) const
+    {
+        const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        return glm::vec3((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, ndc.z * 0.5f + 0.5f);
+    }
+
+    void AddTriangle(const glm::vec4& clip0, const glm::vec4& clip1, const glm::vec4& clip2)
+    {
+        glm::vec3 v0 = ToScreen(clip0), v1 = ToScreen(clip1), v2 = ToScreen(clip2);
+        float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+        if (std::abs(area) < 1e-8f)
+            return;
+        if (area < 0.0f)
+        {
+            std::swap(v1, v2);
+            area = -area;
+        }
+
+        Triangle triangle;
+        triangle.x0 = std::max(0, int(std::floor(std::min(v0.x, std::min(v1.x, v2.x)))));
+        triangle.y0 = std::max(0, int(std::floor(std::min(v0.y, std::min(v1.y, v2.y)))));
+        triangle.x1 = std::min(width - 1, int(std::floor(std::max(v0.x, std::max(v1.x, v2.x)))));
+        triangle.y1 = std::min(height - 1, int(std::floor(std::max(v0.y, std::max(v1.y, v2.y)))));
+        if (triangle.x0 > triangle.x1 || triangle.y0 > triangle.y1)
+            return;
+
+        const glm::vec3* corners[3] = { &v0, &v1, &v2 };
+        for (int edge = 0; edge < 3; ++edge)
+        {
+            const glm::vec3& a = *corners[edge];
+            const glm::vec3& b = *corners[(edge + 1) % 3];
+            triangle.edgeA[edge] = a.y - b.y;
+            triangle.edgeB[edge] = b.x - a.x;
+            triangle.edgeC[edge] = -(triangle.edgeA[edge] * a.x + triangle.edgeB[edge] * a.y);
+        }
+
+        triangle.depthA = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+        triangle.depthB = ((v1.x - v0.x) * (v2.z - v0.z) - (v2.x - v0.x) * (v1.z - v0.z)) / area;
+        triangle.depthC = v0.z - triangle.depthA * v0.x - triangle.depthB * v0.y;
+
+        const uint32_t index = uint32_t(triangles.size());
+        triangles.push_back(triangle);
+        for (int tileY = triangle.y0 / TILE_HEIGHT; tileY <= triangle.y1 / TILE_HEIGHT; ++tileY)
+            for (int tileX = triangle.x0 / TILE_WIDTH; tileX <= triangle.x1 / TILE_WIDTH; ++tileX)
+                bins[tileY * tilesX + tileX].push_back(index);
+    }
+
+    // Rasterizes every triangle of one tile at pixel centers, keeping the nearest depth
+    void RasterizeTile(int tileX, int tileY)
+    {
+        const int left = tileX * TILE_WIDTH;
+        const int bottom = tileY * TILE_HEIGHT;
+        for (uint32_t index : bins[tileY * tilesX + tileX])
+        {
+            const Triangle& triangle = triangles[index];
+            const int rowBegin = std::max(bottom, triangle.y0), rowEnd = std::min(bottom + TILE_HEIGHT - 1, triangle.y1);
+            for (int y = rowBegin; y <= rowEnd; ++y)
+                RasterizeRow(triangle, left, y, &depth[size_t(y) * width + left], avx2Rows);
+        }
+
+        float farthest = 0.0f;
+        for (int y = bottom; y < bottom + TILE_HEIGHT; ++y)
+            for (int x = left; x < left + TILE_WIDTH; ++x)
+                farthest = std::max(farthest, depth[size_t(y) * width + x]);
+        tileMaxDepth[tileY * tilesX + tileX] = farthest;
+    }
+
+    // Whether any of pixels [first, last] of a tile row is at least as far as nearestDepth
+    static bool RowReaches(const float* row, int first, int last, float nearestDepth, bool avx2)
+    {
+#if defined(OCCLUSION_AVX2_ROWS)
+        if (avx2)
+            return RowReachesAvx2(row, first, last, nearestDepth);
+#endif
+        return RowReachesScalar(row, first, last, nearestDepth);
+    }
+
+    // Depth test and write of the pixels of a tile row inside the triangle
+    static void RasterizeRow(const Triangle& triangle, int left, int y, float* row, bool avx2)
+    {
+#if defined(OCCLUSION_AVX2_ROWS)
+        if (avx2)
+            return RasterizeRowAvx2(triangle, left, y, row);
+#endif
+        RasterizeRowScalar(triangle, left, y, row);
+    }
+
+#if defined(OCCLUSION_AVX2_ROWS)
+    OCCLUSION_AVX2_TARGET static bool RowReachesAvx2(const float* row, int first, int last, float nearestDepth)
+    {
+        const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256i inRange = _mm256_and_si256(_mm256_cmpgt_epi32(lane, _mm256_set1_epi32(first - 1)), _mm256_cmpgt_epi32(_mm256_set1_epi32(last + 1), lane));
+        const __m256 reaches = _mm256_cmp_ps(_mm256_loadu_ps(row), _mm256_set1_ps(nearestDepth), _CMP_GE_OQ);
+        return !_mm256_testz_ps(reaches, _mm256_castsi256_ps(inRange));
+    }
+
+    // The eight pixels of a tile row at once
+    OCCLUSION_AVX2_TARGET static void RasterizeRowAvx2(const Triangle& triangle, int left, int y, float* row)
+    {
+        const __m256 px = _mm256_add_ps(_mm256_set1_ps(float(left)), _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f));
+        const float py = float(y) + 0.5f;
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int edge = 0; edge < 3; ++edge)
+        {
+            const __m256 value = _mm256_add_ps(_mm256_mul_ps(px, _mm256_set1_ps(triangle.edgeA[edge])),
+                _mm256_set1_ps(triangle.edgeB[edge] * py + triangle.edgeC[edge]));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(value, _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+        if (_mm256_testz_ps(inside, inside))
+            return;
+
+        const __m256 z = _mm256_add_ps(_mm256_mul_ps(px, _mm256_set1_ps(triangle.depthA)), _mm256_set1_ps(triangle.depthB * py + triangle.depthC));
+        const __m256 old = _mm256_loadu_ps(row);
+        _mm256_storeu_ps(row, _mm256_blendv_ps(old, _mm256_min_ps(old, z), inside));
+    }
+#endif
+
+    static bool RowReachesScalar(const float* row, int first, int last, float nearestDepth)
+    {
+        for (int i = first; i <= last; ++i)
+            if (row[i] >= nearestDepth)
+                return true;
+        return false;
+    }
+
+    static void RasterizeRowScalar(const Triangle& triangle, int left, int y, float* row)
+    {
+        const float py = float(y) + 0.5f;
+        for (int i = 0; i < TILE_WIDTH; ++i)
+        {
+            const float px = float(left + i) + 0.5f;
+            bool inside = true;
+            for (int edge = 0; edge < 3; ++edge)
+                inside = inside && px * triangle.edgeA[edge] + (triangle.edgeB[edge] * py + triangle.edgeC[edge]) >= 0.0f;
+            if (inside)
+                row[i] = std::min(row[i], px * triangle.depthA + (triangle.depthB * py + triangle.depthC));
+        }
+    }
+};
+
+// Rasterizes a square occluder in front of the camera, checks the boxes it hides and the ones it
+// does not, and checks the rows this CPU runs against the scalar ones: same coverage and, up to
+// rounding, the same depth. No GL involved.
+inline bool CheckOcclusionRasterizer()
+{
+    // Camera at the origin looking down -z, the square spans [-1, 1] on x and y at z = -5
+    const glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), 4.0f / 3.0f, 0.1f, 100.0f);
+    const float square[] = { -1.0f, -1.0f, -5.0f, 1.0f, -1.0f, -5.0f, 1.0f, 1.0f, -5.0f,
+        -1.0f, -1.0f, -5.0f, 1.0f, 1.0f, -5.0f, -1.0f, 1.0f, -5.0f };
+
+    // Expected visibility of each box (center and half size)
+    struct Case
+    {
+        glm::vec3 center;
+        glm::vec3 extent;
+        uint8_t visible;
+        const char* name;
+    };
+    const Case cases[] = {
+        { glm::vec3(0.0f, 0.0f, -10.0f), glm::vec3(0.5f), 0, "behind the square" },
+        { glm::vec3(0.0f, 0.0f, -3.0f), glm::vec3(0.5f), 1, "in front of the square" },
+        { glm::vec3(3.0f, 0.0f, -10.0f), glm::vec3(0.5f), 1, "beside the square" },
+        { glm::vec3(1.6f, 0.0f, -10.0f), glm::vec3(0.5f), 1, "half behind the square" },
+        { glm::vec3(0.0f, 0.0f, -5.0f), glm::vec3(0.5f, 0.5f, 2.0f), 1, "through the square" },
+        { glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.5f), 1, "behind the camera" },
+    };
+    const size_t nCases = sizeof(cases) / sizeof(cases[0]);
+    std::vector<glm::vec3> centers, extents;
+    for (const Case& c : cases)
+    {
+        centers.push_back(c.center);
+        extents.push_back(c.extent);
+    }
+
+    OcclusionRasterizer rasterizers[2];         // Rows picked for this CPU, scalar rows
+    bool passed = true;
+    for (int r = 0; r < 2; ++r)
+    {
+        OcclusionRasterizer& rasterizer = rasterizers[r];
+        rasterizer.SetScalarRows(r == 1);
+        rasterizer.Resize(64, 48);
+        rasterizer.BeginFrame(viewProjection);
+        rasterizer.AddOccluder(square, 6, 3, glm::mat4(1.0f));
+        rasterizer.Rasterize();
+
+        uint8_t visible[nCases];
+        rasterizer.TestBoxes(centers.data(), extents.data(), nCases, visible);
+        for (size_t i = 0; i < nCases; ++i)
+            if (visible[i] != cases[i].visible)
+            {
+                std::cout << "ERROR::OCCLUSION::TEST_BOX box " << cases[i].name << " reported " << (visible[i] ? "visible" : "occluded")
+                    << (r == 1 ? " with the scalar rows" : "") << std::endl;
+                passed = false;
+            }
+
+        if (!(rasterizer.Depth(32, 24) < 1.0f) || rasterizer.Depth(0, 0) != 1.0f)
+        {
+            std::cout << "ERROR::OCCLUSION::DEPTH the square is not where it was drawn" << std::endl;
+            passed = false;
+        }
+    }
+
+    const OcclusionRasterizer& simd = rasterizers[0];
+    const OcclusionRasterizer& scalar = rasterizers[1];
+    for (int y = 0; y < simd.Height(); ++y)
+        for (int x = 0; x < simd.Width(); ++x)
+        {
+            const float a = simd.Depth(x, y), b = scalar.Depth(x, y);
+            if ((a == 1.0f) != (b == 1.0f) || std::abs(a - b) > 1e-6f)
+            {
+                std::cout << "ERROR::OCCLUSION::DEPTH_MISMATCH at " << x << ", " << y << ": " << a << " with the " << (simd.UsesAvx2Rows() ? "AVX2" : "scalar")
+                    << " rows against " << b << " with the scalar rows" << std::endl;
+                return false;
+            }
+        }
+    return passed;
+}
+
+// Times rasterization and box tests of a field of random wall occluders hiding random boxes
+inline void RunOcclusionBenchmark()
+{
+    const int ITERATIONS = 20;
+    const size_t WALL_COUNT = 200;
+    const size_t BOX_COUNTS[] = { 10000, 100000 };
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-40.0f, 40.0f);
+    std::uniform_real_distribution<float> size(1.0f, 4.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+
+    // Upright quads (two triangles each) facing random directions
+    std::vector<float> walls;
+    for (size_t i = 0; i < WALL_COUNT; ++i)
+    {
+        const glm::vec3 center(position(random), 0.0f, position(random));
+        const float halfWidth = size(random), heading = angle(random);
+        const glm::vec3 side = glm::vec3(std::cos(heading), 0.0f, std::sin(heading)) * halfWidth;
+        const glm::vec3 up(0.0f, 2.0f * halfWidth, 0.0f);
+        const glm::vec3 corners[6] = { center - side, center + side, center + side + up, center - side, center + side + up, center - side + up };
+        for (const glm::vec3& corner : corners)
+            walls.insert(walls.end(), { corner.x, corner.y, corner.z });
+    }
+
+    const glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), 4.0f / 3.0f, 0.1f, 200.0f)
+        * glm::lookAt(glm::vec3(0.0f, 2.0f, -60.0f), glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    OcclusionRasterizer rasterizer;
+    rasterizer.Resize(320, 240);
+
+    std::cout << "Occlusion benchmark, " << WorkerThreadCount() << " threads, " << rasterizer.Width() << "x" << rasterizer.Height()
+        << (rasterizer.UsesAvx2Rows() ? ", AVX2" : ", scalar") << std::endl;
+
+    double rasterMs = 0.0;
+    for (int iteration = 0; iteration < ITERATIONS; ++iteration)
+    {
+        const BenchmarkClock::time_point start = BenchmarkClock::now();
+        rasterizer.BeginFrame(viewProjection);
+        rasterizer.AddOccluder(walls.data(), walls.size() / 3, 3, glm::mat4(1.0f));
+        rasterizer.Rasterize();
+        rasterMs += ElapsedMs(start);
+    }
+    std::cout << WALL_COUNT * 2 << " occluder triangles: rasterize " << rasterMs / ITERATIONS << " ms" << std::endl;
+
+    for (size_t count : BOX_COUNTS)
+    {
+        std::vector<glm::vec3> centers(count), extents(count, glm::vec3(0.5f));
+        for (glm::vec3& center : centers)
+            center = glm::vec3(position(random), 0.5f, position(random));
+        std::vector<uint8_t> visible(count);
+
+        const BenchmarkClock::time_point start = BenchmarkClock::now();
+        for (int iteration = 0; iteration < ITERATIONS; ++iteration)
+            rasterizer.TestBoxes(centers.data(), extents.data(), count, visible.data());
+        const double testMs = ElapsedMs(start) / ITERATIONS;
+
+        size_t nVisible = 0;
+        for (uint8_t v : visible)
+            nVisible += v;
+        std::cout << count << " boxes: test " << testMs << " ms (" << count - nVisible << " occluded)" << std::endl;
+    }
+}
+
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include "job_system.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
+// Number of threads used for CPU side work (never less than one)
+inline unsigned WorkerThreadCount()
+{
+    return Jobs().ThreadCount();
+}
+
+// Runs fn(begin, end) over [0, count) split into chunks of grainSize items.
+// Chunks are handed out dynamically to the job system's threads (the calling thread included),
+// so fn must be safe to call concurrently on disjoint ranges. Calls from inside a job fork onto
+// the calling worker's deque and join by running jobs, so they nest.
+template <typename Function>
+void ParallelFor(size_t count, size_t grainSize, Function fn)
+{
+    if (count == 0)
+        return;
+
+    grainSize = std::max<size_t>(grainSize, 1);
+    const size_t nChunks = (count + grainSize - 1) / grainSize;
+    const size_t nThreads = std::min<size_t>(WorkerThreadCount(), nChunks);
+
+    std::atomic<size_t> nextChunk(0);
+    auto worker = [&]()
+    {
+        for (;;)
+        {
+            const size_t chunk = nextChunk.fetch_add(1);
+            if (chunk >= nChunks)
+                break;
+
+            const size_t begin = chunk * grainSize;
+            fn(begin, std::min(count, begin + grainSize));
+        }
+    };
+
+    // One job per other thread, each claiming chunks until there are none left
+    JobSystem& jobs = Jobs();
+    JobCounter counter;
+    for (size_t i = 1; i < nThreads; ++i)
+        jobs.Run(counter, worker);
+
+    worker();
+    jobs.Wait(counter);
+}
+
+#endif
@@ -0,0 +1,286 @@
+#pragma once
+
+#ifndef PRIMITIVES_H
+#define PRIMITIVES_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Vertices are laid out like the scene mesh: position, normal, texture coordinates
+const int PRIMITIVE_FLOATS_PER_VERTEX = 8;
+
+enum PrimitiveType
+{
+    PRIMITIVE_NONE,
+    PRIMITIVE_PLANE,        // Unit square in XZ facing +Y
+    PRIMITIVE_DISK,         // Disk of diameter one in XZ facing +Y
+    PRIMITIVE_CYLINDER,     // Diameter and height one along Y, capped
+    PRIMITIVE_CAPSULE,      // Diameter one, a unit long cylinder between two half spheres along Y
+    PRIMITIVE_SPHERE,       // Diameter one
+    PRIMITIVE_BOX           // Unit cube
+};
+
+// Primitive scaled to size and moved to center, all in model space
+struct PrimitiveShape
+{
+    PrimitiveType type;
+    glm::vec3 center;
+    glm::vec3 size;
+};
+
+// Indexed triangle mesh. Vertices are only repeated where a normal or texture coordinate changes
+// (box edges, cap rims, the texture seam of round shapes), never with identical data.
+struct PrimitiveMesh
+{
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+
+    uint32_t VertexCount() const { return uint32_t(vertices.size() / PRIMITIVE_FLOATS_PER_VERTEX); }
+
+    uint32_t AddVertex(const glm::vec3& position, const glm::vec3& normal, const glm::vec2& uv)
+    {
+        const float vertex[] = { position.x, position.y, position.z, normal.x, normal.y, normal.z, uv.x, uv.y };
+        vertices.insert(vertices.end(), vertex, vertex + PRIMITIVE_FLOATS_PER_VERTEX);
+        return VertexCount() - 1;
+    }
+
+    void AddTriangle(uint32_t a, uint32_t b, uint32_t c)
+    {
+        indices.insert(indices.end(), { a, b, c });
+    }
+};
+
+// Grid of segments x segments quads on the unit square facing normal, with up along the second texture
+// axis, pushed offset along the normal from the origin. Counter-clockwise seen from the front.
+inline void AppendGrid(PrimitiveMesh& mesh, int segments, const glm::vec3& normal, const glm::vec3& up, float offset)
+{
+    segments = std::max(segments, 1);
+    const glm::vec3 right = glm::cross(normal, up);
+    const glm::vec3 origin = normal * offset - right * 0.5f - up * 0.5f;
+
+    const uint32_t first = mesh.VertexCount();
+    for (int j = 0; j <= segments; ++j)
+        for (int i = 0; i <= segments; ++i)
+        {
+            const glm::vec2 uv(float(i) / segments, float(j) / segments);
+            mesh.AddVertex(origin + right * uv.x + up * uv.y, normal, uv);
+        }
+
+    const uint32_t row = uint32_t(segments + 1);
+    for (int j = 0; j < segments; ++j)
+        for (int i = 0; i < segments; ++i)
+        {
+            const uint32_t a = first + j * row + i;
+            mesh.AddTriangle(a, a + row, a + 1);
+            mesh.AddTriangle(a + 1, a + row, a + row + 1);
+        }
+}
+
+// Disk of diameter one at height y, facing up (+Y) or down, with planar texture coordinates
+inline void AppendDiskAt(PrimitiveMesh& mesh, int segments, float y, bool up)
+{
+    segments = std::max(segments, 3);
+    const glm::vec3 normal(0.0f, up ? 1.0f : -1.0f, 0.0f);
+    const uint32_t center = mesh.AddVertex(glm::vec3(0.0f, y, 0.0f), normal, glm::vec2(0.5f));
+    for (int i = 0; i < segments; ++i)
+    {
+        const float angle = 6.28318531f * i / segments;
+        const glm::vec2 direction(std::cos(angle), std::sin(angle));
+        mesh.AddVertex(glm::vec3(direction.x * 0.5f, y, direction.y * 0.5f), normal, glm::vec2(0.5f) + direction * 0.5f);
+    }
+
+    for (int i = 0; i < segments; ++i)
+    {
+        const uint32_t a = center + 1 + i, b = center + 1 + (i + 1) % segments;
+        if (up)
+            mesh.AddTriangle(center, b, a);
+        else
+            mesh.AddTriangle(center, a, b);
+    }
+}
+
+// One ring of a surface of revolution around Y: radius and height of the profile point, its normal in
+// the (radius, y) plane, and the second texture coordinate
+struct ProfilePoint
+{
+    float radius;
+    float y;
+    glm::vec2 normal;
+    float v;
+};
+
+// Sweeps the profile (top to bottom) around Y. Rings of zero radius at the ends become poles with one
+// vertex per segment, so every triangle touching them gets its own texture coordinate. The other rings
+// repeat their first vertex at u = 1 for the texture seam.
+inline void AppendRevolution(PrimitiveMesh& mesh, int segments, const std::vector<ProfilePoint>& profile)
+{
+    segments = std::max(segments, 3);
+    std::vector<uint32_t> rings;
+    for (size_t r = 0; r < profile.size(); ++r)
+    {
+        const ProfilePoint& point = profile[r];
+        const bool pole = point.radius == 0.0f && (r == 0 || r + 1 == profile.size());
+        rings.push_back(mesh.VertexCount());
+        for (int i = 0; i <= segments - (pole ? 1 : 0); ++i)
+        {
+            const float u = (i + (pole ? 0.5f : 0.0f)) / segments;
+            const float angle = 6.28318531f * u;
+            const glm::vec2 direction(std::cos(angle), std::sin(angle));
+            mesh.AddVertex(glm::vec3(direction.x * point.radius, point.y, direction.y * point.radius),
+                glm::vec3(direction.x * point.normal.x, point.normal.y, direction.y * point.normal.x), glm::vec2(u, point.v));
+        }
+    }
+
+    for (size_t r = 0; r + 1 < profile.size(); ++r)
+    {
+        const bool topPole = r == 0 && profile[r].radius == 0.0f;
+        const bool bottomPole = r + 2 == profile.size() && profile[r + 1].radius == 0.0f;
+        const uint32_t high = rings[r], low = rings[r + 1];
+        for (int i = 0; i < segments; ++i)
+        {
+            if (topPole)
+                mesh.AddTriangle(low + i, high + i, low + i + 1);
+            else if (bottomPole)
+                mesh.AddTriangle(low + i, high + i, high + i + 1);
+            else
+            {
+                mesh.AddTriangle(low + i, high + i, low + i + 1);
+                mesh.AddTriangle(low + i + 1, high + i, high + i + 1);
+            }
+        }
+    }
+}
+
+inline void AppendPlane(PrimitiveMesh& mesh, int segments)
+{
+    AppendGrid(mesh, segments, glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), 0.0f);
+}
+
+inline void AppendDisk(PrimitiveMesh& mesh, int segments)
+{
+    AppendDiskAt(mesh, segments, 0.0f, true);
+}
+
+inline void AppendCylinder(PrimitiveMesh& mesh, int segments)
+{
+    AppendRevolution(mesh, segments, {
+        { 0.5f, 0.5f, glm::vec2(1.0f, 0.0f), 1.0f },
+        { 0.5f, -0.5f, glm::vec2(1.0f, 0.0f), 0.0f } });
+    AppendDiskAt(mesh, segments, 0.5f, true);
+    AppendDiskAt(mesh, segments, -0.5f, false);
+}
+
+// length is the length of the straight part, the half spheres have a quarter of the segments as rings
+inline void AppendCapsule(PrimitiveMesh& mesh, int segments, float length)
+{
+    const int rings = std::max(segments / 4, 1);
+    const float total = 3.14159265f * 0.5f + length;    // Profile length, spread over v
+    std::vector<ProfilePoint> profile;
+    for (int half = 0; half < 2; ++half)
+        for (int r = 0; r <= rings; ++r)
+        {
+            // Top half from the pole down to the equator, bottom half from the equator to the pole
+            const float angle = 1.57079633f * (half == 0 ? r : rings + r) / rings;
+            const float y = std::cos(angle) * 0.5f + (half == 0 ? length : -length) * 0.5f;
+            const float arc = angle * 0.5f + (half == 0 ? 0.0f : length);
+            const float radius = r == (half == 0 ? 0 : rings) ? 0.0f : std::sin(angle) * 0.5f;
+            profile.push_back({ radius, y, glm::vec2(std::sin(angle), std::cos(angle)), 1.0f - arc / total });
+        }
+    AppendRevolution(mesh, segments, profile);
+}
+
+// Latitude-longitude sphere with half as many rings as segments
+inline void AppendSphere(PrimitiveMesh& mesh, int segments)
+{
+    const int rings = std::max(segments / 2, 2);
+    std::vector<ProfilePoint> profile;
+    for (int r = 0; r <= rings; ++r)
+    {
+        const float angle = 3.14159265f * r / rings;
+        const float radius = r == 0 || r == rings ? 0.0f : std::sin(angle) * 0.5f;
+        profile.push_back({ radius, std::cos(angle) * 0.5f, glm::vec2(std::sin(angle), std::cos(angle)), 1.0f - float(r) / rings });
+    }
+    AppendRevolution(mesh, segments, profile);
+}
+
+// Each face is a segments x segments grid with its own texture coordinates
+inline void AppendBox(PrimitiveMesh& mesh, int segments)
+{
+    const glm::vec3 x(1.0f, 0.0f, 0.0f), y(0.0f, 1.0f, 0.0f), z(0.0f, 0.0f, 1.0f);
+    AppendGrid(mesh, segments, x, y, 0.5f);
+    AppendGrid(mesh, segments, -x, y, 0.5f);
+    AppendGrid(mesh, segments, z, y, 0.5f);
+    AppendGrid(mesh, segments, -z, y, 0.5f);
+    AppendGrid(mesh, segments, y, z, 0.5f);
+    AppendGrid(mesh, segments, -y, z, 0.5f);
+}
+
+// Scales and moves the vertices from first on, generated for a unit primitive, to the shape's bounds
+inline void PlacePrimitive(PrimitiveMesh& mesh, uint32_t first, const PrimitiveShape& shape)
+{
+    // Normals take the inverse scale, so they stay perpendicular on stretched shapes
+    const glm::vec3 inverseSize = glm::vec3(1.0f) / shape.size;
+    for (uint32_t v = first; v < mesh.VertexCount(); ++v)
+    {
+        float* vertex = &mesh.vertices[v * PRIMITIVE_FLOATS_PER_VERTEX];
+        const glm::vec3 position = shape.center + glm::vec3(vertex[0], vertex[1], vertex[2]) * shape.size;
+        const glm::vec3 normal = glm::normalize(glm::vec3(vertex[3], vertex[4], vertex[5]) * inverseSize);
+        for (int k = 0; k < 3; ++k)
+        {
+            vertex[k] = position[k];
+            vertex[3 + k] = normal[k];
+        }
+    }
+}
+
+// Appends a primitive of the given resolution, scaled and moved to its shape's bounds. Planes and
+// boxes are flat, they gain nothing from more segments and always get one.
+inline void AppendPrimitive(PrimitiveMesh& mesh, const PrimitiveShape& shape, int segments)
+{
+    const uint32_t first = mesh.VertexCount();
+    switch (shape.type)
+    {
+    case PRIMITIVE_PLANE: AppendPlane(mesh, 1); break;
+    case PRIMITIVE_DISK: AppendDisk(mesh, segments); break;
+    case PRIMITIVE_CYLINDER: AppendCylinder(mesh, segments); break;
+    case PRIMITIVE_CAPSULE: AppendCapsule(mesh, segments, 1.0f); break;
+    case PRIMITIVE_SPHERE: AppendSphere(mesh, segments); break;
+    case PRIMITIVE_BOX: AppendBox(mesh, 1); break;
+    default: break;
+    }
+    PlacePrimitive(mesh, first, shape);
+}
+
+// Largest distance between a round shape drawn with the given segments and the true surface, for
+// primitives of the given shape. Boxes and planes are exact at any resolution.
+inline float PrimitiveError(const PrimitiveShape& shape, int segments)
+{
+    if (shape.type == PRIMITIVE_NONE || shape.type == PRIMITIVE_BOX || shape.type == PRIMITIVE_PLANE)
+        return 0.0f;
+
+    const float radius = std::max(shape.size.x, shape.size.z) * 0.5f;
+    return radius * (1.0f - std::cos(3.14159265f / std::max(segments, 3)));
+}
+
+// Whether a coarser resolution changes the shape at all
+inline bool PrimitiveHasLevels(const PrimitiveShape& shape)
+{
+    return PrimitiveError(shape, 3) > 0.0f;
+}
+
+// Expands an indexed mesh into a triangle soup, three vertices per triangle
+inline std::vector<float> PrimitiveTriangles(const PrimitiveMesh& mesh)
+{
+    std::vector<float> triangles;
+    triangles.reserve(mesh.indices.size() * PRIMITIVE_FLOATS_PER_VERTEX);
+    for (uint32_t index : mesh.indices)
+        triangles.insert(triangles.end(), mesh.vertices.begin() + index * PRIMITIVE_FLOATS_PER_VERTEX,
+            mesh.vertices.begin() + (index + 1) * PRIMITIVE_FLOATS_PER_VERTEX);
+    return triangles;
+}
+
+#endif
@@ -0,0 +1,222 @@
+#pragma once
+
+#ifndef SCENE_ENTITIES_H
+#define SCENE_ENTITIES_H
+
+#include "benchmark_clock.h"
+#include "entity_store.h"
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Position, rotation (Euler angles in radians, applied X then Y then Z) and scale relative to the world
+struct LocalTransform
+{
+    glm::vec3 position;
+    glm::vec3 rotation;
+    glm::vec3 scale;
+};
+
+// Model matrix computed from LocalTransform by the transform system
+struct WorldTransform
+{
+    glm::mat4 matrix;
+};
+
+// Optional constant motion applied by the transform system
+struct Motion
+{
+    glm::vec3 velocity;         // Units per second
+    glm::vec3 angularVelocity;  // Radians per second around each axis
+};
+
+struct PointLight
+{
+    glm::vec3 color;
+    float intensity;
+};
+
+// Range of the shared mesh drawn for the entity
+struct Renderable
+{
+    uint32_t firstVertex;
+    uint32_t nVertices;
+    uint32_t material;          // Index into the material (texture) table
+    glm::vec3 center;           // Model space bounds of the range (center and half size), for culling
+    glm::vec3 extent;
+};
+
+// Light as consumed by the renderer, extracted every frame
+struct LightPacket
+{
+    glm::vec3 position;
+    glm::vec3 color;            // Color scaled by intensity
+};
+
+// Draw as consumed by the renderer, extracted every frame
+struct DrawPacket
+{
+    glm::mat4 model;
+    uint32_t firstVertex;
+    uint32_t nVertices;
+    uint32_t material;
+    float distance;             // Distance to the camera, for sorting
+    glm::vec3 center;           // Model space bounds
+    glm::vec3 extent;
+};
+
+// Model matrix of position * rotationZ * rotationY * rotationX * scale, without the matrix products
+inline glm::mat4 ComposeTransform(const LocalTransform& transform)
+{
+    const float cx = std::cos(transform.rotation.x), sx = std::sin(transform.rotation.x);
+    const float cy = std::cos(transform.rotation.y), sy = std::sin(transform.rotation.y);
+    const float cz = std::cos(transform.rotation.z), sz = std::sin(transform.rotation.z);
+
+    glm::mat4 m(1.0f);
+    m[0] = glm::vec4(cy * cz, cy * sz, -sy, 0.0f) * transform.scale.x;
+    m[1] = glm::vec4(sx * sy * cz - cx * sz, sx * sy * sz + cx * cz, sx * cy, 0.0f) * transform.scale.y;
+    m[2] = glm::vec4(cx * sy * cz + sx * sz, cx * sy * sz - sx * cz, cx * cy, 0.0f) * transform.scale.z;
+    m[3] = glm::vec4(transform.position, 1.0f);
+    return m;
+}
+
+// Transform system: advances moving entities and recomputes every world matrix
+inline void UpdateTransforms(EntityStore& store, float deltaTime)
+{
+    store.ParallelForEachChunk<LocalTransform, WorldTransform>([deltaTime](const EntityChunk& chunk)
+    {
+        LocalTransform* locals = chunk.Get<LocalTransform>();
+        WorldTransform* worlds = chunk.Get<WorldTransform>();
+        const Motion* motions = chunk.Get<Motion>();
+
+        if (motions)
+        {
+            for (uint32_t i = 0; i < chunk.Count(); ++i)
+            {
+                locals[i].position += motions[i].velocity * deltaTime;
+                locals[i].rotation += motions[i].angularVelocity * deltaTime;
+            }
+        }
+
+        for (uint32_t i = 0; i < chunk.Count(); ++i)
+            worlds[i].matrix = ComposeTransform(locals[i]);
+    });
+}
+
+// Gives every chunk its first output slot, so chunks can be written out in parallel in a stable order
+inline size_t ChunkOutputOffsets(const std::vector<EntityChunk>& chunks, std::vector<size_t>& offsets)
+{
+    offsets.resize(chunks.size());
+    size_t total = 0;
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        offsets[i] = total;
+        total += chunks[i].Count();
+    }
+    return total;
+}
+
+// Light system: gathers the world position and color of every light
+inline void ExtractLights(EntityStore& store, std::vector<LightPacket>& lights)
+{
+    const std::vector<EntityChunk> chunks = store.Chunks<WorldTransform, PointLight>();
+    std::vector<size_t> offsets;
+    lights.resize(ChunkOutputOffsets(chunks, offsets));
+
+    ParallelFor(chunks.size(), 1, [&](size_t begin, size_t end)
+    {
+        for (size_t c = begin; c < end; ++c)
+        {
+            const WorldTransform* worlds = chunks[c].Get<WorldTransform>();
+            const PointLight* pointLights = chunks[c].Get<PointLight>();
+            LightPacket* out = lights.data() + offsets[c];
+            for (uint32_t i = 0; i < chunks[c].Count(); ++i)
+                out[i] = { glm::vec3(worlds[i].matrix[3]), pointLights[i].color * pointLights[i].intensity };
+        }
+    });
+}
+
+// Draw extraction system: one packet per renderable entity, with its distance to the camera
+inline void ExtractDraws(EntityStore& store, const glm::vec3& cameraPosition, std::vector<DrawPacket>& draws)
+{
+    const std::vector<EntityChunk> chunks = store.Chunks<WorldTransform, Renderable>();
+    std::vector<size_t> offsets;
+    draws.resize(ChunkOutputOffsets(chunks, offsets));
+
+    ParallelFor(chunks.size(), 1, [&](size_t begin, size_t end)
+    {
+        for (size_t c = begin; c < end; ++c)
+        {
+            const WorldTransform* worlds = chunks[c].Get<WorldTransform>();
+            const Renderable* renderables = chunks[c].Get<Renderable>();
+            DrawPacket* out = draws.data() + offsets[c];
+            for (uint32_t i = 0; i < chunks[c].Count(); ++i)
+            {
+                out[i].model = worlds[i].matrix;
+                out[i].firstVertex = renderables[i].firstVertex;
+                out[i].nVertices = renderables[i].nVertices;
+                out[i].material = renderables[i].material;
+                out[i].distance = glm::length(glm::vec3(worlds[i].matrix[3]) - cameraPosition);
+                out[i].center = renderables[i].center;
+                out[i].extent = renderables[i].extent;
+            }
+        }
+    });
+}
+
+// Times the three systems at 10k, 100k and 1M entities: 90% moving renderables, 10% lights
+inline void RunEntityBenchmark()
+{
+    const int ITERATIONS = 10;
+    const size_t counts[] = { 10000, 100000, 1000000 };
+
+    std::cout << "Entity benchmark, " << WorkerThreadCount() << " threads, " << ITERATIONS << " iterations" << std::endl;
+    for (size_t count : counts)
+    {
+        EntityStore store;
+        std::mt19937 random(1234);
+        std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+        std::uniform_real_distribution<float> speed(-1.0f, 1.0f);
+
+        const BenchmarkClock::time_point createStart = BenchmarkClock::now();
+        for (size_t i = 0; i < count; ++i)
+        {
+            const LocalTransform local = { glm::vec3(position(random), position(random), position(random)), glm::vec3(0.0f), glm::vec3(1.0f) };
+            const WorldTransform world = { glm::mat4(1.0f) };
+            if (i % 10 == 0)
+                store.Create(local, world, PointLight{ glm::vec3(1.0f), 1.0f });
+            else
+                store.Create(local, world, Motion{ glm::vec3(speed(random), 0.0f, speed(random)), glm::vec3(0.0f, speed(random), 0.0f) },
+                    Renderable{ 0, 36, uint32_t(i % 4) });
+        }
+        const double createMs = ElapsedMs(createStart);
+
+        std::vector<LightPacket> lights;
+        std::vector<DrawPacket> draws;
+        double transformMs = 0.0, lightMs = 0.0, drawMs = 0.0;
+        for (int iteration = 0; iteration < ITERATIONS; ++iteration)
+        {
+            const BenchmarkClock::time_point start = BenchmarkClock::now();
+            UpdateTransforms(store, 1.0f / 60.0f);
+            const BenchmarkClock::time_point transformsDone = BenchmarkClock::now();
+            ExtractLights(store, lights);
+            const BenchmarkClock::time_point lightsDone = BenchmarkClock::now();
+            ExtractDraws(store, glm::vec3(0.0f), draws);
+            const BenchmarkClock::time_point drawsDone = BenchmarkClock::now();
+
+            transformMs += ElapsedMs(start, transformsDone);
+            lightMs += ElapsedMs(transformsDone, lightsDone);
+            drawMs += ElapsedMs(lightsDone, drawsDone);
+        }
+
+        std::cout << count << " entities (" << lights.size() << " lights, " << draws.size() << " draws): create "
+            << createMs << " ms | per update: transforms " << transformMs / ITERATIONS << " ms, lights "
+            << lightMs / ITERATIONS << " ms, draws " << drawMs / ITERATIONS << " ms" << std::endl;
+    }
+}
+
+#endif
@@ -0,0 +1,90 @@
+#pragma once
+
+#ifndef SCENE_GRAPH_H
+#define SCENE_GRAPH_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Node of the scene hierarchy. Transforms live in the SceneGraph arrays, indexed like the nodes.
+struct SceneNode
+{
+    const char* name;   // Node name, used in log output
+    uint32_t parent;    // Index of the parent node, SceneGraph::NO_PARENT for roots
+    int object;         // Object drawn with this node's world matrix, -1 for transform-only nodes
+};
+
+// Transform hierarchy stored as flat arrays where every parent comes before its children, so a
+// single front to back pass updates the whole tree. World matrices are cached and recomputed only
+// for nodes whose local transform, or the local transform of an ancestor, changed.
+class SceneGraph
+{
+public:
+    static const uint32_t NO_PARENT = UINT32_MAX;
+
+    // Adds a node under parent (which must already exist) and returns its index
+    uint32_t AddNode(const char* name, uint32_t parent, const glm::mat4& local, int object = -1)
+    {
+        const uint32_t index = uint32_t(nodes.size());
+        nodes.push_back({ name, parent < index ? parent : NO_PARENT, object });
+        locals.push_back(local);
+        worlds.push_back(local);
+        dirty.push_back(1);
+        anyDirty = true;
+        return index;
+    }
+
+    void SetLocal(uint32_t node, const glm::mat4& local)
+    {
+        locals[node] = local;
+        dirty[node] = 1;
+        anyDirty = true;
+    }
+
+    const glm::mat4& Local(uint32_t node) const { return locals[node]; }
+
+    // World matrix as of the last Update
+    const glm::mat4& World(uint32_t node) const { return worlds[node]; }
+
+    const SceneNode& Node(uint32_t node) const { return nodes[node]; }
+    size_t NodeCount() const { return nodes.size(); }
+
+    // Recomputes the world matrices of the changed nodes and their descendants.
+    // Returns the number of matrices recomputed.
+    size_t Update()
+    {
+        if (!anyDirty)
+            return 0;
+
+        size_t updated = 0;
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            // The parent was visited first, a change above this node has already been flagged there
+            const uint32_t parent = nodes[i].parent;
+            if (parent != NO_PARENT)
+                dirty[i] |= dirty[parent];
+
+            if (!dirty[i])
+                continue;
+
+            worlds[i] = parent != NO_PARENT ? worlds[parent] * locals[i] : locals[i];
+            ++updated;
+        }
+
+        std::memset(dirty.data(), 0, dirty.size());
+        anyDirty = false;
+        return updated;
+    }
+
+private:
+    std::vector<SceneNode> nodes;
+    std::vector<glm::mat4> locals;
+    std::vector<glm::mat4> worlds;
+    std::vector<uint8_t> dirty;
+    bool anyDirty = false;
+};
+
+#endif
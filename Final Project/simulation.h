@@ -0,0 +1,199 @@
+#pragma once
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+// Fixed timestep simulation on its own thread. The window thread hands it input through a lock-free
+// queue, and the simulation hands back the state to draw through a lock-free triple buffer, so
+// neither ever waits on the other.
+
+// Input as received by the window callbacks
+enum InputEventType
+{
+    INPUT_KEY,              // key and action (press or release)
+    INPUT_MOUSE_MOVE,       // Offset since the last move in x and y, y up
+    INPUT_SCROLL            // Wheel offset in y
+};
+
+struct InputEvent
+{
+    InputEventType type;
+    int key;
+    int action;
+    float x;
+    float y;
+    double time;            // When the callback received it, in seconds on the window thread's clock
+};
+
+// Bounded queue for exactly one producer thread and one consumer thread. Push fails when the queue is
+// full, so a stalled consumer drops input instead of blocking the producer.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Producer side
+    bool Push(const T& item)
+    {
+        const size_t tail = this->tail.load(std::memory_order_relaxed);
+        if (tail - head.load(std::memory_order_acquire) == Capacity)
+            return false;
+        items[tail & (Capacity - 1)] = item;
+        this->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool Pop(T& item)
+    {
+        const size_t head = this->head.load(std::memory_order_relaxed);
+        if (head == tail.load(std::memory_order_acquire))
+            return false;
+        item = items[head & (Capacity - 1)];
+        this->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: items ready to pop, more may be pushed meanwhile
+    size_t Size() const
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_relaxed);
+    }
+
+private:
+    T items[Capacity];
+    alignas(64) std::atomic<size_t> head{ 0 };     // Next item to pop, written by the consumer
+    alignas(64) std::atomic<size_t> tail{ 0 };     // Next slot to push, written by the producer
+};
+
+// Three copies of a value passed from one writer thread to one reader thread. The writer fills its
+// copy and swaps it with the middle one, the reader swaps the middle one with its own when a newer
+// value was published, so each side always owns a whole copy and the reader only ever sees complete
+// values. Values the reader never picked up are overwritten.
+template <typename T>
+class TripleBuffer
+{
+public:
+    // Writer side: the copy to fill, then publish it
+    T& WriteBuffer() { return buffers[writeIndex]; }
+
+    void Publish()
+    {
+        writeIndex = middle.exchange(writeIndex | FRESH) & INDEX_MASK;
+    }
+
+    // Reader side: whether a value newer than the one read was published
+    bool Fresh() const { return (middle.load() & FRESH) != 0; }
+
+    // Reader side: takes the latest published value, returns false when there is nothing newer than
+    // the one already read
+    bool Acquire()
+    {
+        if (!Fresh())
+            return false;
+        readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    const T& ReadBuffer() const { return buffers[readIndex]; }
+
+private:
+    static const uint32_t INDEX_MASK = 3;
+    static const uint32_t FRESH = 4;        // Set on the middle index when it holds an unread value
+
+    T buffers[3];
+    std::atomic<uint32_t> middle{ 1 };
+    uint32_t writeIndex = 0;                // Only touched by the writer
+    uint32_t readIndex = 2;                 // Only touched by the reader
+};
+
+// Thread calling step every stepSeconds of real time, then publish once it has caught up. The time
+// passed to publish is how far the simulation has advanced, which stays behind Now() by less than a
+// step; the reader interpolates over that remainder. A thread that falls more than MAX_CATCH_UP steps
+// behind skips the missing time rather than spiraling.
+class FixedStepThread
+{
+public:
+    static const int MAX_CATCH_UP = 5;
+
+    ~FixedStepThread() { Stop(); }
+
+    void Start(double stepSeconds, std::function<void()> step, std::function<void(double)> publish)
+    {
+        Stop();
+        this->stepSeconds = stepSeconds;
+        this->step = step;
+        this->publish = publish;
+        ticks = 0;
+        skippedSteps = 0;
+        start = Clock::now();
+        running = true;
+        thread = std::thread([this]() { Run(); });
+    }
+
+    void Stop()
+    {
+        running = false;
+        if (thread.joinable())
+            thread.join();
+    }
+
+    bool IsRunning() const { return running; }
+
+    // Seconds since Start, on the clock the simulation runs on
+    double Now() const { return std::chrono::duration<double>(Clock::now() - start).count(); }
+
+    double StepSeconds() const { return stepSeconds; }
+    uint64_t Ticks() const { return ticks; }
+    uint64_t SkippedSteps() const { return skippedSteps; }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    void Run()
+    {
+        double simulated = 0.0;
+        while (running)
+        {
+            const double now = Now();
+            int steps = 0;
+            while (simulated + stepSeconds <= now && steps < MAX_CATCH_UP)
+            {
+                step();
+                simulated += stepSeconds;
+                ++ticks;
+                ++steps;
+            }
+            if (simulated + stepSeconds <= now)
+            {
+                const uint64_t behind = uint64_t((now - simulated) / stepSeconds);
+                simulated += double(behind) * stepSeconds;
+                skippedSteps += behind;
+            }
+            if (steps > 0)
+                publish(simulated);
+
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(simulated + stepSeconds)));
+        }
+    }
+
+    double stepSeconds = 1.0 / 60.0;
+    std::function<void()> step;
+    std::function<void(double)> publish;
+    Clock::time_point start;
+    std::atomic<bool> running{ false };
+    std::atomic<uint64_t> ticks{ 0 };
+    std::atomic<uint64_t> skippedSteps{ 0 };
+    std::thread thread;
+};
+
+#endif
@@ -0,0 +1,258 @@
+#pragma once
+
+#ifndef STATIC_PRIMITIVES_H
+#define STATIC_PRIMITIVES_H
+
+#include "primitives.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Compile time versions of the primitives the scene is built from. The constexpr generators below
+// follow the runtime ones in primitives.h vertex for vertex, so the meshes are computed by the
+// compiler, stored as constants in read-only data and checked with static_assert.
+
+// Unit primitive computed at compile time, indexed like PrimitiveMesh
+template <size_t V, size_t I>
+struct StaticMesh
+{
+    std::array<float, V * PRIMITIVE_FLOATS_PER_VERTEX> vertices;
+    std::array<uint32_t, I> indices;
+    size_t nVertices;           // Written by the generator, must end up at V
+    size_t nIndices;            // Must end up at I
+
+    static constexpr size_t VERTEX_COUNT = V;
+    static constexpr size_t INDEX_COUNT = I;
+
+    constexpr uint32_t AddVertex(float x, float y, float z, float nx, float ny, float nz, float u, float v)
+    {
+        const float vertex[] = { x, y, z, nx, ny, nz, u, v };
+        for (int k = 0; k < PRIMITIVE_FLOATS_PER_VERTEX; ++k)
+            vertices[nVertices * PRIMITIVE_FLOATS_PER_VERTEX + k] = vertex[k];
+        return uint32_t(nVertices++);
+    }
+
+    constexpr void AddTriangle(uint32_t a, uint32_t b, uint32_t c)
+    {
+        indices[nIndices++] = a;
+        indices[nIndices++] = b;
+        indices[nIndices++] = c;
+    }
+};
+
+// std::sin and std::cos are not constexpr: Taylor series after reducing the angle to [-pi, pi]
+constexpr double StaticSin(double x)
+{
+    const double pi = 3.14159265358979323846;
+    while (x > pi)
+        x -= 2.0 * pi;
+    while (x < -pi)
+        x += 2.0 * pi;
+
+    double term = x, sum = x;
+    for (int n = 1; n < 12; ++n)
+    {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double StaticCos(double x)
+{
+    return StaticSin(x + 3.14159265358979323846 * 0.5);
+}
+
+constexpr size_t StaticCylinderVertexCount(int segments) { return size_t(4 * segments + 4); }
+constexpr size_t StaticCylinderIndexCount(int segments) { return size_t(12 * segments); }
+
+// Same as AppendCylinder: the side with a texture seam, then the top and bottom caps
+template <int Segments>
+constexpr StaticMesh<StaticCylinderVertexCount(Segments), StaticCylinderIndexCount(Segments)> MakeStaticCylinder()
+{
+    static_assert(Segments >= 3, "A cylinder needs at least three segments");
+    StaticMesh<StaticCylinderVertexCount(Segments), StaticCylinderIndexCount(Segments)> mesh = {};
+
+    const double step = 2.0 * 3.14159265358979323846 / Segments;
+    for (int ring = 0; ring < 2; ++ring)
+        for (int i = 0; i <= Segments; ++i)
+        {
+            const float x = float(StaticCos(step * i)), z = float(StaticSin(step * i));
+            mesh.AddVertex(x * 0.5f, ring == 0 ? 0.5f : -0.5f, z * 0.5f, x, 0.0f, z, float(i) / Segments, ring == 0 ? 1.0f : 0.0f);
+        }
+    const uint32_t high = 0, low = Segments + 1;
+    for (uint32_t i = 0; i < uint32_t(Segments); ++i)
+    {
+        mesh.AddTriangle(low + i, high + i, low + i + 1);
+        mesh.AddTriangle(low + i + 1, high + i, high + i + 1);
+    }
+
+    for (int cap = 0; cap < 2; ++cap)
+    {
+        const float y = cap == 0 ? 0.5f : -0.5f;
+        const float normal = cap == 0 ? 1.0f : -1.0f;
+        const uint32_t center = mesh.AddVertex(0.0f, y, 0.0f, 0.0f, normal, 0.0f, 0.5f, 0.5f);
+        for (int i = 0; i < Segments; ++i)
+        {
+            const float x = float(StaticCos(step * i)), z = float(StaticSin(step * i));
+            mesh.AddVertex(x * 0.5f, y, z * 0.5f, 0.0f, normal, 0.0f, 0.5f + x * 0.5f, 0.5f + z * 0.5f);
+        }
+        for (uint32_t i = 0; i < uint32_t(Segments); ++i)
+        {
+            const uint32_t a = center + 1 + i, b = center + 1 + (i + 1) % Segments;
+            if (cap == 0)
+                mesh.AddTriangle(center, b, a);
+            else
+                mesh.AddTriangle(center, a, b);
+        }
+    }
+    return mesh;
+}
+
+// Same as AppendBox with one segment: four vertices per face, each face with its own normal and UVs
+constexpr StaticMesh<24, 36> MakeStaticBox()
+{
+    StaticMesh<24, 36> mesh = {};
+
+    // Normal and up of every face, right is normal x up
+    const float faces[6][6] = {
+        { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f }, { -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f },
+        { 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f },
+        { 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f }, { 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f } };
+    for (const auto& face : faces)
+    {
+        const float n[3] = { face[0], face[1], face[2] };
+        const float up[3] = { face[3], face[4], face[5] };
+        const float right[3] = { n[1] * up[2] - n[2] * up[1], n[2] * up[0] - n[0] * up[2], n[0] * up[1] - n[1] * up[0] };
+
+        const uint32_t first = uint32_t(mesh.nVertices);
+        for (int j = 0; j <= 1; ++j)
+            for (int i = 0; i <= 1; ++i)
+            {
+                float p[3] = {};
+                for (int k = 0; k < 3; ++k)
+                    p[k] = n[k] * 0.5f + right[k] * (i - 0.5f) + up[k] * (j - 0.5f);
+                mesh.AddVertex(p[0], p[1], p[2], n[0], n[1], n[2], float(i), float(j));
+            }
+        mesh.AddTriangle(first, first + 2, first + 1);
+        mesh.AddTriangle(first + 1, first + 2, first + 3);
+    }
+    return mesh;
+}
+
+// Compile time checks of a generated mesh
+
+// Every slot of the arrays was written
+template <typename Mesh>
+constexpr bool StaticMeshComplete(const Mesh& mesh)
+{
+    return mesh.nVertices == Mesh::VERTEX_COUNT && mesh.nIndices == Mesh::INDEX_COUNT && Mesh::INDEX_COUNT % 3 == 0;
+}
+
+template <typename Mesh>
+constexpr bool StaticIndicesInRange(const Mesh& mesh)
+{
+    for (uint32_t index : mesh.indices)
+        if (index >= Mesh::VERTEX_COUNT)
+            return false;
+    return true;
+}
+
+template <typename Mesh>
+constexpr bool StaticNormalsUnitLength(const Mesh& mesh)
+{
+    for (size_t v = 0; v < Mesh::VERTEX_COUNT; ++v)
+    {
+        const float* n = &mesh.vertices[v * PRIMITIVE_FLOATS_PER_VERTEX + 3];
+        const float length2 = n[0] * n[0] + n[1] * n[1] + n[2] * n[2];
+        if (length2 < 0.999f || length2 > 1.001f)
+            return false;
+    }
+    return true;
+}
+
+// Every triangle has an area and is wound counter-clockwise around the normal of its first vertex
+template <typename Mesh>
+constexpr bool StaticTrianglesFaceNormals(const Mesh& mesh)
+{
+    for (size_t t = 0; t < Mesh::INDEX_COUNT; t += 3)
+    {
+        const float* a = &mesh.vertices[mesh.indices[t] * PRIMITIVE_FLOATS_PER_VERTEX];
+        const float* b = &mesh.vertices[mesh.indices[t + 1] * PRIMITIVE_FLOATS_PER_VERTEX];
+        const float* c = &mesh.vertices[mesh.indices[t + 2] * PRIMITIVE_FLOATS_PER_VERTEX];
+        const float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        const float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+        const float cross[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+        if (cross[0] * a[3] + cross[1] * a[4] + cross[2] * a[5] <= 0.0f)
+            return false;
+    }
+    return true;
+}
+
+// Every position lies within the unit primitive's bounds, [-0.5, 0.5] on each axis
+template <typename Mesh>
+constexpr bool StaticPositionsInUnitBounds(const Mesh& mesh)
+{
+    for (size_t v = 0; v < Mesh::VERTEX_COUNT; ++v)
+        for (int k = 0; k < 3; ++k)
+        {
+            const float p = mesh.vertices[v * PRIMITIVE_FLOATS_PER_VERTEX + k];
+            if (p < -0.5001f || p > 0.5001f)
+                return false;
+        }
+    return true;
+}
+
+template <typename Mesh>
+constexpr bool StaticMeshValid(const Mesh& mesh)
+{
+    return StaticMeshComplete(mesh) && StaticIndicesInRange(mesh) && StaticNormalsUnitLength(mesh)
+        && StaticTrianglesFaceNormals(mesh) && StaticPositionsInUnitBounds(mesh);
+}
+
+// The shapes of the scene: the box and the cylinder at every level of detail (32 segments halved three times)
+constexpr auto STATIC_BOX = MakeStaticBox();
+constexpr auto STATIC_CYLINDER_32 = MakeStaticCylinder<32>();
+constexpr auto STATIC_CYLINDER_16 = MakeStaticCylinder<16>();
+constexpr auto STATIC_CYLINDER_8 = MakeStaticCylinder<8>();
+constexpr auto STATIC_CYLINDER_4 = MakeStaticCylinder<4>();
+
+static_assert(StaticMeshValid(STATIC_BOX), "Bad box geometry");
+static_assert(StaticMeshValid(STATIC_CYLINDER_32), "Bad cylinder geometry");
+static_assert(StaticMeshValid(STATIC_CYLINDER_16), "Bad cylinder geometry");
+static_assert(StaticMeshValid(STATIC_CYLINDER_8), "Bad cylinder geometry");
+static_assert(StaticMeshValid(STATIC_CYLINDER_4), "Bad cylinder geometry");
+
+template <typename Mesh>
+void AppendStaticMesh(PrimitiveMesh& mesh, const Mesh& source)
+{
+    const uint32_t first = mesh.VertexCount();
+    mesh.vertices.insert(mesh.vertices.end(), source.vertices.begin(), source.vertices.end());
+    for (uint32_t index : source.indices)
+        mesh.indices.push_back(first + index);
+}
+
+// Appends the compiled version of a primitive, scaled and moved to its shape's bounds. Returns false,
+// leaving the mesh untouched, when that shape and resolution were not compiled in.
+inline bool AppendStaticPrimitive(PrimitiveMesh& mesh, const PrimitiveShape& shape, int segments)
+{
+    const uint32_t first = mesh.VertexCount();
+    if (shape.type == PRIMITIVE_BOX)
+        AppendStaticMesh(mesh, STATIC_BOX);
+    else if (shape.type == PRIMITIVE_CYLINDER && segments == 32)
+        AppendStaticMesh(mesh, STATIC_CYLINDER_32);
+    else if (shape.type == PRIMITIVE_CYLINDER && segments == 16)
+        AppendStaticMesh(mesh, STATIC_CYLINDER_16);
+    else if (shape.type == PRIMITIVE_CYLINDER && segments == 8)
+        AppendStaticMesh(mesh, STATIC_CYLINDER_8);
+    else if (shape.type == PRIMITIVE_CYLINDER && segments == 4)
+        AppendStaticMesh(mesh, STATIC_CYLINDER_4);
+    else
+        return false;
+
+    PlacePrimitive(mesh, first, shape);
+    return true;
+}
+
+#endif
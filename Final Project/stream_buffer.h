@@ -0,0 +1,77 @@
+#pragma once
+
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// Bookkeeping of a streaming buffer: one buffer split into equal regions, one per frame in flight,
+// which the frames take turns to write. A frame only ever allocates from its own region, so the only
+// synchronization needed is waiting, before a region comes round again, for the GPU to be done with
+// the frame that last used it. The buffer itself (and its fences) is the GL side's business.
+
+const size_t STREAM_REGION_COUNT = 3;           // Frames the GPU may still be reading while the CPU writes the next
+const size_t STREAM_ALLOCATION_FAILED = SIZE_MAX;
+
+class StreamAllocator
+{
+public:
+    struct Stats
+    {
+        size_t peakBytes;               // Most bytes one frame allocated, since the last ResetStats
+        size_t failedAllocations;       // Allocations that did not fit in their frame's region
+    };
+
+    // Forgets every allocation; regionBytes is the most a single frame can allocate
+    void Reset(size_t regionBytes)
+    {
+        this->regionBytes = regionBytes;
+        region = STREAM_REGION_COUNT - 1;
+        used = 0;
+        ResetStats();
+    }
+
+    // Moves on to the next region and returns it. The caller must make sure the GPU is done reading
+    // it before writing anything allocated from it.
+    size_t BeginFrame()
+    {
+        region = (region + 1) % STREAM_REGION_COUNT;
+        used = 0;
+        return region;
+    }
+
+    // Offset from the start of the buffer of bytes in this frame's region, a multiple of alignment
+    // (any size, so a vertex stride works and the offset divides into a first vertex), or
+    // STREAM_ALLOCATION_FAILED when the region is full
+    size_t Allocate(size_t bytes, size_t alignment = 4)
+    {
+        const size_t base = region * regionBytes;
+        const size_t offset = (base + used + alignment - 1) / alignment * alignment;
+        if (offset + bytes > base + regionBytes)
+        {
+            ++stats.failedAllocations;
+            return STREAM_ALLOCATION_FAILED;
+        }
+        used = offset + bytes - base;
+        stats.peakBytes = std::max(stats.peakBytes, used);
+        return offset;
+    }
+
+    size_t Region() const { return region; }
+    size_t RegionBytes() const { return regionBytes; }
+    size_t TotalBytes() const { return regionBytes * STREAM_REGION_COUNT; }
+    size_t UsedBytes() const { return used; }       // By the current frame
+
+    Stats GetStats() const { return stats; }
+    void ResetStats() { stats = Stats(); }
+
+private:
+    size_t regionBytes = 0;
+    size_t region = STREAM_REGION_COUNT - 1;
+    size_t used = 0;
+    Stats stats = Stats();
+};
+
+#endif
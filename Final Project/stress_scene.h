@@ -0,0 +1,271 @@
+#pragma once
+
+#ifndef STRESS_SCENE_H
+#define STRESS_SCENE_H
+
+#include "benchmark_clock.h"
+#include "draw_commands.h"
+#include "frustum_cull.h"
+#include "scene_entities.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Generated stress scene: instances of the scene's objects scattered over a square around the origin,
+// with random transforms, materials and lights drawn from a seeded generator, so the same count and
+// seed always give the same scene. The density stays constant, the square grows with the count.
+
+const float STRESS_SPACING = 3.0f;                  // Average distance between neighboring instances
+const size_t STRESS_INSTANCES_PER_LIGHT = 100;
+const uint32_t STRESS_DEFAULT_SEED = 1234;
+
+// Mesh range an instance can draw, with its model space bounds
+struct StressPrototype
+{
+    uint32_t firstVertex;
+    uint32_t nVertices;
+    glm::vec3 center;
+    glm::vec3 extent;
+};
+
+// Instance of a prototype, as scattered before it becomes an entity
+struct StressInstance
+{
+    LocalTransform transform;
+    uint32_t prototype;
+    uint32_t material;
+};
+
+struct StressLight
+{
+    LocalTransform transform;
+    PointLight light;
+};
+
+// What the generator scattered
+struct StressSceneInfo
+{
+    size_t instances;
+    size_t lights;
+    size_t triangles;           // Of all the instances together
+    float halfSize;             // The instances lie within [-halfSize, halfSize] on x and z
+};
+
+// Scatters count instances and one light per STRESS_INSTANCES_PER_LIGHT of them. Each instance picks
+// a prototype and one of materialCount materials, a position on the ground, a rotation mostly around
+// the vertical axis and a uniform scale.
+inline StressSceneInfo ScatterStressScene(const std::vector<StressPrototype>& prototypes, uint32_t materialCount, size_t count, uint32_t seed,
+    std::vector<StressInstance>& instances, std::vector<StressLight>& lights)
+{
+    StressSceneInfo info = {};
+    if (prototypes.empty() || materialCount == 0)
+        return info;
+    instances.reserve(instances.size() + count);
+
+    info.halfSize = 0.5f * STRESS_SPACING * std::sqrt(float(count));
+
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> position(-info.halfSize, info.halfSize);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    std::uniform_real_distribution<float> tilt(-0.2f, 0.2f);
+    std::uniform_real_distribution<float> scale(0.5f, 1.5f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_int_distribution<uint32_t> prototype(0, uint32_t(prototypes.size() - 1));
+    std::uniform_int_distribution<uint32_t> material(0, materialCount - 1);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint32_t source = prototype(random);
+        const LocalTransform local = { glm::vec3(position(random), 0.0f, position(random)), glm::vec3(tilt(random), angle(random), tilt(random)), glm::vec3(scale(random)) };
+        instances.push_back({ local, source, material(random) });
+        info.triangles += prototypes[source].nVertices / 3;
+        ++info.instances;
+
+        // Lights hover over the instances in random colors
+        if (i % STRESS_INSTANCES_PER_LIGHT == 0)
+        {
+            const LocalTransform lightLocal = { glm::vec3(position(random), 2.0f + 3.0f * unit(random), position(random)), glm::vec3(0.0f), glm::vec3(1.0f) };
+            lights.push_back({ lightLocal, PointLight{ glm::vec3(unit(random), unit(random), unit(random)), 0.5f + unit(random) } });
+            ++info.lights;
+        }
+    }
+    return info;
+}
+
+// Creates an entity for every instance and light, appending their handles to entities when given
+inline void SpawnStressScene(EntityStore& store, const std::vector<StressPrototype>& prototypes, const StressInstance* instances, size_t nInstances,
+    const StressLight* lights, size_t nLights, std::vector<Entity>* entities = nullptr)
+{
+    const WorldTransform world = { glm::mat4(1.0f) };
+    for (size_t i = 0; i < nInstances; ++i)
+    {
+        const StressPrototype& source = prototypes[instances[i].prototype];
+        const Entity entity = store.Create(instances[i].transform, world, Renderable{ source.firstVertex, source.nVertices, instances[i].material, source.center, source.extent });
+        if (entities)
+            entities->push_back(entity);
+    }
+    for (size_t i = 0; i < nLights; ++i)
+    {
+        const Entity entity = store.Create(lights[i].transform, world, lights[i].light);
+        if (entities)
+            entities->push_back(entity);
+    }
+}
+
+// Scatters the stress scene and creates its entities in store
+inline StressSceneInfo GenerateStressScene(EntityStore& store, const std::vector<StressPrototype>& prototypes, uint32_t materialCount, size_t count, uint32_t seed)
+{
+    std::vector<StressInstance> instances;
+    std::vector<StressLight> lights;
+    const StressSceneInfo info = ScatterStressScene(prototypes, materialCount, count, seed, instances, lights);
+    SpawnStressScene(store, prototypes, instances.data(), instances.size(), lights.data(), lights.size());
+    return info;
+}
+
+// Moves the model space bounds of every draw into the culling arrays, in parallel
+inline void StressCullBounds(const std::vector<DrawPacket>& draws, CullBounds& bounds)
+{
+    bounds.Resize(draws.size());
+    ParallelFor(draws.size(), 4096, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            bounds.Set(i, draws[i].model, draws[i].center, draws[i].extent);
+    });
+}
+
+// Ranges and bounds of about the size of the scene's objects, for benchmarks that run without a mesh
+inline std::vector<StressPrototype> StressBenchmarkPrototypes()
+{
+    return {
+        { 0, 36, glm::vec3(0.0f), glm::vec3(0.5f) },
+        { 36, 132, glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(0.25f, 1.0f, 0.25f) },
+        { 168, 384, glm::vec3(0.0f), glm::vec3(1.0f, 0.1f, 0.7f) } };
+}
+
+// Times the CPU side of a frame of the stress scene at each count with the given seed: generating it,
+// then the transform and draw extraction systems and frustum culling from a camera at the center
+inline void RunStressBenchmark(const std::vector<size_t>& counts, uint32_t seed)
+{
+    const int ITERATIONS = 10;
+
+    const std::vector<StressPrototype> prototypes = StressBenchmarkPrototypes();
+    const Frustum frustum = ExtractFrustum(glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f)
+        * glm::lookAt(glm::vec3(0.0f, 3.0f, 0.0f), glm::vec3(10.0f, 0.0f, 10.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+
+    std::cout << "Stress scene benchmark, seed " << seed << ", " << WorkerThreadCount() << " threads, " << ITERATIONS << " iterations" << std::endl;
+    for (size_t count : counts)
+    {
+        EntityStore store;
+        BenchmarkClock::time_point start = BenchmarkClock::now();
+        const StressSceneInfo info = GenerateStressScene(store, prototypes, 4, count, seed);
+        const double generateMs = ElapsedMs(start);
+
+        std::vector<LightPacket> lights;
+        std::vector<DrawPacket> draws;
+        CullBounds bounds;
+        std::vector<uint32_t> visible;
+        std::vector<CommandBuffer> buffers;
+        CommandBuffer commands;
+        size_t nVisible = 0;
+        double transformMs = 0.0, extractMs = 0.0, cullMs = 0.0, recordMs = 0.0;
+        for (int iteration = 0; iteration < ITERATIONS; ++iteration)
+        {
+            start = BenchmarkClock::now();
+            UpdateTransforms(store, 1.0f / 60.0f);
+            transformMs += ElapsedMs(start);
+
+            start = BenchmarkClock::now();
+            ExtractLights(store, lights);
+            ExtractDraws(store, glm::vec3(0.0f, 3.0f, 0.0f), draws);
+            extractMs += ElapsedMs(start);
+
+            start = BenchmarkClock::now();
+            StressCullBounds(draws, bounds);
+            visible.resize(draws.size() + CULL_WIDTH);
+            nVisible = bounds.Cull(frustum, visible.data());
+            cullMs += ElapsedMs(start);
+
+            start = BenchmarkClock::now();
+            RecordDrawCommands(draws, visible.data(), nVisible, buffers);
+            MergeDrawCommands(buffers, commands);
+            recordMs += ElapsedMs(start);
+        }
+
+        std::cout << info.instances << " instances (" << info.triangles << " triangles, " << info.lights << " lights, "
+            << info.halfSize * 2.0f << " units across): generate " << generateMs << " ms | per frame: transforms "
+            << transformMs / ITERATIONS << " ms, extraction " << extractMs / ITERATIONS << " ms, culling " << cullMs / ITERATIONS
+            << " ms (" << nVisible << " visible), recording " << recordMs / ITERATIONS << " ms" << std::endl;
+    }
+}
+
+// Times a frame of the stress scene's CPU work on 1, 2, 4... up to every hardware thread, as a graph of
+// jobs: the transform system, then light and draw extraction side by side once it is done, then
+// frustum culling of the draws. Every system splits its own work further with ParallelFor.
+inline void RunJobBenchmark(size_t count, uint32_t seed)
+{
+    const int ITERATIONS = 20;
+
+    EntityStore store;
+    const StressSceneInfo info = GenerateStressScene(store, StressBenchmarkPrototypes(), 4, count, seed);
+    const Frustum frustum = ExtractFrustum(glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f)
+        * glm::lookAt(glm::vec3(0.0f, 3.0f, 0.0f), glm::vec3(10.0f, 0.0f, 10.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+
+    std::vector<unsigned> threadCounts;
+    for (unsigned threads = 1; threads < HardwareThreadCount(); threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(HardwareThreadCount());
+
+    std::cout << "Job system benchmark, " << info.instances << " instances and " << info.lights << " lights, seed " << seed
+        << ", " << ITERATIONS << " iterations" << std::endl;
+
+    std::vector<LightPacket> lights;
+    std::vector<DrawPacket> draws;
+    CullBounds bounds;
+    std::vector<uint32_t> visible;
+    size_t nVisible = 0;
+    double singleThreadMs = 0.0;
+    for (unsigned threads : threadCounts)
+    {
+        JobSystem& jobs = Jobs();
+        jobs.Restart(threads);
+
+        // Warm up, so the output arrays are already allocated
+        UpdateTransforms(store, 0.0f);
+        ExtractDraws(store, glm::vec3(0.0f, 3.0f, 0.0f), draws);
+
+        const BenchmarkClock::time_point start = BenchmarkClock::now();
+        for (int iteration = 0; iteration < ITERATIONS; ++iteration)
+        {
+            JobCounter transformed, extracted;
+            jobs.Run(transformed, [&]() { UpdateTransforms(store, 1.0f / 60.0f); });
+            jobs.RunAfter(transformed, extracted, [&]() { ExtractLights(store, lights); });
+            jobs.RunAfter(transformed, extracted, [&]()
+            {
+                ExtractDraws(store, glm::vec3(0.0f, 3.0f, 0.0f), draws);
+                StressCullBounds(draws, bounds);
+            });
+            jobs.Wait(extracted);
+
+            // The transform job may still be queuing the extraction jobs after they have finished,
+            // and it touches its counter until it is done
+            jobs.Wait(transformed);
+
+            visible.resize(draws.size() + CULL_WIDTH);
+            nVisible = bounds.Cull(frustum, visible.data());
+        }
+        const double frameMs = ElapsedMs(start) / ITERATIONS;
+        if (threads == 1)
+            singleThreadMs = frameMs;
+
+        std::cout << threads << " threads: " << frameMs << " ms per frame, " << singleThreadMs / frameMs << "x (" << nVisible << " visible)" << std::endl;
+    }
+    Jobs().Restart(HardwareThreadCount());
+}
+
+#endif
@@ -0,0 +1,505 @@
+#pragma once
+
+#ifndef TRIANGLE_BVH_H
+#define TRIANGLE_BVH_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TRIANGLE_BVH_SSE
+#endif
+
+// Bounding volume hierarchy over a triangle soup, used to trace rays against static geometry.
+// Built top-down with binned SAH splits and stored as a flat, depth-first node array. Rays are
+// tested against a node's box on three axes at once and against the triangles of a leaf four at a
+// time with SSE, or one at a time where it is not available.
+class TriangleBvh
+{
+public:
+    // Closest hit returned by Intersect
+    struct Hit
+    {
+        float t;            // Distance along the ray
+        float u, v;         // Barycentric coordinates of the hit point
+        uint32_t triangle;  // Index of the triangle in the soup passed to Build
+    };
+
+    // Builds the hierarchy from a triangle soup (three positions per triangle)
+    void Build(const std::vector<glm::vec3>& positions)
+    {
+        const uint32_t nTriangles = uint32_t(positions.size() / 3);
+
+        triangles.resize(nTriangles);
+        indices.resize(nTriangles);
+        nodes.clear();
+        nodes.reserve(nTriangles * 2 + 1);
+
+        std::vector<glm::vec3> centroids(nTriangles);
+        for (uint32_t i = 0; i < nTriangles; ++i)
+        {
+            const glm::vec3& p0 = positions[i * 3 + 0];
+            const glm::vec3& p1 = positions[i * 3 + 1];
+            const glm::vec3& p2 = positions[i * 3 + 2];
+            triangles[i] = { p0, p1 - p0, p2 - p0 };
+            centroids[i] = (p0 + p1 + p2) / 3.0f;
+            indices[i] = i;
+        }
+
+        triangleCount = nTriangles;
+        packets.clear();
+        if (nTriangles == 0)
+            return;
+
+        nodes.push_back(Node());
+        Subdivide(0, 0, nTriangles, 0, centroids);
+        BuildPackets();
+    }
+
+    // Returns true if anything is hit between the origin and maxDistance (shadow rays)
+    bool Occluded(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const
+    {
+        Hit hit;
+        return Traverse(origin, direction, maxDistance, true, hit);
+    }
+
+    // Finds the closest hit along the ray, returns false if nothing is hit before maxDistance
+    bool Intersect(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Hit& hit) const
+    {
+        return Traverse(origin, direction, maxDistance, false, hit);
+    }
+
+    size_t TriangleCount() const { return triangleCount; }
+    size_t NodeCount() const { return nodes.size(); }
+
+private:
+    // Triangle stored as one vertex and two edges, ready for the Moller-Trumbore test
+    struct Triangle
+    {
+        glm::vec3 v0, e1, e2;
+    };
+
+    // 32 byte node: interior nodes store the index of their left child (the right child
+    // immediately follows it), leaves store their first packet and their triangle count
+    struct Node
+    {
+        glm::vec3 boundsMin;
+        uint32_t leftOrFirst;
+        glm::vec3 boundsMax;
+        uint32_t count;
+    };
+
+    // Four triangles, each component stored for all four at once so a SIMD register loads it directly
+    static const int PACKET_WIDTH = 4;
+    struct TrianglePacket
+    {
+        float v0[3][PACKET_WIDTH];
+        float e1[3][PACKET_WIDTH];
+        float e2[3][PACKET_WIDTH];
+        uint32_t triangle[PACKET_WIDTH];    // Index in the soup passed to Build
+    };
+
+    static const int BIN_COUNT = 12;
+    static const uint32_t MAX_LEAF_SIZE = 4;
+    static const int STACK_SIZE = 64;
+    static const uint32_t MAX_DEPTH = STACK_SIZE;  // Deeper nodes are left as leaves, so traversal never pushes more than the stack holds
+
+    std::vector<Node> nodes;
+    std::vector<TrianglePacket> packets;
+    std::vector<Triangle> triangles;    // Only kept during builds
+    std::vector<uint32_t> indices;
+    size_t triangleCount = 0;
+
+    static float SurfaceArea(const glm::vec3& extent)
+    {
+        return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+    }
+
+    void GrowBounds(const Triangle& tri, glm::vec3& boundsMin, glm::vec3& boundsMax) const
+    {
+        const glm::vec3 p1 = tri.v0 + tri.e1;
+        const glm::vec3 p2 = tri.v0 + tri.e2;
+        boundsMin = glm::min(boundsMin, glm::min(tri.v0, glm::min(p1, p2)));
+        boundsMax = glm::max(boundsMax, glm::max(tri.v0, glm::max(p1, p2)));
+    }
+
+    void Subdivide(uint32_t nodeIndex, uint32_t first, uint32_t count, uint32_t depth, const std::vector<glm::vec3>& centroids)
+    {
+        glm::vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+        glm::vec3 centroidMin(FLT_MAX), centroidMax(-FLT_MAX);
+        for (uint32_t i = first; i < first + count; ++i)
+        {
+            GrowBounds(triangles[indices[i]], boundsMin, boundsMax);
+            centroidMin = glm::min(centroidMin, centroids[indices[i]]);
+            centroidMax = glm::max(centroidMax, centroids[indices[i]]);
+        }
+
+        nodes[nodeIndex].boundsMin = boundsMin;
+        nodes[nodeIndex].boundsMax = boundsMax;
+        nodes[nodeIndex].leftOrFirst = first;
+        nodes[nodeIndex].count = count;
+
+        if (count <= MAX_LEAF_SIZE || depth >= MAX_DEPTH)
+            return;
+
+        // Find the cheapest binned SAH split over all three axes
+        int bestAxis = -1;
+        int bestSplit = 0;
+        float bestCost = SurfaceArea(boundsMax - boundsMin) * count;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const float extent = centroidMax[axis] - centroidMin[axis];
+            if (extent <= 0.0f)
+                continue;
+
+            struct Bin { glm::vec3 boundsMin = glm::vec3(FLT_MAX), boundsMax = glm::vec3(-FLT_MAX); uint32_t count = 0; };
+            Bin bins[BIN_COUNT];
+            const float scale = BIN_COUNT / extent;
+
+            for (uint32_t i = first; i < first + count; ++i)
+            {
+                const int bin = std::min(BIN_COUNT - 1, int((centroids[indices[i]][axis] - centroidMin[axis]) * scale));
+                GrowBounds(triangles[indices[i]], bins[bin].boundsMin, bins[bin].boundsMax);
+                bins[bin].count++;
+            }
+
+            // Sweep from both sides to get the area and count on each side of every split plane
+            float leftArea[BIN_COUNT - 1], rightArea[BIN_COUNT - 1];
+            uint32_t leftCount[BIN_COUNT - 1], rightCount[BIN_COUNT - 1];
+            glm::vec3 leftMin(FLT_MAX), leftMax(-FLT_MAX), rightMin(FLT_MAX), rightMax(-FLT_MAX);
+            uint32_t leftSum = 0, rightSum = 0;
+            for (int i = 0; i < BIN_COUNT - 1; ++i)
+            {
+                leftSum += bins[i].count;
+                leftCount[i] = leftSum;
+                leftMin = glm::min(leftMin, bins[i].boundsMin);
+                leftMax = glm::max(leftMax, bins[i].boundsMax);
+                leftArea[i] = leftSum ? SurfaceArea(leftMax - leftMin) : 0.0f;
+
+                rightSum += bins[BIN_COUNT - 1 - i].count;
+                rightCount[BIN_COUNT - 2 - i] = rightSum;
+                rightMin = glm::min(rightMin, bins[BIN_COUNT - 1 - i].boundsMin);
+                rightMax = glm::max(rightMax, bins[BIN_COUNT - 1 - i].boundsMax);
+                rightArea[BIN_COUNT - 2 - i] = rightSum ? SurfaceArea(rightMax - rightMin) : 0.0f;
+            }
+
+            for (int i = 0; i < BIN_COUNT - 1; ++i)
+            {
+                const float cost = leftArea[i] * leftCount[i] + rightArea[i] * rightCount[i];
+                if (leftCount[i] > 0 && rightCount[i] > 0 && cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = i;
+                }
+            }
+        }
+
+        if (bestAxis < 0)
+            return; // Splitting would not pay off, keep this node a leaf
+
+        // Partition the indices around the chosen bin boundary
+        const float scale = BIN_COUNT / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+        uint32_t* begin = indices.data() + first;
+        uint32_t* middle = std::partition(begin, begin + count, [&](uint32_t index)
+        {
+            const int bin = std::min(BIN_COUNT - 1, int((centroids[index][bestAxis] - centroidMin[bestAxis]) * scale));
+            return bin <= bestSplit;
+        });
+        const uint32_t leftCount = uint32_t(middle - begin);
+
+        const uint32_t leftIndex = uint32_t(nodes.size());
+        nodes.push_back(Node());
+        nodes.push_back(Node());
+        nodes[nodeIndex].leftOrFirst = leftIndex;
+        nodes[nodeIndex].count = 0;
+
+        Subdivide(leftIndex, first, leftCount, depth + 1, centroids);
+        Subdivide(leftIndex + 1, first + leftCount, count - leftCount, depth + 1, centroids);
+    }
+
+    // After the build every leaf (MAX_LEAF_SIZE triangles, more at MAX_DEPTH) is turned into packets
+    // of four triangles stored component by component, one SIMD lane per triangle. Unused lanes have
+    // no area and never hit. Leaves then point at their first packet instead of their first index.
+    void BuildPackets()
+    {
+        packets.clear();
+        for (Node& node : nodes)
+        {
+            if (node.count == 0)
+                continue;
+
+            const uint32_t firstPacket = uint32_t(packets.size());
+            for (uint32_t i = 0; i < node.count; i += PACKET_WIDTH)
+            {
+                TrianglePacket packet = {};
+                for (uint32_t lane = 0; lane < PACKET_WIDTH && i + lane < node.count; ++lane)
+                {
+                    const uint32_t index = indices[node.leftOrFirst + i + lane];
+                    const Triangle& tri = triangles[index];
+                    for (int axis = 0; axis < 3; ++axis)
+                    {
+                        packet.v0[axis][lane] = tri.v0[axis];
+                        packet.e1[axis][lane] = tri.e1[axis];
+                        packet.e2[axis][lane] = tri.e2[axis];
+                    }
+                    packet.triangle[lane] = index;
+                }
+                packets.push_back(packet);
+            }
+            node.leftOrFirst = firstPacket;
+        }
+
+        triangles.clear();
+        triangles.shrink_to_fit();
+        indices.clear();
+        indices.shrink_to_fit();
+    }
+
+#if defined(TRIANGLE_BVH_SSE)
+    // The ray broadcast to every lane, and as one xyz vector for the box test
+    struct Ray
+    {
+        __m128 origin[3], direction[3];
+        __m128 originXyz, inverseDirectionXyz;
+    };
+
+    static Ray MakeRay(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& inverseDirection)
+    {
+        Ray ray;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            ray.origin[axis] = _mm_set1_ps(origin[axis]);
+            ray.direction[axis] = _mm_set1_ps(direction[axis]);
+        }
+        ray.originXyz = _mm_setr_ps(origin.x, origin.y, origin.z, 0.0f);
+        ray.inverseDirectionXyz = _mm_setr_ps(inverseDirection.x, inverseDirection.y, inverseDirection.z, 0.0f);
+        return ray;
+    }
+
+    // Slab test on all three axes at once, returns the entry distance or FLT_MAX when the box is missed.
+    // The fourth lane loads the node's index or count, it is replaced by 0 for the entry (the ray starts
+    // at the origin) and by maxDistance for the exit.
+    static float IntersectBounds(const Node& node, const Ray& ray, float maxDistance)
+    {
+        const __m128 xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+        const __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&node.boundsMin.x), ray.originXyz), ray.inverseDirectionXyz);
+        const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&node.boundsMax.x), ray.originXyz), ray.inverseDirectionXyz);
+        __m128 tNear = _mm_and_ps(_mm_min_ps(t0, t1), xyz);
+        __m128 tFar = _mm_or_ps(_mm_and_ps(_mm_max_ps(t0, t1), xyz), _mm_andnot_ps(xyz, _mm_set1_ps(maxDistance)));
+
+        tNear = _mm_max_ps(tNear, _mm_shuffle_ps(tNear, tNear, _MM_SHUFFLE(2, 3, 0, 1)));
+        tNear = _mm_max_ps(tNear, _mm_shuffle_ps(tNear, tNear, _MM_SHUFFLE(1, 0, 3, 2)));
+        tFar = _mm_min_ps(tFar, _mm_shuffle_ps(tFar, tFar, _MM_SHUFFLE(2, 3, 0, 1)));
+        tFar = _mm_min_ps(tFar, _mm_shuffle_ps(tFar, tFar, _MM_SHUFFLE(1, 0, 3, 2)));
+
+        const float entry = _mm_cvtss_f32(tNear);
+        return entry <= _mm_cvtss_f32(tFar) ? entry : FLT_MAX;
+    }
+
+    // Moller-Trumbore against the four triangles of a packet. Returns the lane of the closest hit nearer
+    // than maxDistance, or -1.
+    static int IntersectPacket(const TrianglePacket& packet, const Ray& ray, float maxDistance, float& t, float& u, float& v)
+    {
+        const __m128 e1x = _mm_loadu_ps(packet.e1[0]), e1y = _mm_loadu_ps(packet.e1[1]), e1z = _mm_loadu_ps(packet.e1[2]);
+        const __m128 e2x = _mm_loadu_ps(packet.e2[0]), e2y = _mm_loadu_ps(packet.e2[1]), e2z = _mm_loadu_ps(packet.e2[2]);
+        const __m128 dx = ray.direction[0], dy = ray.direction[1], dz = ray.direction[2];
+
+        // p = direction x e2
+        const __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+        const __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+        const __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+        const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+        const __m128 inverseDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+        // s = origin - v0, q = s x e1
+        const __m128 sx = _mm_sub_ps(ray.origin[0], _mm_loadu_ps(packet.v0[0]));
+        const __m128 sy = _mm_sub_ps(ray.origin[1], _mm_loadu_ps(packet.v0[1]));
+        const __m128 sz = _mm_sub_ps(ray.origin[2], _mm_loadu_ps(packet.v0[2]));
+        const __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+        const __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+        const __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+
+        const __m128 laneU = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inverseDet);
+        const __m128 laneV = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inverseDet);
+        const __m128 laneT = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverseDet);
+
+        // Comparisons against NaN fail, so degenerate and padding lanes drop out with the det test
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 absDet = _mm_andnot_ps(_mm_set1_ps(-0.0f), det);
+        __m128 mask = _mm_cmpgt_ps(absDet, _mm_set1_ps(1e-9f));
+        mask = _mm_and_ps(mask, _mm_cmpge_ps(laneU, zero));
+        mask = _mm_and_ps(mask, _mm_cmpge_ps(laneV, zero));
+        mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(laneU, laneV), _mm_set1_ps(1.0f)));
+        mask = _mm_and_ps(mask, _mm_cmpgt_ps(laneT, zero));
+        mask = _mm_and_ps(mask, _mm_cmplt_ps(laneT, _mm_set1_ps(maxDistance)));
+
+        int bits = _mm_movemask_ps(mask);
+        if (bits == 0)
+            return -1;
+
+        alignas(16) float ts[4], us[4], vs[4];
+        _mm_store_ps(ts, laneT);
+        _mm_store_ps(us, laneU);
+        _mm_store_ps(vs, laneV);
+        int closest = -1;
+        t = maxDistance;
+        for (int lane = 0; lane < PACKET_WIDTH; ++lane)
+        {
+            if ((bits >> lane) & 1 && ts[lane] < t)
+            {
+                closest = lane;
+                t = ts[lane];
+            }
+        }
+        u = us[closest];
+        v = vs[closest];
+        return closest;
+    }
+#else
+    struct Ray
+    {
+        glm::vec3 origin, direction, inverseDirection;
+    };
+
+    static Ray MakeRay(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& inverseDirection)
+    {
+        return { origin, direction, inverseDirection };
+    }
+
+    // Slab test, returns the entry distance or FLT_MAX when the box is missed
+    static float IntersectBounds(const Node& node, const Ray& ray, float maxDistance)
+    {
+        const glm::vec3 t0 = (node.boundsMin - ray.origin) * ray.inverseDirection;
+        const glm::vec3 t1 = (node.boundsMax - ray.origin) * ray.inverseDirection;
+        const glm::vec3 tNear = glm::min(t0, t1);
+        const glm::vec3 tFar = glm::max(t0, t1);
+        const float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        const float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+        return entry <= exit ? entry : FLT_MAX;
+    }
+
+    // Moller-Trumbore against the triangles of a packet one lane at a time. Returns the lane of the
+    // closest hit nearer than maxDistance, or -1.
+    static int IntersectPacket(const TrianglePacket& packet, const Ray& ray, float maxDistance, float& t, float& u, float& v)
+    {
+        int closest = -1;
+        t = maxDistance;
+        for (int lane = 0; lane < PACKET_WIDTH; ++lane)
+        {
+            const glm::vec3 v0(packet.v0[0][lane], packet.v0[1][lane], packet.v0[2][lane]);
+            const glm::vec3 e1(packet.e1[0][lane], packet.e1[1][lane], packet.e1[2][lane]);
+            const glm::vec3 e2(packet.e2[0][lane], packet.e2[1][lane], packet.e2[2][lane]);
+
+            const glm::vec3 p = glm::cross(ray.direction, e2);
+            const float det = glm::dot(e1, p);
+            if (std::abs(det) < 1e-9f)
+                continue;
+
+            const float inverseDet = 1.0f / det;
+            const glm::vec3 s = ray.origin - v0;
+            const float laneU = glm::dot(s, p) * inverseDet;
+            if (laneU < 0.0f || laneU > 1.0f)
+                continue;
+
+            const glm::vec3 q = glm::cross(s, e1);
+            const float laneV = glm::dot(ray.direction, q) * inverseDet;
+            if (laneV < 0.0f || laneU + laneV > 1.0f)
+                continue;
+
+            const float laneT = glm::dot(e2, q) * inverseDet;
+            if (laneT > 0.0f && laneT < t)
+            {
+                closest = lane;
+                t = laneT;
+                u = laneU;
+                v = laneV;
+            }
+        }
+        return closest;
+    }
+#endif
+
+    bool Traverse(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, bool anyHit, Hit& hit) const
+    {
+        if (nodes.empty())
+            return false;
+
+        const glm::vec3 inverseDirection(
+            1.0f / (direction.x != 0.0f ? direction.x : 1e-30f),
+            1.0f / (direction.y != 0.0f ? direction.y : 1e-30f),
+            1.0f / (direction.z != 0.0f ? direction.z : 1e-30f));
+        const Ray ray = MakeRay(origin, direction, inverseDirection);
+
+        bool found = false;
+        hit.t = maxDistance;
+
+        uint32_t stack[STACK_SIZE];
+        int stackSize = 0;
+        uint32_t nodeIndex = 0;
+
+        if (IntersectBounds(nodes[0], ray, hit.t) == FLT_MAX)
+            return false;
+
+        for (;;)
+        {
+            const Node& node = nodes[nodeIndex];
+            if (node.count > 0)
+            {
+                const uint32_t lastPacket = node.leftOrFirst + (node.count + PACKET_WIDTH - 1) / PACKET_WIDTH;
+                for (uint32_t p = node.leftOrFirst; p < lastPacket; ++p)
+                {
+                    float t, u, v;
+                    const int lane = IntersectPacket(packets[p], ray, hit.t, t, u, v);
+                    if (lane >= 0)
+                    {
+                        hit.t = t;
+                        hit.u = u;
+                        hit.v = v;
+                        hit.triangle = packets[p].triangle[lane];
+                        found = true;
+                        if (anyHit)
+                            return true;
+                    }
+                }
+            }
+            else
+            {
+                // Visit the nearer child first and push the other one
+                uint32_t nearIndex = node.leftOrFirst;
+                uint32_t farIndex = node.leftOrFirst + 1;
+                float nearDistance = IntersectBounds(nodes[nearIndex], ray, hit.t);
+                float farDistance = IntersectBounds(nodes[farIndex], ray, hit.t);
+                if (farDistance < nearDistance)
+                {
+                    std::swap(nearIndex, farIndex);
+                    std::swap(nearDistance, farDistance);
+                }
+
+                if (nearDistance != FLT_MAX)
+                {
+                    // At most one node is pushed per level and the tree is at most MAX_DEPTH deep
+                    if (farDistance != FLT_MAX)
+                        stack[stackSize++] = farIndex;
+                    nodeIndex = nearIndex;
+                    continue;
+                }
+            }
+
+            if (stackSize == 0)
+                break;
+            nodeIndex = stack[--stackSize];
+        }
+
+        return found;
+    }
+};
+
+#endif
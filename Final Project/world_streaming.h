@@ -0,0 +1,478 @@
+#pragma once
+
+#ifndef WORLD_STREAMING_H
+#define WORLD_STREAMING_H
+
+#include "benchmark_clock.h"
+#include "stress_scene.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// World split into square chunks on the ground plane, stored in one file: a table of chunks, then the
+// instances and lights of every chunk. Chunks are loaded on a background thread as the camera comes
+// near them and dropped again once it is far away.
+
+const uint32_t WORLD_CHUNKS_MAGIC = 0x4b4e4843; // "CHNK"
+const uint32_t WORLD_CHUNKS_VERSION = 1;
+
+// Where a chunk is in the world and in the file
+struct ChunkEntry
+{
+    int32_t x, z;               // Chunk coordinates, the chunk covers [x, x + 1) * chunkSize on the x axis
+    uint64_t offset;            // Of its instances in the file, its lights follow them
+    uint32_t nInstances;
+    uint32_t nLights;
+};
+
+// Contents of a chunk
+struct ChunkData
+{
+    std::vector<StressInstance> instances;
+    std::vector<StressLight> lights;
+};
+
+// Sorts the instances and lights into chunks of chunkSize and writes them to path
+inline bool SaveWorldChunks(const char* path, float chunkSize, const std::vector<StressInstance>& instances, const std::vector<StressLight>& lights)
+{
+    std::map<std::pair<int32_t, int32_t>, ChunkData> chunks;
+    auto cell = [chunkSize](const LocalTransform& transform)
+    {
+        return std::make_pair(int32_t(std::floor(transform.position.x / chunkSize)), int32_t(std::floor(transform.position.z / chunkSize)));
+    };
+    for (const StressInstance& instance : instances)
+        chunks[cell(instance.transform)].instances.push_back(instance);
+    for (const StressLight& light : lights)
+        chunks[cell(light.transform)].lights.push_back(light);
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    const uint32_t header[3] = { WORLD_CHUNKS_MAGIC, WORLD_CHUNKS_VERSION, uint32_t(chunks.size()) };
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(&chunkSize), sizeof(chunkSize));
+
+    std::vector<ChunkEntry> table;
+    uint64_t offset = sizeof(header) + sizeof(chunkSize) + chunks.size() * sizeof(ChunkEntry);
+    for (const auto& chunk : chunks)
+    {
+        table.push_back({ chunk.first.first, chunk.first.second, offset, uint32_t(chunk.second.instances.size()), uint32_t(chunk.second.lights.size()) });
+        offset += chunk.second.instances.size() * sizeof(StressInstance) + chunk.second.lights.size() * sizeof(StressLight);
+    }
+    file.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(ChunkEntry));
+
+    for (const auto& chunk : chunks)
+    {
+        file.write(reinterpret_cast<const char*>(chunk.second.instances.data()), chunk.second.instances.size() * sizeof(StressInstance));
+        file.write(reinterpret_cast<const char*>(chunk.second.lights.data()), chunk.second.lights.size() * sizeof(StressLight));
+    }
+
+    return bool(file);
+}
+
+// Streams the chunks of a world file around a moving camera. Update is called once per frame from the
+// main thread: it requests the chunks within the load radius of the camera or of where its velocity
+// will take it, nearest first, and drops those beyond the evict radius. A loader thread reads the
+// requests, and the main thread takes the finished chunks with TakeLoaded to create their entities.
+// Everything requested, loaded or resident counts against the memory budget; a chunk that does not
+// fit evicts resident chunks farther away than itself, or waits.
+class ChunkStreamer
+{
+public:
+    struct Settings
+    {
+        float loadRadius = 60.0f;           // Chunks nearer than this to the camera or its predicted position are loaded
+        float evictRadius = 90.0f;          // Chunks farther than this from both are dropped
+        float lookaheadSeconds = 1.5f;      // How far ahead the camera's velocity is followed
+        size_t memoryBudget = 64u << 20;    // Bytes of resident chunks, including the ones on their way
+        size_t bytesPerItem = 256;          // Memory of one instance or light once it is resident
+    };
+
+    // Chunk that finished loading
+    struct LoadedChunk
+    {
+        uint32_t chunk;             // Index in the file's table
+        ChunkData data;
+        double latencyMs;           // From the request to the end of the read
+    };
+
+    struct Stats
+    {
+        size_t residentChunks;
+        size_t residentBytes;       // Including the chunks requested and loading
+        size_t queuedChunks;
+        size_t loadedChunks;        // Since the last ResetStats
+        size_t evictedChunks;
+        double averageLatencyMs;
+        double maxLatencyMs;
+    };
+
+    ChunkStreamer() = default;
+    ChunkStreamer(const ChunkStreamer&) = delete;
+    ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+    ~ChunkStreamer()
+    {
+        Close();
+    }
+
+    // Reads the chunk table of a world file and starts the loader thread
+    bool Open(const char* path, const Settings& newSettings)
+    {
+        Close();
+
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+
+        uint32_t header[3] = {};
+        file.read(reinterpret_cast<char*>(header), sizeof(header));
+        file.read(reinterpret_cast<char*>(&chunkSize), sizeof(chunkSize));
+        if (!file || header[0] != WORLD_CHUNKS_MAGIC || header[1] != WORLD_CHUNKS_VERSION || chunkSize <= 0.0f)
+            return false;
+
+        table.resize(header[2]);
+        file.read(reinterpret_cast<char*>(table.data()), table.size() * sizeof(ChunkEntry));
+        if (!file)
+            return false;
+
+        settings = newSettings;
+        filePath = path;
+        states.assign(table.size(), CHUNK_UNLOADED);
+        requestTimes.assign(table.size(), Clock::time_point());
+        residentBytes = 0;
+        ResetStats();
+
+        stopping = false;
+        loader = std::thread([this]() { LoaderThread(); });
+        return true;
+    }
+
+    // Stops the loader thread and forgets every chunk
+    void Close()
+    {
+        if (loader.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            loader.join();
+        }
+        table.clear();
+        states.clear();
+        queue.clear();
+        completed.clear();
+        residentBytes = 0;
+    }
+
+    bool IsOpen() const { return loader.joinable(); }
+
+    // Requests and evicts chunks for the camera's position and velocity. The resident chunks dropped are
+    // appended to evicted, the caller destroys what it created for them.
+    void Update(const glm::vec3& position, const glm::vec3& velocity, std::vector<uint32_t>& evicted)
+    {
+        const glm::vec3 predicted = position + velocity * settings.lookaheadSeconds;
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // Score every chunk by its distance to the nearer of the two points
+        scores.resize(table.size());
+        wanted.clear();
+        for (uint32_t i = 0; i < table.size(); ++i)
+        {
+            scores[i] = std::min(Distance(table[i], position), Distance(table[i], predicted));
+            if (scores[i] > settings.evictRadius && states[i] != CHUNK_UNLOADED)
+                Evict(i, evicted);
+            else if (scores[i] <= settings.loadRadius && states[i] == CHUNK_UNLOADED)
+                wanted.push_back(i);
+        }
+
+        // Nearest first, making room by evicting farther resident chunks when the budget is full
+        std::sort(wanted.begin(), wanted.end(), [this](uint32_t a, uint32_t b) { return scores[a] < scores[b]; });
+        for (uint32_t chunk : wanted)
+        {
+            const size_t bytes = ChunkBytes(chunk);
+            while (residentBytes + bytes > settings.memoryBudget)
+            {
+                uint32_t farthest = UINT32_MAX;
+                for (uint32_t i = 0; i < table.size(); ++i)
+                    if (states[i] == CHUNK_RESIDENT && scores[i] > scores[chunk] && (farthest == UINT32_MAX || scores[i] > scores[farthest]))
+                        farthest = i;
+                if (farthest == UINT32_MAX)
+                    break;
+                Evict(farthest, evicted);
+            }
+            if (residentBytes + bytes > settings.memoryBudget)
+                break;
+
+            states[chunk] = CHUNK_QUEUED;
+            requestTimes[chunk] = Clock::now();
+            residentBytes += bytes;
+            queue.push_back(chunk);
+        }
+
+        // The loader takes the queue from the back, nearest last
+        std::sort(queue.begin(), queue.end(), [this](uint32_t a, uint32_t b) { return scores[a] > scores[b]; });
+        if (!queue.empty())
+            wake.notify_one();
+    }
+
+    // Takes a chunk that finished loading, nearest first. Returns false when none is ready.
+    bool TakeLoaded(LoadedChunk& loaded)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (completed.empty())
+            return false;
+
+        auto nearest = std::min_element(completed.begin(), completed.end(), [this](const LoadedChunk& a, const LoadedChunk& b)
+        {
+            return scores[a.chunk] < scores[b.chunk];
+        });
+        loaded = std::move(*nearest);
+        completed.erase(nearest);
+        states[loaded.chunk] = CHUNK_RESIDENT;
+
+        ++stats.loadedChunks;
+        latencySum += loaded.latencyMs;
+        stats.maxLatencyMs = std::max(stats.maxLatencyMs, loaded.latencyMs);
+        return true;
+    }
+
+    Stats GetStats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Stats result = stats;
+        result.residentBytes = residentBytes;
+        result.residentChunks = size_t(std::count(states.begin(), states.end(), CHUNK_RESIDENT));
+        result.queuedChunks = queue.size();
+        result.averageLatencyMs = stats.loadedChunks > 0 ? latencySum / stats.loadedChunks : 0.0;
+        return result;
+    }
+
+    // Starts a new period for the load and eviction counts and the latencies
+    void ResetStats()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats = Stats();
+        latencySum = 0.0;
+    }
+
+    const ChunkEntry& Entry(uint32_t chunk) const { return table[chunk]; }
+    size_t ChunkCount() const { return table.size(); }
+    float ChunkSize() const { return chunkSize; }
+
+private:
+    typedef std::chrono::high_resolution_clock Clock;
+
+    enum ChunkState
+    {
+        CHUNK_UNLOADED,
+        CHUNK_QUEUED,           // Waiting for the loader
+        CHUNK_LOADING,          // Being read by the loader
+        CHUNK_LOADED,           // Read, waiting for TakeLoaded
+        CHUNK_RESIDENT          // Taken by the caller
+    };
+
+    Settings settings;
+    std::string filePath;
+    float chunkSize = 0.0f;
+    std::vector<ChunkEntry> table;
+
+    // Shared with the loader thread, guarded by mutex
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<ChunkState> states;
+    std::vector<Clock::time_point> requestTimes;
+    std::vector<uint32_t> queue;
+    std::vector<LoadedChunk> completed;
+    std::vector<float> scores;
+    size_t residentBytes = 0;
+    bool stopping = false;
+    Stats stats = Stats();
+    double latencySum = 0.0;
+
+    std::vector<uint32_t> wanted;   // Scratch of Update
+    std::thread loader;
+
+    size_t ChunkBytes(uint32_t chunk) const
+    {
+        return (size_t(table[chunk].nInstances) + table[chunk].nLights) * settings.bytesPerItem;
+    }
+
+    // Distance on the ground plane from a point to the nearest point of the chunk
+    float Distance(const ChunkEntry& entry, const glm::vec3& point) const
+    {
+        const float dx = std::max(std::max(entry.x * chunkSize - point.x, point.x - (entry.x + 1) * chunkSize), 0.0f);
+        const float dz = std::max(std::max(entry.z * chunkSize - point.z, point.z - (entry.z + 1) * chunkSize), 0.0f);
+        return std::sqrt(dx * dx + dz * dz);
+    }
+
+    // Forgets a chunk in any state, with the mutex held. A chunk being loaded is dropped by the loader
+    // when it sees the state has changed.
+    void Evict(uint32_t chunk, std::vector<uint32_t>& evicted)
+    {
+        switch (states[chunk])
+        {
+        case CHUNK_QUEUED:
+            queue.erase(std::find(queue.begin(), queue.end(), chunk));
+            break;
+        case CHUNK_LOADED:
+            completed.erase(std::find_if(completed.begin(), completed.end(), [chunk](const LoadedChunk& loaded) { return loaded.chunk == chunk; }));
+            break;
+        case CHUNK_RESIDENT:
+            evicted.push_back(chunk);
+            ++stats.evictedChunks;
+            break;
+        default:
+            break;
+        }
+        states[chunk] = CHUNK_UNLOADED;
+        residentBytes -= ChunkBytes(chunk);
+    }
+
+    void LoaderThread()
+    {
+        std::ifstream file(filePath, std::ios::binary);
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
+        {
+            wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (stopping)
+                return;
+
+            const uint32_t chunk = queue.back();
+            queue.pop_back();
+            states[chunk] = CHUNK_LOADING;
+            const ChunkEntry entry = table[chunk];
+            const Clock::time_point requested = requestTimes[chunk];
+
+            // Read without holding the lock, the main thread keeps going
+            lock.unlock();
+            LoadedChunk loaded;
+            loaded.chunk = chunk;
+            loaded.data.instances.resize(entry.nInstances);
+            loaded.data.lights.resize(entry.nLights);
+            file.clear();
+            file.seekg(std::streamoff(entry.offset));
+            file.read(reinterpret_cast<char*>(loaded.data.instances.data()), entry.nInstances * sizeof(StressInstance));
+            file.read(reinterpret_cast<char*>(loaded.data.lights.data()), entry.nLights * sizeof(StressLight));
+            const bool ok = bool(file);
+            loaded.latencyMs = std::chrono::duration<double, std::milli>(Clock::now() - requested).count();
+            lock.lock();
+
+            // Evicted while loading: its bytes were already given back
+            if (states[chunk] != CHUNK_LOADING)
+                continue;
+
+            if (!ok)
+            {
+                std::cout << "ERROR::STREAMING::CHUNK_READ_FAILED " << entry.x << ", " << entry.z << std::endl;
+                loaded.data = ChunkData();
+            }
+            states[chunk] = CHUNK_LOADED;
+            completed.push_back(std::move(loaded));
+        }
+    }
+};
+
+// Flies a camera in a straight line over a streamed stress world and times the main thread's side of
+// every frame: Update, taking loaded chunks and creating and destroying their entities, at most
+// spawnBudget instances per frame. The slowest frame shows whether streaming causes hitches.
+inline void RunStreamingBenchmark(size_t count, uint32_t seed, size_t memoryBudget, size_t spawnBudget)
+{
+    const char* const path = "streaming_benchmark.chunks";
+    const float CHUNK_SIZE = 16.0f;
+    const float SPEED = 30.0f;          // Units per second
+    const int FRAMES = 1200;
+    const float FRAME_TIME = 1.0f / 60.0f;
+
+    const std::vector<StressPrototype> prototypes = StressBenchmarkPrototypes();
+    std::vector<StressInstance> instances;
+    std::vector<StressLight> lights;
+    BenchmarkClock::time_point start = BenchmarkClock::now();
+    const StressSceneInfo info = ScatterStressScene(prototypes, 4, count, seed, instances, lights);
+    if (!SaveWorldChunks(path, CHUNK_SIZE, instances, lights))
+    {
+        std::cout << "ERROR::STREAMING::WRITE_FAILED " << path << std::endl;
+        return;
+    }
+    const double writeMs = ElapsedMs(start);
+
+    ChunkStreamer::Settings settings;
+    settings.memoryBudget = memoryBudget;
+    ChunkStreamer streamer;
+    if (!streamer.Open(path, settings))
+    {
+        std::cout << "ERROR::STREAMING::OPEN_FAILED " << path << std::endl;
+        return;
+    }
+    std::cout << "Streaming benchmark: " << info.instances << " instances in " << streamer.ChunkCount() << " chunks written in " << writeMs
+        << " ms, budget " << (memoryBudget >> 10) << " KB, " << spawnBudget << " instances spawned per frame at most" << std::endl;
+
+    // From one corner of the world towards the opposite one, in real time so the loader can keep up
+    EntityStore store;
+    std::vector<std::vector<Entity>> entities(streamer.ChunkCount());
+    std::vector<uint32_t> evicted;
+    const glm::vec3 velocity = glm::normalize(glm::vec3(1.0f, 0.0f, 1.0f)) * SPEED;
+    glm::vec3 position(-info.halfSize * 0.9f, 3.0f, -info.halfSize * 0.9f);
+    double totalMs = 0.0, worstMs = 0.0;
+    size_t peakBytes = 0, peakEntities = 0;
+    for (int frame = 0; frame < FRAMES; ++frame)
+    {
+        const BenchmarkClock::time_point frameStart = BenchmarkClock::now();
+        start = frameStart;
+        evicted.clear();
+        streamer.Update(position, velocity, evicted);
+        for (uint32_t chunk : evicted)
+        {
+            for (Entity entity : entities[chunk])
+                store.Destroy(entity);
+            entities[chunk].clear();
+        }
+
+        size_t spawned = 0;
+        ChunkStreamer::LoadedChunk loaded;
+        while (spawned < spawnBudget && streamer.TakeLoaded(loaded))
+        {
+            SpawnStressScene(store, prototypes, loaded.data.instances.data(), loaded.data.instances.size(),
+                loaded.data.lights.data(), loaded.data.lights.size(), &entities[loaded.chunk]);
+            spawned += loaded.data.instances.size();
+        }
+        const double frameMs = ElapsedMs(start);
+        totalMs += frameMs;
+        worstMs = std::max(worstMs, frameMs);
+        peakBytes = std::max(peakBytes, streamer.GetStats().residentBytes);
+        peakEntities = std::max(peakEntities, store.EntityCount());
+
+        position = position + velocity * FRAME_TIME;
+        std::this_thread::sleep_until(frameStart + std::chrono::microseconds(16667));
+    }
+
+    const ChunkStreamer::Stats stats = streamer.GetStats();
+    std::cout << "    per frame: average " << totalMs / FRAMES << " ms, worst " << worstMs << " ms"
+        << " | " << stats.loadedChunks << " chunks loaded, " << stats.evictedChunks << " evicted, latency average "
+        << stats.averageLatencyMs << " ms, worst " << stats.maxLatencyMs << " ms"
+        << " | peak " << (peakBytes >> 10) << " KB resident, " << peakEntities << " entities" << std::endl;
+
+    streamer.Close();
+    std::remove(path);
+}
+
+#endif